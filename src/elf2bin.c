@@ -21,123 +21,2807 @@
   Write the section content to a binary file, similar to
     objcopy -O binary input.elf output.bin
   
+  or to an Intel HEX or Motorola S-record file, similar to
+    objcopy -O ihex input.elf output.hex
+    objcopy -O srec input.elf output.s19
+  
+*/
+
+#if defined(__linux__)
+#define _GNU_SOURCE             // copy_file_range(), fallocate()
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <libelf.h>
+#include <gelf.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <errno.h>
+#include <zstd.h>
+
+#if !defined(__MINGW32__) && !defined(__MINGW64__)
+#include <sys/mman.h>
+#define ELF2BIN_MMAP
+#endif
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define ELF2BIN_COPY_FILE_RANGE
+#endif
+#endif
+
+/*==========================================*/
+/* Target System Special Code */
+
+#if defined(__MINGW32__) || defined(__MINGW64__)
+// seems to be missing on mingw
+unsigned long __stack_chk_guard = 0xaa55;
+void __attribute__ ((noreturn)) __stack_chk_fail (void)
+{
+	exit(0);
+}
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*==========================================*/
+
+
+/*==========================================*/
+/* Configuration */
+
+int elf2bin_is_base_addr = 0;                   // 1: elf2bin_base_addr is the start of the binary file (option "-b")
+unsigned long long elf2bin_base_addr = 0;
+unsigned long long elf2bin_gap_max = 0x10000;   // a larger gap between two blocks starts a new binary file (option "-g")
+int elf2bin_thread_cnt = 4;                     // number of threads for binary, delta and e2bz output (option "-j")
+int elf2bin_is_digest = 0;                      // 1: output crc32 and sha256 of each binary file and of the image (option "-s")
+int elf2bin_is_gap_fill = 0;                    // 1: write elf2bin_gap_fill into the gaps of a binary file (option "-f")
+int elf2bin_gap_fill = 0;
+const char *elf2bin_crc_symbol = NULL;          // store the crc32 at the address of this symbol (option "-c")
+int elf2bin_is_mmap = 0;                        // 1: assemble the binary file in a memory mapping of the file (option "-m")
+const char *elf2bin_delta_old = NULL;           // previous binary file, write a delta to <binary file>.delta (option "-d")
+int elf2bin_is_delta_zstd = 0;                  // 1: compress the literals of the delta with zstd (option "-z")
+int elf2bin_is_extract = 0;                     // 1: the input is an e2bz container, write its regions as binary files (option "-x")
+const char *elf2bin_apply_old = NULL;           // previous binary file, the input is a delta, write the new binary file (option "-a")
+
+/* elf file, mapped into memory by elf2bin() if elf2bin_is_mmap is set, otherwise NULL */
+const unsigned char *elf2bin_in_map = NULL;
+size_t elf2bin_in_map_size = 0;
+
+/*==========================================*/
+/* Checksums */
+
+/* CRC32 from https://datatracker.ietf.org/doc/html/rfc1952#section-8, same as update_crc() in relf.c */
+unsigned long elf2bin_crc_table[256];
+
+void elf2bin_init_crc_table(void)
+{
+  unsigned long c;
+  int n, k;
+  for (n = 0; n < 256; n++) 
+  {
+    c = (unsigned long) n;
+    for (k = 0; k < 8; k++) 
+      c = (c & 1) ? 0xedb88320L ^ (c >> 1) : c >> 1;
+    elf2bin_crc_table[n] = c;
+  }
+}
+
+/* update a running crc (initial value 0) with len bytes, elf2bin_init_crc_table() must be called before */
+unsigned long elf2bin_update_crc(unsigned long crc, const unsigned char *buf, size_t len)
+{
+  unsigned long c = crc ^ 0xffffffffL;
+  size_t n;
+  for (n = 0; n < len; n++) 
+    c = elf2bin_crc_table[(c ^ buf[n]) & 0xff] ^ (c >> 8);
+  return c ^ 0xffffffffL;
+}
+
+/* SHA-256, see FIPS 180-4 */
+struct _elf2bin_sha256_struct
+{
+  uint32_t h[8];
+  unsigned long long len;       // number of bytes
+  unsigned char buf[64];        // incomplete block, len % 64 bytes are used
+};
+typedef struct _elf2bin_sha256_struct elf2bin_sha256_struct;
+
+static const uint32_t elf2bin_sha256_k[64] = 
+{
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ELF2BIN_ROR(x, n) (((x) >> (n)) | ((x) << (32-(n))))
+
+void elf2bin_sha256_init(elf2bin_sha256_struct *sha)
+{
+  static const uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+  memcpy(sha->h, h, sizeof(h));
+  sha->len = 0;
+}
+
+void elf2bin_sha256_block(elf2bin_sha256_struct *sha, const unsigned char *p)
+{
+  uint32_t w[64];
+  uint32_t a, b, c, d, e, f, g, h, t1, t2;
+  int i;
+  
+  for( i = 0; i < 16; i++ )
+    w[i] = ((uint32_t)p[4*i] << 24) | ((uint32_t)p[4*i+1] << 16) | ((uint32_t)p[4*i+2] << 8) | (uint32_t)p[4*i+3];
+  for( i = 16; i < 64; i++ )
+    w[i] = w[i-16] + (ELF2BIN_ROR(w[i-15], 7) ^ ELF2BIN_ROR(w[i-15], 18) ^ (w[i-15] >> 3))
+      + w[i-7] + (ELF2BIN_ROR(w[i-2], 17) ^ ELF2BIN_ROR(w[i-2], 19) ^ (w[i-2] >> 10));
+  a = sha->h[0]; b = sha->h[1]; c = sha->h[2]; d = sha->h[3];
+  e = sha->h[4]; f = sha->h[5]; g = sha->h[6]; h = sha->h[7];
+  for( i = 0; i < 64; i++ )
+  {
+    t1 = h + (ELF2BIN_ROR(e, 6) ^ ELF2BIN_ROR(e, 11) ^ ELF2BIN_ROR(e, 25)) + ((e & f) ^ (~e & g)) + elf2bin_sha256_k[i] + w[i];
+    t2 = (ELF2BIN_ROR(a, 2) ^ ELF2BIN_ROR(a, 13) ^ ELF2BIN_ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  sha->h[0] += a; sha->h[1] += b; sha->h[2] += c; sha->h[3] += d;
+  sha->h[4] += e; sha->h[5] += f; sha->h[6] += g; sha->h[7] += h;
+}
+
+void elf2bin_sha256_update(elf2bin_sha256_struct *sha, const unsigned char *p, size_t len)
+{
+  size_t used = sha->len % 64;
+  size_t n;
+  
+  sha->len += len;
+  if ( used > 0 )
+  {
+    n = 64 - used < len ? 64 - used : len;
+    memcpy(sha->buf + used, p, n);
+    p += n;
+    len -= n;
+    if ( used + n < 64 )
+      return;
+    elf2bin_sha256_block(sha, sha->buf);
+  }
+  while( len >= 64 )
+  {
+    elf2bin_sha256_block(sha, p);
+    p += 64;
+    len -= 64;
+  }
+  memcpy(sha->buf, p, len);
+}
+
+/* write the digest as 64 hex digits to s (65 bytes including the terminating 0), sha is not changed */
+void elf2bin_sha256_get_hex(const elf2bin_sha256_struct *sha, char *s)
+{
+  elf2bin_sha256_struct tmp = *sha;
+  unsigned char pad[72];
+  size_t pad_len;
+  int i;
+  
+  pad_len = 64 - (sha->len + 8) % 64;         // 1 ... 64 bytes 0x80 0x00 ... before the 8 byte bit length
+  memset(pad, 0, sizeof(pad));
+  pad[0] = 0x80;
+  for( i = 0; i < 8; i++ )
+    pad[pad_len + i] = (unsigned char)((sha->len * 8) >> (56 - 8*i));
+  elf2bin_sha256_update(&tmp, pad, pad_len + 8);
+  for( i = 0; i < 32; i++ )
+    sprintf(s + 2*i, "%02x", (unsigned)((tmp.h[i/4] >> (24 - 8*(i%4))) & 255));
+}
+
+/*
+  Checksums of the binary output, calculated while the binary files are written.
+  If elf2bin_crc_symbol is set, then the crc32 of all bytes from the start of the binary file 
+  up to the address of the symbol is stored (4 bytes, byte order of the elf file) at the symbol address.
+*/
+struct _elf2bin_digest_struct
+{
+  unsigned long crc;                    // current binary file
+  elf2bin_sha256_struct sha;
+  unsigned long image_crc;              // all binary files
+  elf2bin_sha256_struct image_sha;
+  int is_crc_addr;                      // 1: crc_addr is the load address of elf2bin_crc_symbol
+  int is_msb;                           // byte order of the stored crc
+  unsigned long long crc_addr;
+  int is_crc_stored;                    // 1: crc_value is calculated and must be written to crc_addr
+  unsigned long stored_crc;
+  unsigned char crc_value[4];
+};
+typedef struct _elf2bin_digest_struct elf2bin_digest_struct;
+
+void elf2bin_digest_add(elf2bin_digest_struct *d, const unsigned char *ptr, size_t len)
+{
+  d->crc = elf2bin_update_crc(d->crc, ptr, len);
+  d->image_crc = elf2bin_update_crc(d->image_crc, ptr, len);
+  if ( elf2bin_is_digest )
+  {
+    elf2bin_sha256_update(&(d->sha), ptr, len);
+    elf2bin_sha256_update(&(d->image_sha), ptr, len);
+  }
+}
+
+/* add len bytes, which are written to the binary file at address addr, the stored crc replaces the original bytes */
+void elf2bin_digest_update(elf2bin_digest_struct *d, unsigned long long addr, const unsigned char *ptr, size_t len)
+{
+  unsigned char tmp[4];
+  size_t i, n;
+  
+  if ( d->is_crc_addr && addr < d->crc_addr + 4 && addr + len > d->crc_addr )
+  {
+    if ( addr < d->crc_addr )
+    {
+      n = d->crc_addr - addr;
+      elf2bin_digest_add(d, ptr, n);
+      addr += n; ptr += n; len -= n;
+    }
+    if ( d->is_crc_stored == 0 && addr == d->crc_addr )
+    {
+      for( i = 0; i < 4; i++ )
+        d->crc_value[i] = (d->crc >> (d->is_msb ? 24 - 8*i : 8*i)) & 255;
+      d->stored_crc = d->crc;
+      d->is_crc_stored = 1;
+    }
+    n = d->crc_addr + 4 - addr;
+    if ( n > len )
+      n = len;
+    for( i = 0; i < n; i++ )
+      tmp[i] = d->crc_value[addr - d->crc_addr + i];
+    elf2bin_digest_add(d, tmp, n);
+    addr += n; ptr += n; len -= n;
+  }
+  elf2bin_digest_add(d, ptr, len);
+}
+
+/*==========================================*/
+/* Data Blocks */
+
+/* content of one data block of a SHF_ALLOC section */
+struct _elf2bin_block_struct
+{
+  unsigned long long addr;      // load address (LMA) in the target system
+  const unsigned char *ptr;     // data, owned by libelf, NULL if the block is copied from the elf file (see offset)
+  size_t size;
+  size_t offset;                // offset of the unchanged data in the elf file, only valid if ptr is NULL
+  const char *name;             // section name, owned by libelf
+};
+typedef struct _elf2bin_block_struct elf2bin_block_struct;
+
+int elf2bin_cmp_block(const void *a, const void *b)
+{
+  const elf2bin_block_struct *x = (const elf2bin_block_struct *)a;
+  const elf2bin_block_struct *y = (const elf2bin_block_struct *)b;
+  if ( x->addr != y->addr )
+    return x->addr < y->addr ? -1 : 1;
+  return 0;
+}
+
+/* read size bytes at the given offset of a file, returns 0 if the bytes are not available */
+int elf2bin_pread(int fd, void *buf, size_t size, size_t offset)
+{
+  ssize_t cnt;
+  while( size > 0 )
+  {
+#if defined(__MINGW32__) || defined(__MINGW64__)
+    if ( lseek(fd, (off_t)offset, SEEK_SET) < 0 )
+      return 0;
+    cnt = read(fd, buf, size);
+#else
+    cnt = pread(fd, buf, size, (off_t)offset);
+#endif
+    if ( cnt <= 0 )
+      return 0;
+    buf = (char *)buf + cnt;
+    size -= cnt;
+    offset += cnt;
+  }
+  return 1;
+}
+
+/* append a block to the list, returns 0 if there is not enough memory */
+int elf2bin_add_block(elf2bin_block_struct **list, size_t *cnt, size_t *max, elf2bin_block_struct *block)
+{
+  elf2bin_block_struct *new_list;
+  if ( *cnt >= *max )
+  {
+    new_list = (elf2bin_block_struct *)realloc(*list, (*max*2 + 16)*sizeof(elf2bin_block_struct));
+    if ( new_list == NULL )
+      return fprintf(stderr, "elf2bin: out of memory\n"), 0;
+    *list = new_list;
+    *max = *max*2 + 16;
+  }
+  (*list)[*cnt] = *block;
+  (*cnt)++;
+  return 1;
+}
+
+/*
+  Returns the load address (LMA) of a section: If the section is part of a PT_LOAD segment,
+  then the load address is derived from p_paddr of the segment (for example .data, which is
+  executed in RAM, but stored in flash memory). Otherwise this is the same as sh_addr.
+*/
+unsigned long long elf2bin_get_lma(Elf *elf, GElf_Shdr *shdr)
+{
+  GElf_Phdr phdr;
+  size_t i, phnum;
+  
+  if ( elf_getphdrnum(elf, &phnum) != 0 )
+    return shdr->sh_addr;
+  for( i = 0; i < phnum; i++ )
+  {
+    if ( gelf_getphdr(elf, i, &phdr) == NULL || phdr.p_type != PT_LOAD )
+      continue;
+    if ( shdr->sh_addr < phdr.p_vaddr || shdr->sh_addr + shdr->sh_size > phdr.p_vaddr + phdr.p_memsz )
+      continue;
+    if ( shdr->sh_offset < phdr.p_offset || shdr->sh_offset + shdr->sh_size > phdr.p_offset + phdr.p_filesz )
+      continue;
+    return phdr.p_paddr + shdr->sh_addr - phdr.p_vaddr;
+  }
+  return shdr->sh_addr;
+}
+
+/*
+  Find the symbol with the given name in the symbol tables and return its load address in *lma.
+  Returns 0 if the symbol doesn't exist or isn't part of a section.
+*/
+int elf2bin_get_symbol_lma(Elf *elf, const char *name, unsigned long long *lma)
+{
+  Elf_Scn *scn = NULL;
+  Elf_Scn *sym_scn;
+  GElf_Shdr shdr, sym_shdr;
+  Elf_Data *data;
+  GElf_Sym sym;
+  const char *s;
+  size_t i, cnt;
+  
+  while (( scn = elf_nextscn(elf, scn)) != NULL ) 
+  {
+    if ( gelf_getshdr( scn, &shdr ) != &shdr )
+      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
+    if ( (shdr.sh_type != SHT_SYMTAB && shdr.sh_type != SHT_DYNSYM) || shdr.sh_entsize == 0 )
+      continue;
+    data = elf_getdata(scn, NULL);
+    if ( data == NULL )
+      continue;
+    cnt = shdr.sh_size / shdr.sh_entsize;
+    for( i = 1; i < cnt; i++ )
+    {
+      if ( gelf_getsym(data, i, &sym) != &sym )
+        break;
+      s = elf_strptr(elf, shdr.sh_link, sym.st_name);
+      if ( s == NULL || strcmp(s, name) != 0 )
+        continue;
+      if ( sym.st_shndx == SHN_UNDEF || sym.st_shndx >= SHN_LORESERVE )
+        continue;
+      sym_scn = elf_getscn(elf, sym.st_shndx);
+      if ( sym_scn == NULL || gelf_getshdr(sym_scn, &sym_shdr) != &sym_shdr )
+        continue;
+      if ( sym.st_size != 0 && sym.st_size < 4 )
+        return fprintf(stderr, "elf2bin: symbol %s has only %lu bytes\n", name, (unsigned long)sym.st_size), 0;
+      *lma = elf2bin_get_lma(elf, &sym_shdr) + sym.st_value - sym_shdr.sh_addr;
+      return 1;
+    }
+  }
+  return fprintf(stderr, "elf2bin: symbol %s not found\n", name), 0;
+}
+
+/*
+  Collect the data blocks of all none-empty sections with SHF_ALLOC flag, sorted by load address.
+  Address, size and the first 16 bytes of each block are written to stdout.
+  If is_copy is not 0, then SHT_PROGBITS sections are not read by libelf. Instead the 
+  block refers to the unchanged data in the elf file (fd), which is copied by elf2bin_copy_block().
+  Returns a malloc'd list or NULL, *cnt is the number of blocks.
+*/
+elf2bin_block_struct *elf2bin_get_block_list(Elf *elf, int fd, int is_copy, size_t *cnt)
+{
+  Elf_Scn  *scn  = NULL;
+  GElf_Shdr shdr;
+  Elf_Data *data;
+  elf2bin_block_struct *list = NULL;
+  elf2bin_block_struct block;
+  unsigned char start[16];
+  unsigned long long lma;
+  size_t max = 0;
+  size_t i, len, shstrndx;
+  
+  *cnt = 0;
+  if ( elf_getshdrstrndx(elf, &shstrndx) != 0 )
+    return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
+  printf("address   size      starting values...\n");
+  
+  /* loop over all sections */
+  while (( scn = elf_nextscn(elf, scn)) != NULL ) 
+  {
+    if ( gelf_getshdr( scn, &shdr ) != &shdr )
+      return free(list), fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
+    if ( (shdr.sh_flags & SHF_ALLOC) == 0 || shdr.sh_size == 0 )
+      continue;
+    lma = elf2bin_get_lma(elf, &shdr);
+    block.name = elf_strptr(elf, shstrndx, shdr.sh_name);
+    if ( block.name == NULL )
+      block.name = "";
+    
+    /* SHT_PROGBITS: libelf doesn't change the data, so it can be copied from the elf file */
+    if ( is_copy && shdr.sh_type == SHT_PROGBITS && (shdr.sh_flags & SHF_COMPRESSED) == 0 )
+    {
+      len = shdr.sh_size > 16 ? 16 : shdr.sh_size;
+      if ( elf2bin_pread(fd, start, len, shdr.sh_offset) != 0 )
+      {
+        block.addr = lma;
+        block.ptr = NULL;
+        block.size = shdr.sh_size;
+        block.offset = shdr.sh_offset;
+        if ( elf2bin_add_block(&list, cnt, &max, &block) == 0 )
+          return free(list), NULL;
+        printf("%08lx: %08lx ", (unsigned long)block.addr, (unsigned long)block.size);
+        for( i = 0; i < len; i++ )
+          printf(" %02x", start[i]);
+        printf("\n");
+        continue;
+      }
+    }
+    
+    /* loop over the data blocks of the section */
+    data = NULL;
+    for(;;)
+    {
+      data = elf_getdata(scn , data);     // if data==NULL return first data, otherwise return next data
+      if ( data == NULL )
+        break;
+      if ( data->d_buf == NULL )
+        break;
+      block.addr = lma + data->d_off;
+      block.ptr = (const unsigned char *)data->d_buf;
+      block.size = data->d_size;
+      block.offset = 0;
+      if ( elf2bin_add_block(&list, cnt, &max, &block) == 0 )
+        return free(list), NULL;
+      
+      /* output address, size and the first 16 data values of the block to stdout */
+      printf("%08lx: %08lx ", (unsigned long)block.addr, (unsigned long)data->d_size);
+      len = data->d_size > 16 ? 16 : data->d_size;
+      for( i = 0; i < len; i++ )
+        printf(" %02x", block.ptr[i]);
+      printf("\n");
+    }
+  }
+  if ( *cnt > 0 )
+    qsort(list, *cnt, sizeof(elf2bin_block_struct), elf2bin_cmp_block);
+  if ( list == NULL )
+    list = (elf2bin_block_struct *)malloc(sizeof(elf2bin_block_struct));
+  return list;
+}
+
+/* 
+  Blocks are written in any order (and in parallel), so overlapping blocks would lead to an 
+  undefined output. Returns 0 and reports the sections, if two blocks of the sorted list overlap.
+*/
+int elf2bin_check_overlap(elf2bin_block_struct *list, size_t cnt)
+{
+  size_t i, prev = 0;
+  int result = 1;
+  for( i = 1; i < cnt; i++ )
+  {
+    if ( list[i].addr < list[prev].addr + list[prev].size )
+    {
+      fprintf(stderr, "elf2bin: section %s (0x%llx-0x%llx) overlaps section %s (0x%llx-0x%llx)\n", 
+        list[i].name, list[i].addr, list[i].addr + list[i].size,
+        list[prev].name, list[prev].addr, list[prev].addr + list[prev].size);
+      result = 0;
+    }
+    if ( list[i].addr + list[i].size > list[prev].addr + list[prev].size )
+      prev = i;
+  }
+  return result;
+}
+
+/*
+  Copy the content of the address range addr ... addr+size-1 into buf: Bytes outside of the blocks are 
+  set to elf2bin_gap_fill, the blocks are taken from libelf or read from the elf file.
+  Only this range is in memory, so a large image can be processed in parts.
+*/
+int elf2bin_get_image(int in_fd, elf2bin_block_struct *list, size_t cnt, unsigned long long addr, unsigned char *buf, size_t size)
+{
+  unsigned long long start, end;
+  size_t lo = 0, hi = cnt, mid;
+  
+  memset(buf, elf2bin_gap_fill, size);
+  /* first block, which ends after addr (the list is sorted by address and the blocks don't overlap) */
+  while( lo < hi )
+  {
+    mid = (lo + hi) / 2;
+    if ( list[mid].addr + list[mid].size <= addr )
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  for( ; lo < cnt && list[lo].addr < addr + size; lo++ )
+  {
+    start = list[lo].addr > addr ? list[lo].addr : addr;
+    end = list[lo].addr + list[lo].size < addr + size ? list[lo].addr + list[lo].size : addr + size;
+    if ( start >= end )
+      continue;
+    if ( list[lo].ptr != NULL )
+      memcpy(buf + (start - addr), list[lo].ptr + (start - list[lo].addr), end - start);
+    else if ( elf2bin_pread(in_fd, buf + (start - addr), end - start, list[lo].offset + (start - list[lo].addr)) == 0 )
+      return fprintf(stderr, "elf2bin: read error at offset 0x%lx\n", (unsigned long)(list[lo].offset + (start - list[lo].addr))), 0;
+  }
+  return 1;
+}
+
+/*==========================================*/
+/* Buffered Output */
+
+#define ELF2BIN_OUT_BUF_SIZE (256*1024)
+#define ELF2BIN_RECORD_MAX 1024         // max number of chars of one hex record
+
+struct _elf2bin_out_struct
+{
+  int fd;
+  size_t len;
+  int is_error;
+  char buf[ELF2BIN_OUT_BUF_SIZE];
+};
+typedef struct _elf2bin_out_struct elf2bin_out_struct;
+
+/* two hex digits for each byte value, filled by elf2bin_init_hex_table() */
+char elf2bin_hex_table[512];
+
+void elf2bin_init_hex_table(void)
+{
+  static const char digit[] = "0123456789ABCDEF";
+  int i;
+  for( i = 0; i < 256; i++ )
+  {
+    elf2bin_hex_table[2*i] = digit[i >> 4];
+    elf2bin_hex_table[2*i+1] = digit[i & 15];
+  }
+}
+
+int elf2bin_out_flush(elf2bin_out_struct *out)
+{
+  size_t pos = 0;
+  ssize_t cnt;
+  while( pos < out->len && out->is_error == 0 )
+  {
+    cnt = write(out->fd, out->buf + pos, out->len - pos);
+    if ( cnt <= 0 )
+      out->is_error = 1;
+    else
+      pos += cnt;
+  }
+  out->len = 0;
+  return out->is_error == 0;
+}
+
+/*
+  Append one record: prefix, the hex digits of head and data and the checksum.
+  The checksum is the 2's complement (Intel HEX) or 1's complement (S-record, is_srec != 0) of the byte sum.
+  head contains count, address and type bytes of the record.
+*/
+void elf2bin_out_record(elf2bin_out_struct *out, const char *prefix, const unsigned char *head, size_t head_len, const unsigned char *data, size_t data_len, int is_srec)
+{
+  unsigned sum = 0;
+  char *p;
+  size_t i;
+  
+  if ( out->len + ELF2BIN_RECORD_MAX > ELF2BIN_OUT_BUF_SIZE )
+    elf2bin_out_flush(out);
+  p = out->buf + out->len;
+  while( *prefix != '\0' )
+    *p++ = *prefix++;
+  for( i = 0; i < head_len; i++ )
+  {
+    sum += head[i];
+    memcpy(p, elf2bin_hex_table + 2*head[i], 2);
+    p += 2;
+  }
+  for( i = 0; i < data_len; i++ )
+  {
+    sum += data[i];
+    memcpy(p, elf2bin_hex_table + 2*data[i], 2);
+    p += 2;
+  }
+  sum = is_srec ? ~sum : -sum;
+  memcpy(p, elf2bin_hex_table + 2*(sum & 255), 2);
+  p += 2;
+  *p++ = '\r';
+  *p++ = '\n';
+  out->len = p - out->buf;
+}
+
+/* store the lower n bytes of v in big endian order */
+void elf2bin_put_be(unsigned char *p, unsigned long long v, int n)
+{
+  while( n > 0 )
+  {
+    n--;
+    p[n] = v & 255;
+    v >>= 8;
+  }
+}
+
+/*==========================================*/
+/* Output Formats */
+
+#define ELF2BIN_FORMAT_BINARY 0
+#define ELF2BIN_FORMAT_IHEX 1
+#define ELF2BIN_FORMAT_SREC 2           // S19, S28 or S37, depending on the max address
+#define ELF2BIN_FORMAT_S19 3
+#define ELF2BIN_FORMAT_S28 4
+#define ELF2BIN_FORMAT_S37 5
+#define ELF2BIN_FORMAT_E2BZ 6           // compressed container, see elf2bin_write_e2bz()
+
+/* number of data bytes per Intel HEX or S-record, same as objcopy */
+#define ELF2BIN_RECORD_DATA_SIZE 16
+
+/*
+  Check the address range of Intel HEX and S-records, before the output file is created.
+  ELF2BIN_FORMAT_SREC is replaced by the S-record format for the highest address.
+  returns 0 if an address (or the entry point of S-records) exceeds the address range of the format.
+*/
+int elf2bin_check_record_format(elf2bin_block_struct *list, size_t cnt, unsigned long long entry, int *format)
+{
+  unsigned long long max_addr = 0;
+  size_t i, addr_size;
+  
+  for( i = 0; i < cnt; i++ )
+    if ( list[i].size > 0 && list[i].addr + list[i].size - 1 > max_addr )
+      max_addr = list[i].addr + list[i].size - 1;
+  if ( *format == ELF2BIN_FORMAT_IHEX )
+  {
+    if ( max_addr > 0xffffffffULL )
+      return fprintf(stderr, "elf2bin: address 0x%llx exceeds the 32 bit address range of Intel HEX\n", max_addr), 0;
+    return 1;
+  }
+  if ( entry > max_addr )
+    max_addr = entry;
+  if ( *format == ELF2BIN_FORMAT_SREC )
+    *format = max_addr <= 0xffffULL ? ELF2BIN_FORMAT_S19 : max_addr <= 0xffffffULL ? ELF2BIN_FORMAT_S28 : ELF2BIN_FORMAT_S37;
+  addr_size = *format == ELF2BIN_FORMAT_S19 ? 2 : *format == ELF2BIN_FORMAT_S28 ? 3 : 4;
+  if ( max_addr >= (1ULL << (addr_size*8)) )
+    return fprintf(stderr, "elf2bin: address 0x%llx exceeds the %d bit address range of S%d records\n", max_addr, (int)addr_size*8, (int)addr_size-1), 0;
+  return 1;
+}
+
+/*
+  Intel HEX: data records (type 00) with extended linear address records (type 04),
+  a start segment (type 03, entry point below 1 MB) or start linear address record (type 05) 
+  for the entry point and the end of file record (type 01).
+  A data record never crosses a 64K boundary. The address range is checked by elf2bin_check_record_format().
+*/
+int elf2bin_write_ihex(elf2bin_out_struct *out, elf2bin_block_struct *list, size_t cnt, unsigned long long entry)
+{
+  unsigned char head[4];
+  unsigned char ext[2];
+  unsigned long long addr;
+  unsigned long upper = 0;        // current upper 16 bits of the address
+  size_t i, pos, len;
+  
+  for( i = 0; i < cnt; i++ )
+  {
+    for( pos = 0; pos < list[i].size; pos += len )
+    {
+      addr = list[i].addr + pos;
+      len = list[i].size - pos;
+      if ( len > ELF2BIN_RECORD_DATA_SIZE )
+        len = ELF2BIN_RECORD_DATA_SIZE;
+      if ( (addr & 0xffff) + len > 0x10000 )
+        len = 0x10000 - (addr & 0xffff);
+      if ( (addr >> 16) != upper )
+      {
+        upper = addr >> 16;
+        head[0] = 2; head[1] = 0; head[2] = 0; head[3] = 4;
+        elf2bin_put_be(ext, upper, 2);
+        elf2bin_out_record(out, ":", head, 4, ext, 2, 0);
+      }
+      head[0] = len;
+      elf2bin_put_be(head+1, addr & 0xffff, 2);
+      head[3] = 0;
+      elf2bin_out_record(out, ":", head, 4, list[i].ptr + pos, len, 0);
+    }
+  }
+  if ( entry != 0 && entry <= 0xfffffULL )
+  {
+    /* same as objcopy: entry points below 1 MB are written as CS:IP (type 03) */
+    unsigned char start[4];
+    head[0] = 4; head[1] = 0; head[2] = 0; head[3] = 3;
+    elf2bin_put_be(start, (entry & 0xf0000) >> 4, 2);
+    elf2bin_put_be(start+2, entry & 0xffff, 2);
+    elf2bin_out_record(out, ":", head, 4, start, 4, 0);
+  }
+  else if ( entry != 0 && entry <= 0xffffffffULL )
+  {
+    unsigned char start[4];
+    head[0] = 4; head[1] = 0; head[2] = 0; head[3] = 5;
+    elf2bin_put_be(start, entry, 4);
+    elf2bin_out_record(out, ":", head, 4, start, 4, 0);
+  }
+  head[0] = 0; head[1] = 0; head[2] = 0; head[3] = 1;
+  elf2bin_out_record(out, ":", head, 4, NULL, 0, 0);
+  return 1;
+}
+
+/*
+  Motorola S-record: header record (S0) with the name of the output file,
+  data records with 16 (S1), 24 (S2) or 32 (S3) bit address and the 
+  termination record (S9, S8 or S7) with the entry point.
+  format is ELF2BIN_FORMAT_S19, S28 or S37, see elf2bin_check_record_format().
+*/
+int elf2bin_write_srec(elf2bin_out_struct *out, elf2bin_block_struct *list, size_t cnt, unsigned long long entry, int format, const char *outfile)
+{
+  static const char *data_prefix[] = { "S1", "S2", "S3" };
+  static const char *term_prefix[] = { "S9", "S8", "S7" };
+  unsigned char head[5];
+  size_t addr_size, i, pos, len;
+  
+  addr_size = format == ELF2BIN_FORMAT_S19 ? 2 : format == ELF2BIN_FORMAT_S28 ? 3 : 4;
+  
+  /* header, the name length is limited, so that the record fits into ELF2BIN_RECORD_MAX */
+  len = strlen(outfile);
+  if ( len > 64 )
+    len = 64;
+  head[0] = len + 3;
+  head[1] = 0;
+  head[2] = 0;
+  elf2bin_out_record(out, "S0", head, 3, (const unsigned char *)outfile, len, 1);
+  
+  for( i = 0; i < cnt; i++ )
+  {
+    for( pos = 0; pos < list[i].size; pos += len )
+    {
+      len = list[i].size - pos;
+      if ( len > ELF2BIN_RECORD_DATA_SIZE )
+        len = ELF2BIN_RECORD_DATA_SIZE;
+      head[0] = addr_size + len + 1;
+      elf2bin_put_be(head+1, list[i].addr + pos, addr_size);
+      elf2bin_out_record(out, data_prefix[addr_size-2], head, addr_size+1, list[i].ptr + pos, len, 1);
+    }
+  }
+  head[0] = addr_size + 1;
+  elf2bin_put_be(head+1, entry, addr_size);
+  elf2bin_out_record(out, term_prefix[addr_size-2], head, addr_size+1, NULL, 0, 1);
+  return 1;
+}
+
+/*
+  Copy size bytes from offset in_offset of in_fd to offset out_offset of out_fd.
+  The data is moved by the kernel with copy_file_range() or sendfile(), if available.
+  Otherwise (or if both fail, for example because of different file systems) 
+  the data is copied with read() and write().
+*/
+int elf2bin_copy_block(int in_fd, size_t in_offset, int out_fd, size_t out_offset, size_t size)
+{
+  char buf[64*1024];
+  ssize_t cnt;
+  size_t len;
+  
+#if defined(ELF2BIN_COPY_FILE_RANGE)
+  {
+    loff_t in_off = in_offset;
+    loff_t out_off = out_offset;
+    while( size > 0 )
+    {
+      cnt = copy_file_range(in_fd, &in_off, out_fd, &out_off, size, 0);
+      if ( cnt <= 0 )
+        break;
+      size -= cnt;
+    }
+    in_offset = in_off;
+    out_offset = out_off;
+  }
+#endif
+#if defined(__linux__)
+  if ( size > 0 && lseek(out_fd, out_offset, SEEK_SET) >= 0 )
+  {
+    off_t in_off = in_offset;
+    while( size > 0 )
+    {
+      cnt = sendfile(out_fd, in_fd, &in_off, size);
+      if ( cnt <= 0 )
+        break;
+      size -= cnt;
+      out_offset += cnt;
+    }
+    in_offset = in_off;
+  }
+#endif
+  if ( size > 0 && lseek(out_fd, out_offset, SEEK_SET) < 0 )
+    return perror("elf2bin"), 0;
+  while( size > 0 )
+  {
+    len = size > sizeof(buf) ? sizeof(buf) : size;
+    if ( elf2bin_pread(in_fd, buf, len, in_offset) == 0 )
+      return fprintf(stderr, "elf2bin: read error at offset 0x%lx\n", (unsigned long)in_offset), 0;
+    if ( write(out_fd, buf, len) != (ssize_t)len )
+      return perror("elf2bin"), 0;
+    size -= len;
+    in_offset += len;
+  }
+  return 1;
+}
+
+/* write size bytes to the given offset of a file, returns 0 on error */
+int elf2bin_pwrite(int fd, const void *buf, size_t size, size_t offset)
+{
+  ssize_t cnt;
+  while( size > 0 )
+  {
+#if defined(__MINGW32__) || defined(__MINGW64__)
+    if ( lseek(fd, (off_t)offset, SEEK_SET) < 0 )
+      return 0;
+    cnt = write(fd, buf, size);
+#else
+    cnt = pwrite(fd, buf, size, (off_t)offset);
+#endif
+    if ( cnt <= 0 )
+      return 0;
+    buf = (const char *)buf + cnt;
+    size -= cnt;
+    offset += cnt;
+  }
+  return 1;
+}
+
+/*==========================================*/
+/* Parallel Binary Output */
+
+/* blocks are split into pieces of this size, so that also a single large block is written in parallel */
+#define ELF2BIN_PIECE_SIZE (4*1024*1024)
+
+/* shared state of the threads, which write the blocks of one binary file */
+struct _elf2bin_writer_struct
+{
+  pthread_mutex_t mutex;
+  int in_fd;
+  const char *outfile;
+  elf2bin_block_struct *list;
+  size_t cnt;
+  unsigned long long base;      // load address of the first byte of the file
+  size_t next_block;            // next piece to write: block index and position within the block
+  size_t next_pos;
+  int is_error;
+};
+typedef struct _elf2bin_writer_struct elf2bin_writer_struct;
+
+/* get the next piece, which has to be written, returns 0 if all pieces are done or an error occured */
+int elf2bin_get_piece(elf2bin_writer_struct *w, size_t *block, size_t *pos, size_t *len)
+{
+  int result = 0;
+  pthread_mutex_lock(&(w->mutex));
+  if ( w->next_block < w->cnt && w->is_error == 0 )
+  {
+    *block = w->next_block;
+    *pos = w->next_pos;
+    *len = w->list[*block].size - *pos;
+    if ( *len > ELF2BIN_PIECE_SIZE )
+      *len = ELF2BIN_PIECE_SIZE;
+    w->next_pos += *len;
+    if ( w->next_pos >= w->list[*block].size )
+    {
+      w->next_block++;
+      w->next_pos = 0;
+    }
+    result = 1;
+  }
+  pthread_mutex_unlock(&(w->mutex));
+  return result;
+}
+
+/*
+  Thread procedure: Each thread uses its own file descriptor for the output file, so that the
+  file position, which is used by the sendfile() and the mingw fallback, isn't shared.
+*/
+void *elf2bin_writer_thread(void *arg)
+{
+  elf2bin_writer_struct *w = (elf2bin_writer_struct *)arg;
+  elf2bin_block_struct *b;
+  size_t block, pos, len;
+  int is_ok = 1;
+  int fd;
+  
+  fd = open(w->outfile, O_WRONLY | O_BINARY);
+  if ( fd < 0 )
+  {
+    perror(w->outfile);
+    is_ok = 0;
+  }
+  while( is_ok && elf2bin_get_piece(w, &block, &pos, &len) )
+  {
+    b = w->list + block;
+    if ( b->ptr == NULL )
+      is_ok = elf2bin_copy_block(w->in_fd, b->offset + pos, fd, b->addr - w->base + pos, len);
+    else if ( elf2bin_pwrite(fd, b->ptr + pos, len, b->addr - w->base + pos) == 0 )
+      is_ok = (perror(w->outfile), 0);
+  }
+  if ( fd >= 0 && close(fd) != 0 )
+    is_ok = (perror(w->outfile), 0);
+  if ( is_ok == 0 )
+  {
+    pthread_mutex_lock(&(w->mutex));
+    w->is_error = 1;
+    pthread_mutex_unlock(&(w->mutex));
+  }
+  return NULL;
+}
+
+/* write the checksums of a binary file and the stored crc (if is_crc_new is not 0) to stdout */
+void elf2bin_show_digest(const char *outfile, elf2bin_digest_struct *d, int is_crc_new)
+{
+  char sha[65];
+  if ( is_crc_new )
+    printf("%s: %08llx: crc32 %08lx\n", elf2bin_crc_symbol, d->crc_addr, d->stored_crc);
+  if ( elf2bin_is_digest )
+  {
+    elf2bin_sha256_get_hex(&(d->sha), sha);
+    printf("%s: crc32 %08lx sha256 %s\n", outfile, d->crc, sha);
+  }
+}
+
+/*
+  Calculate the checksums of a binary file in address order, while the blocks are written by the other threads.
+  The data is taken from libelf or read from the elf file, so the binary file is never read again.
+  Gaps are filled with elf2bin_gap_fill (option "-f"), otherwise the gaps contain zero bytes.
+*/
+void elf2bin_digest_binary(elf2bin_writer_struct *w, elf2bin_digest_struct *d)
+{
+  unsigned char buf[64*1024];
+  unsigned long long addr = w->base;
+  size_t i, pos, len;
+  int is_ok = 1;
+  int fd = -1;
+  
+  if ( elf2bin_is_gap_fill )
+  {
+    fd = open(w->outfile, O_WRONLY | O_BINARY);
+    if ( fd < 0 )
+    {
+      perror(w->outfile);
+      is_ok = 0;
+    }
+  }
+  for( i = 0; i < w->cnt && is_ok; i++ )
+  {
+    /* gap before the block */
+    memset(buf, elf2bin_gap_fill, sizeof(buf));
+    while( addr < w->list[i].addr )
+    {
+      len = w->list[i].addr - addr > sizeof(buf) ? sizeof(buf) : w->list[i].addr - addr;
+      if ( fd >= 0 && elf2bin_pwrite(fd, buf, len, addr - w->base) == 0 )
+      {
+        perror(w->outfile);
+        is_ok = 0;
+        break;
+      }
+      elf2bin_digest_update(d, addr, buf, len);
+      addr += len;
+    }
+    
+    /* content of the block */
+    if ( w->list[i].ptr != NULL )
+      elf2bin_digest_update(d, addr, w->list[i].ptr, w->list[i].size);
+    else
+    {
+      for( pos = 0; pos < w->list[i].size; pos += len )
+      {
+        len = w->list[i].size - pos > sizeof(buf) ? sizeof(buf) : w->list[i].size - pos;
+        if ( elf2bin_pread(w->in_fd, buf, len, w->list[i].offset + pos) == 0 )
+        {
+          fprintf(stderr, "elf2bin: read error at offset 0x%lx\n", (unsigned long)(w->list[i].offset + pos));
+          is_ok = 0;
+          break;
+        }
+        elf2bin_digest_update(d, addr + pos, buf, len);
+      }
+    }
+    addr = w->list[i].addr + w->list[i].size;
+  }
+  if ( fd >= 0 && close(fd) != 0 )
+  {
+    perror(w->outfile);
+    is_ok = 0;
+  }
+  if ( is_ok == 0 )
+  {
+    pthread_mutex_lock(&(w->mutex));
+    w->is_error = 1;
+    pthread_mutex_unlock(&(w->mutex));
+  }
+}
+
+/*
+  Binary file: each block is written to the file offset addr - base. The blocks of the file are preallocated
+  and the (none-overlapping) blocks are written with positional writes by up to elf2bin_thread_cnt threads.
+  If d is not NULL, then the checksums are calculated by the calling thread, see elf2bin_digest_binary().
+*/
+int elf2bin_write_binary(int in_fd, const char *outfile, elf2bin_block_struct *list, size_t cnt, unsigned long long base, elf2bin_digest_struct *d)
+{
+  elf2bin_writer_struct w;
+  pthread_t *threads;
+  size_t i, n, piece_cnt = 0;
+  int is_crc_stored = d != NULL ? d->is_crc_stored : 0;
+  int fd;
+  
+  for( i = 0; i < cnt; i++ )
+    piece_cnt += (list[i].size + ELF2BIN_PIECE_SIZE - 1) / ELF2BIN_PIECE_SIZE;
+  n = elf2bin_thread_cnt > 1 ? (size_t)elf2bin_thread_cnt : 1;
+  if ( n > piece_cnt )
+    n = piece_cnt;
+  
+  w.in_fd = in_fd;
+  w.outfile = outfile;
+  w.list = list;
+  w.cnt = cnt;
+  w.base = base;
+  w.next_block = 0;
+  w.next_pos = 0;
+  w.is_error = 0;
+  pthread_mutex_init(&(w.mutex), NULL);
+  if ( n <= 1 )
+  {
+    if ( cnt > 0 )
+      elf2bin_writer_thread(&w);
+    if ( d != NULL && w.is_error == 0 )
+      elf2bin_digest_binary(&w, d);
+  }
+  else
+  {
+    threads = (pthread_t *)malloc(n*sizeof(pthread_t));
+    if ( threads == NULL )
+      return pthread_mutex_destroy(&(w.mutex)), fprintf(stderr, "elf2bin: out of memory\n"), 0;
+    for( i = 0; i < n; i++ )
+      if ( pthread_create(threads+i, NULL, elf2bin_writer_thread, &w) != 0 )
+        break;
+    if ( i == 0 )
+      elf2bin_writer_thread(&w);         // no thread available, write all blocks here
+    if ( d != NULL )
+      elf2bin_digest_binary(&w, d);
+    while( i > 0 )
+      pthread_join(threads[--i], NULL);
+    free(threads);
+  }
+  pthread_mutex_destroy(&(w.mutex));
+  if ( w.is_error != 0 || d == NULL )
+    return w.is_error == 0;
+  
+  /* the crc overwrites the data of the symbol, so it is written after all blocks */
+  if ( is_crc_stored == 0 && d->is_crc_stored != 0 )
+  {
+    fd = open(outfile, O_WRONLY | O_BINARY);
+    if ( fd < 0 )
+      return perror(outfile), 0;
+    if ( elf2bin_pwrite(fd, d->crc_value, 4, d->crc_addr - base) == 0 )
+      return perror(outfile), close(fd), 0;
+    if ( close(fd) != 0 )
+      return perror(outfile), 0;
+  }
+  elf2bin_show_digest(outfile, d, is_crc_stored == 0 && d->is_crc_stored != 0);
+  return 1;
+}
+
+#if defined(ELF2BIN_MMAP)
+/*
+  Binary file, assembled in a memory mapping of the file (option "-m"): The blocks are copied 
+  from libelf or from the mapped elf file and the gaps are filled with memset(). There are no 
+  system calls for the single blocks, the kernel writes back the mapping after munmap().
+  fd must be opened for reading and writing and size is the size of the file.
+*/
+int elf2bin_write_binary_mmap(int in_fd, int fd, const char *outfile, elf2bin_block_struct *list, size_t cnt, unsigned long long base, size_t size, elf2bin_digest_struct *d)
+{
+  unsigned char *map;
+  unsigned long long addr = base;
+  int is_crc_stored = d != NULL ? d->is_crc_stored : 0;
+  int result = 1;
+  size_t i;
+  
+  if ( size == 0 )
+    return 1;
+  map = (unsigned char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if ( map == MAP_FAILED )
+    return perror(outfile), 0;
+  for( i = 0; i < cnt; i++ )
+  {
+    if ( elf2bin_is_gap_fill && addr < list[i].addr )
+      memset(map + (addr - base), elf2bin_gap_fill, list[i].addr - addr);
+    if ( list[i].ptr != NULL )
+      memcpy(map + (list[i].addr - base), list[i].ptr, list[i].size);
+    else if ( elf2bin_in_map != NULL && list[i].offset + list[i].size <= elf2bin_in_map_size )
+      memcpy(map + (list[i].addr - base), elf2bin_in_map + list[i].offset, list[i].size);
+    else if ( elf2bin_pread(in_fd, map + (list[i].addr - base), list[i].size, list[i].offset) == 0 )
+    {
+      fprintf(stderr, "elf2bin: read error at offset 0x%lx\n", (unsigned long)list[i].offset);
+      result = 0;
+      break;
+    }
+    addr = list[i].addr + list[i].size;
+  }
+  
+  /* the image is complete in memory, the checksums are calculated in one pass */
+  if ( result != 0 && d != NULL )
+  {
+    elf2bin_digest_update(d, base, map, size);
+    if ( is_crc_stored == 0 && d->is_crc_stored != 0 )
+      memcpy(map + (d->crc_addr - base), d->crc_value, 4);
+  }
+  if ( munmap(map, size) != 0 )
+    result = (perror(outfile), 0);
+  if ( result != 0 && d != NULL )
+    elf2bin_show_digest(outfile, d, is_crc_stored == 0 && d->is_crc_stored != 0);
+  return result;
+}
+#endif
+
+/*==========================================*/
+/* Delta Output */
+
+/*
+  Delta of a binary file against the previous version of the binary file, for example for an update over a slow link.
+  
+  offset  size
+    0      4    "E2BD"
+    4      1    version (1)
+    5      1    flags, bit 0: the literals are compressed with zstd
+    6      2    0
+    8      8    size of the new binary file
+    16     8    size of the previous binary file
+    24     4    crc32 of the new binary file
+    28     4    crc32 of the previous binary file
+    32     8    size of the commands
+    40     8    size of the literals
+    48     8    size of the stored (compressed) literals
+    56          commands, followed by the stored literals
+  All numbers are little endian.
+  
+  Each command starts with the unsigned LEB128 value (len << 1) | is_insert:
+    insert: append the next len bytes of the literals to the new binary file
+    copy: followed by a signed (zigzag) LEB128 distance, append len bytes from the previous 
+          binary file, starting at the current size of the new binary file plus distance.
+  
+  The binary file is split into segments at the block (section) boundaries. The segments are 
+  processed in parallel: An unchanged segment at the same position becomes a single copy command.
+  Otherwise the segment is matched against a hash table of the blocks of the previous binary file
+  with a rolling hash (weak checksum of rsync).
+*/
+
+#define ELF2BIN_DELTA_BLOCK 32          // size of the hashed blocks of the previous binary file, min length of a match
+#define ELF2BIN_DELTA_PROBE 16          // max number of probes in the hash table
+#define ELF2BIN_DELTA_HEADER_SIZE 56
+#define ELF2BIN_ZSTD_LEVEL 19
+
+struct _elf2bin_delta_cmd_struct
+{
+  size_t pos;                   // position in the new binary file
+  size_t len;
+  size_t src;                   // position in the previous binary file, only used for copy commands
+  int is_copy;
+};
+typedef struct _elf2bin_delta_cmd_struct elf2bin_delta_cmd_struct;
+
+/* part of the new binary file and the commands for this part */
+struct _elf2bin_delta_seg_struct
+{
+  size_t pos;
+  size_t len;
+  elf2bin_delta_cmd_struct *cmd;
+  size_t cnt;
+  size_t max;
+};
+typedef struct _elf2bin_delta_seg_struct elf2bin_delta_seg_struct;
+
+struct _elf2bin_delta_hash_struct
+{
+  uint32_t hash;
+  size_t pos;                   // position of the block in the previous binary file + 1, 0 for an empty entry
+};
+typedef struct _elf2bin_delta_hash_struct elf2bin_delta_hash_struct;
+
+/* shared state of the threads, which calculate the commands of the segments */
+struct _elf2bin_delta_struct
+{
+  pthread_mutex_t mutex;
+  const unsigned char *new_ptr;
+  size_t new_size;
+  const unsigned char *old_ptr;
+  size_t old_size;
+  elf2bin_delta_hash_struct *table;
+  size_t table_mask;
+  elf2bin_delta_seg_struct *seg;
+  size_t seg_cnt;
+  size_t next_seg;
+  int is_error;
+};
+typedef struct _elf2bin_delta_struct elf2bin_delta_struct;
+
+/* growing memory buffer */
+struct _elf2bin_buf_struct
+{
+  unsigned char *ptr;
+  size_t len;
+  size_t max;
+};
+typedef struct _elf2bin_buf_struct elf2bin_buf_struct;
+
+int elf2bin_buf_add(elf2bin_buf_struct *buf, const void *ptr, size_t len)
+{
+  unsigned char *p;
+  size_t max;
+  if ( buf->len + len > buf->max )
+  {
+    max = buf->max*2 + len + 256;
+    p = (unsigned char *)realloc(buf->ptr, max);
+    if ( p == NULL )
+      return fprintf(stderr, "elf2bin: out of memory\n"), 0;
+    buf->ptr = p;
+    buf->max = max;
+  }
+  memcpy(buf->ptr + buf->len, ptr, len);
+  buf->len += len;
+  return 1;
+}
+
+int elf2bin_buf_add_leb128(elf2bin_buf_struct *buf, unsigned long long v)
+{
+  unsigned char b[10];
+  size_t n = 0;
+  do
+  {
+    b[n] = v & 127;
+    v >>= 7;
+    if ( v != 0 )
+      b[n] |= 128;
+    n++;
+  } while( v != 0 );
+  return elf2bin_buf_add(buf, b, n);
+}
+
+/* read a complete file into memory, a file which doesn't exist is empty, returns a malloc'd buffer or NULL */
+unsigned char *elf2bin_read_file(const char *filename, size_t *size)
+{
+  struct stat st;
+  unsigned char *ptr;
+  int fd;
+  
+  *size = 0;
+  fd = open(filename, O_RDONLY | O_BINARY);
+  if ( fd < 0 )
+  {
+    if ( errno == ENOENT )
+      return (unsigned char *)malloc(1);
+    return perror(filename), NULL;
+  }
+  if ( fstat(fd, &st) != 0 )
+    return perror(filename), close(fd), NULL;
+  ptr = (unsigned char *)malloc((size_t)st.st_size + 1);
+  if ( ptr == NULL )
+    return close(fd), fprintf(stderr, "elf2bin: out of memory\n"), NULL;
+  if ( elf2bin_pread(fd, ptr, (size_t)st.st_size, 0) == 0 )
+    return perror(filename), free(ptr), close(fd), NULL;
+  close(fd);
+  *size = (size_t)st.st_size;
+  return ptr;
+}
+
+/* weak checksum of rsync: a is the sum of the bytes, b the sum of the a values, both mod 2^16 */
+uint32_t elf2bin_delta_get_hash(const unsigned char *p)
+{
+  uint32_t a = 0, b = 0;
+  size_t i;
+  for( i = 0; i < ELF2BIN_DELTA_BLOCK; i++ )
+  {
+    a += p[i];
+    b += a;
+  }
+  return (a & 0xffff) | (b << 16);
+}
+
+/* remove byte out and add byte in to the hash of the block */
+uint32_t elf2bin_delta_roll_hash(uint32_t h, unsigned char out, unsigned char in)
+{
+  uint32_t a = (h & 0xffff) - out + in;
+  uint32_t b = (h >> 16) - ELF2BIN_DELTA_BLOCK*out + a;
+  return (a & 0xffff) | (b << 16);
+}
+
+size_t elf2bin_delta_get_slot(elf2bin_delta_struct *delta, uint32_t h)
+{
+  return (size_t)((h * 0x9E3779B1UL) & 0xffffffffUL) & delta->table_mask;
+}
+
+/* hash table of all blocks of the previous binary file, equal blocks are added only once */
+int elf2bin_delta_init_table(elf2bin_delta_struct *delta)
+{
+  size_t cnt = delta->old_size / ELF2BIN_DELTA_BLOCK;
+  size_t size = 16;
+  size_t i, j, slot;
+  uint32_t h;
+  elf2bin_delta_hash_struct *e;
+  
+  while( size < cnt*2 )
+    size *= 2;
+  delta->table = (elf2bin_delta_hash_struct *)calloc(size, sizeof(elf2bin_delta_hash_struct));
+  if ( delta->table == NULL )
+    return fprintf(stderr, "elf2bin: out of memory\n"), 0;
+  delta->table_mask = size - 1;
+  for( i = 0; i < cnt; i++ )
+  {
+    h = elf2bin_delta_get_hash(delta->old_ptr + i*ELF2BIN_DELTA_BLOCK);
+    slot = elf2bin_delta_get_slot(delta, h);
+    for( j = 0; j < ELF2BIN_DELTA_PROBE; j++ )
+    {
+      e = delta->table + ((slot + j) & delta->table_mask);
+      if ( e->pos == 0 )
+      {
+        e->hash = h;
+        e->pos = i*ELF2BIN_DELTA_BLOCK + 1;
+        break;
+      }
+      if ( e->hash == h && memcmp(delta->old_ptr + e->pos - 1, delta->old_ptr + i*ELF2BIN_DELTA_BLOCK, ELF2BIN_DELTA_BLOCK) == 0 )
+        break;
+    }
+  }
+  return 1;
+}
+
+/* returns the position of a block of the previous binary file, which is equal to p, or (size_t)-1 */
+size_t elf2bin_delta_find_block(elf2bin_delta_struct *delta, uint32_t h, const unsigned char *p)
+{
+  size_t slot = elf2bin_delta_get_slot(delta, h);
+  elf2bin_delta_hash_struct *e;
+  size_t j;
+  for( j = 0; j < ELF2BIN_DELTA_PROBE; j++ )
+  {
+    e = delta->table + ((slot + j) & delta->table_mask);
+    if ( e->pos == 0 )
+      break;
+    if ( e->hash == h && memcmp(delta->old_ptr + e->pos - 1, p, ELF2BIN_DELTA_BLOCK) == 0 )
+      return e->pos - 1;
+  }
+  return (size_t)-1;
+}
+
+int elf2bin_delta_add_cmd(elf2bin_delta_seg_struct *seg, int is_copy, size_t pos, size_t len, size_t src)
+{
+  elf2bin_delta_cmd_struct *cmd;
+  if ( len == 0 )
+    return 1;
+  if ( seg->cnt >= seg->max )
+  {
+    cmd = (elf2bin_delta_cmd_struct *)realloc(seg->cmd, (seg->max*2 + 16)*sizeof(elf2bin_delta_cmd_struct));
+    if ( cmd == NULL )
+      return fprintf(stderr, "elf2bin: out of memory\n"), 0;
+    seg->cmd = cmd;
+    seg->max = seg->max*2 + 16;
+  }
+  seg->cmd[seg->cnt].is_copy = is_copy;
+  seg->cmd[seg->cnt].pos = pos;
+  seg->cmd[seg->cnt].len = len;
+  seg->cmd[seg->cnt].src = src;
+  seg->cnt++;
+  return 1;
+}
+
+/* calculate the copy and insert commands for one segment */
+int elf2bin_delta_segment(elf2bin_delta_struct *delta, elf2bin_delta_seg_struct *seg)
+{
+  const unsigned char *n = delta->new_ptr;
+  const unsigned char *o = delta->old_ptr;
+  size_t end = seg->pos + seg->len;
+  size_t lit = seg->pos;          // start of the pending literals
+  size_t p = seg->pos;
+  size_t q, len;
+  uint32_t h = 0;
+  int is_hash = 0;
+  
+  /* unchanged segment */
+  if ( end <= delta->old_size && memcmp(n + seg->pos, o + seg->pos, seg->len) == 0 )
+    return elf2bin_delta_add_cmd(seg, 1, seg->pos, seg->len, seg->pos);
+  
+  while( p + ELF2BIN_DELTA_BLOCK <= end )
+  {
+    /* same position in the previous binary file or any block with the same hash */
+    q = (size_t)-1;
+    if ( p + ELF2BIN_DELTA_BLOCK <= delta->old_size && memcmp(n + p, o + p, ELF2BIN_DELTA_BLOCK) == 0 )
+      q = p;
+    else if ( delta->old_size >= ELF2BIN_DELTA_BLOCK )
+    {
+      h = is_hash ? elf2bin_delta_roll_hash(h, n[p-1], n[p+ELF2BIN_DELTA_BLOCK-1]) : elf2bin_delta_get_hash(n + p);
+      is_hash = 1;
+      q = elf2bin_delta_find_block(delta, h, n + p);
+    }
+    if ( q == (size_t)-1 )
+    {
+      p++;
+      continue;
+    }
+    
+    /* extend the match in both directions */
+    len = ELF2BIN_DELTA_BLOCK;
+    while( p > lit && q > 0 && n[p-1] == o[q-1] )
+    {
+      p--; q--; len++;
+    }
+    while( p + len < end && q + len < delta->old_size && n[p+len] == o[q+len] )
+      len++;
+    if ( elf2bin_delta_add_cmd(seg, 0, lit, p - lit, 0) == 0 )
+      return 0;
+    if ( elf2bin_delta_add_cmd(seg, 1, p, len, q) == 0 )
+      return 0;
+    p += len;
+    lit = p;
+    is_hash = 0;
+  }
+  return elf2bin_delta_add_cmd(seg, 0, lit, end - lit, 0);
+}
+
+void *elf2bin_delta_thread(void *arg)
+{
+  elf2bin_delta_struct *delta = (elf2bin_delta_struct *)arg;
+  size_t i;
+  for(;;)
+  {
+    pthread_mutex_lock(&(delta->mutex));
+    i = delta->next_seg;
+    if ( delta->is_error == 0 && i < delta->seg_cnt )
+      delta->next_seg++;
+    else
+      i = delta->seg_cnt;
+    pthread_mutex_unlock(&(delta->mutex));
+    if ( i >= delta->seg_cnt )
+      break;
+    if ( elf2bin_delta_segment(delta, delta->seg + i) == 0 )
+    {
+      pthread_mutex_lock(&(delta->mutex));
+      delta->is_error = 1;
+      pthread_mutex_unlock(&(delta->mutex));
+    }
+  }
+  return NULL;
+}
+
+/* split the binary file into segments at the block boundaries (list is relative to base) */
+elf2bin_delta_seg_struct *elf2bin_delta_get_seg_list(elf2bin_block_struct *list, size_t cnt, unsigned long long base, size_t size, size_t *seg_cnt)
+{
+  elf2bin_delta_seg_struct *seg;
+  size_t i, pos = 0, end, max = 1;
+  
+  for( i = 0; i < cnt; i++ )
+    max += 2 + list[i].size / ELF2BIN_PIECE_SIZE;
+  max += size / ELF2BIN_PIECE_SIZE;
+  seg = (elf2bin_delta_seg_struct *)calloc(max, sizeof(elf2bin_delta_seg_struct));
+  if ( seg == NULL )
+    return fprintf(stderr, "elf2bin: out of memory\n"), NULL;
+  *seg_cnt = 0;
+  for( i = 0; i <= cnt; i++ )
+  {
+    /* gap before block i (or up to the end of the file), then block i, large segments are split */
+    end = i < cnt ? list[i].addr - base : size;
+    while( pos < end )
+    {
+      seg[*seg_cnt].pos = pos;
+      seg[*seg_cnt].len = end - pos > ELF2BIN_PIECE_SIZE ? ELF2BIN_PIECE_SIZE : end - pos;
+      pos += seg[*seg_cnt].len;
+      (*seg_cnt)++;
+    }
+    if ( i == cnt )
+      break;
+    end = list[i].addr + list[i].size - base;
+    while( pos < end )
+    {
+      seg[*seg_cnt].pos = pos;
+      seg[*seg_cnt].len = end - pos > ELF2BIN_PIECE_SIZE ? ELF2BIN_PIECE_SIZE : end - pos;
+      pos += seg[*seg_cnt].len;
+      (*seg_cnt)++;
+    }
+  }
+  return seg;
+}
+
+/* append one command to the command buffer and the literals of an insert command to the literal buffer */
+int elf2bin_delta_put_cmd(elf2bin_delta_struct *delta, elf2bin_delta_cmd_struct *cmd, elf2bin_buf_struct *cmd_buf, elf2bin_buf_struct *lit_buf)
+{
+  long long dist;
+  if ( elf2bin_buf_add_leb128(cmd_buf, ((unsigned long long)cmd->len << 1) | (cmd->is_copy ? 0 : 1)) == 0 )
+    return 0;
+  if ( cmd->is_copy == 0 )
+    return elf2bin_buf_add(lit_buf, delta->new_ptr + cmd->pos, cmd->len);
+  dist = (long long)cmd->src - (long long)cmd->pos;
+  return elf2bin_buf_add_leb128(cmd_buf, dist < 0 ? ((unsigned long long)(-dist) << 1) - 1 : (unsigned long long)dist << 1);
+}
+
+/* encode the commands of all segments, adjacent commands (for example copy commands of unchanged segments) are merged */
+int elf2bin_delta_encode(elf2bin_delta_struct *delta, elf2bin_buf_struct *cmd_buf, elf2bin_buf_struct *lit_buf)
+{
+  elf2bin_delta_cmd_struct cur, *c;
+  size_t i, j;
+  int is_cur = 0;
+  
+  for( i = 0; i < delta->seg_cnt; i++ )
+  {
+    for( j = 0; j < delta->seg[i].cnt; j++ )
+    {
+      c = delta->seg[i].cmd + j;
+      if ( is_cur && c->is_copy == cur.is_copy && (c->is_copy == 0 || c->src == cur.src + cur.len) )
+      {
+        cur.len += c->len;
+        continue;
+      }
+      if ( is_cur && elf2bin_delta_put_cmd(delta, &cur, cmd_buf, lit_buf) == 0 )
+        return 0;
+      cur = *c;
+      is_cur = 1;
+    }
+  }
+  if ( is_cur )
+    return elf2bin_delta_put_cmd(delta, &cur, cmd_buf, lit_buf);
+  return 1;
+}
+
+/* store the lower n bytes of v in little endian order */
+void elf2bin_put_le(unsigned char *p, unsigned long long v, int n)
+{
+  int i;
+  for( i = 0; i < n; i++ )
+  {
+    p[i] = v & 255;
+    v >>= 8;
+  }
+}
+
+/* read n bytes in little endian order */
+unsigned long long elf2bin_get_le(const unsigned char *p, int n)
+{
+  unsigned long long v = 0;
+  while( n > 0 )
+  {
+    n--;
+    v = (v << 8) | p[n];
+  }
+  return v;
+}
+
+/* 
+  write the delta of the binary file outfile (size bytes, starting at base) against old_file to <outfile>.delta,
+  the new binary file is assembled from the blocks in memory (including the crc of option "-c"), it is not read again
+*/
+int elf2bin_write_delta(int in_fd, const char *outfile, const char *old_file, elf2bin_block_struct *list, size_t cnt, unsigned long long base, size_t size, elf2bin_digest_struct *d)
+{
+  elf2bin_delta_struct delta;
+  elf2bin_buf_struct cmd_buf = { NULL, 0, 0 };
+  elf2bin_buf_struct lit_buf = { NULL, 0, 0 };
+  unsigned char head[ELF2BIN_DELTA_HEADER_SIZE];
+  unsigned char *new_ptr, *old_ptr;
+  unsigned char *zbuf = NULL;
+  const unsigned char *lit_ptr;
+  size_t new_size, old_size, lit_size, zsize;
+  pthread_t *threads;
+  char *filename;
+  size_t i, n;
+  int result = 0;
+  int fd;
+  
+  new_size = size;
+  new_ptr = (unsigned char *)malloc(new_size + 1);
+  if ( new_ptr == NULL )
+    return fprintf(stderr, "elf2bin: out of memory\n"), 0;
+  if ( elf2bin_get_image(in_fd, list, cnt, base, new_ptr, new_size) == 0 )
+    return free(new_ptr), 0;
+  if ( d != NULL && d->is_crc_stored && d->crc_addr >= base && d->crc_addr + 4 <= base + new_size )
+    memcpy(new_ptr + (d->crc_addr - base), d->crc_value, 4);
+  old_ptr = elf2bin_read_file(old_file, &old_size);
+  if ( old_ptr == NULL )
+    return free(new_ptr), 0;
+  filename = (char *)malloc(strlen(outfile) + 7);
+  if ( filename == NULL )
+    return free(old_ptr), free(new_ptr), fprintf(stderr, "elf2bin: out of memory\n"), 0;
+  sprintf(filename, "%s.delta", outfile);
+  
+  memset(&delta, 0, sizeof(delta));
+  delta.new_ptr = new_ptr;
+  delta.new_size = new_size;
+  delta.old_ptr = old_ptr;
+  delta.old_size = old_size;
+  pthread_mutex_init(&(delta.mutex), NULL);
+  delta.seg = elf2bin_delta_get_seg_list(list, cnt, base, new_size, &(delta.seg_cnt));
+  if ( delta.seg != NULL && elf2bin_delta_init_table(&delta) != 0 )
+  {
+    /* calculate the commands of the segments in parallel */
+    n = elf2bin_thread_cnt > 1 ? (size_t)elf2bin_thread_cnt : 1;
+    if ( n > delta.seg_cnt )
+      n = delta.seg_cnt;
+    threads = n > 1 ? (pthread_t *)malloc(n*sizeof(pthread_t)) : NULL;
+    i = 0;
+    if ( threads != NULL )
+      for( i = 0; i < n; i++ )
+        if ( pthread_create(threads+i, NULL, elf2bin_delta_thread, &delta) != 0 )
+          break;
+    elf2bin_delta_thread(&delta);
+    while( i > 0 )
+      pthread_join(threads[--i], NULL);
+    free(threads);
+    
+    if ( delta.is_error == 0 && elf2bin_delta_encode(&delta, &cmd_buf, &lit_buf) != 0 )
+      result = 1;
+  }
+  
+  /* optional compression of the literals, only used if the result is smaller */
+  lit_ptr = lit_buf.ptr;
+  lit_size = lit_buf.len;
+  if ( result != 0 && elf2bin_is_delta_zstd && lit_size > 0 )
+  {
+    zbuf = (unsigned char *)malloc(ZSTD_compressBound(lit_size));
+    if ( zbuf != NULL )
+    {
+      zsize = ZSTD_compress(zbuf, ZSTD_compressBound(lit_size), lit_buf.ptr, lit_size, ELF2BIN_ZSTD_LEVEL);
+      if ( ZSTD_isError(zsize) == 0 && zsize < lit_size )
+      {
+        lit_ptr = zbuf;
+        lit_size = zsize;
+      }
+    }
+  }
+  
+  if ( result != 0 )
+  {
+    elf2bin_init_crc_table();
+    memset(head, 0, sizeof(head));
+    memcpy(head, "E2BD", 4);
+    head[4] = 1;
+    head[5] = lit_ptr != lit_buf.ptr ? 1 : 0;
+    elf2bin_put_le(head + 8, new_size, 8);
+    elf2bin_put_le(head + 16, old_size, 8);
+    elf2bin_put_le(head + 24, elf2bin_update_crc(0, new_ptr, new_size), 4);
+    elf2bin_put_le(head + 28, elf2bin_update_crc(0, old_ptr, old_size), 4);
+    elf2bin_put_le(head + 32, cmd_buf.len, 8);
+    elf2bin_put_le(head + 40, lit_buf.len, 8);
+    elf2bin_put_le(head + 48, lit_size, 8);
+    
+    // S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH
+    fd = creat(filename, S_IRWXU);
+    if ( fd < 0 )
+      result = (perror(filename), 0);
+    else
+    {
+      if ( elf2bin_pwrite(fd, head, ELF2BIN_DELTA_HEADER_SIZE, 0) == 0 
+        || elf2bin_pwrite(fd, cmd_buf.ptr, cmd_buf.len, ELF2BIN_DELTA_HEADER_SIZE) == 0
+        || elf2bin_pwrite(fd, lit_ptr, lit_size, ELF2BIN_DELTA_HEADER_SIZE + cmd_buf.len) == 0 )
+        result = (perror(filename), 0);
+      if ( close(fd) != 0 )
+        result = (perror(filename), 0);
+    }
+    if ( result != 0 )
+      printf("%s: %lu bytes (commands %lu, literals %lu, stored literals %lu)\n", filename, 
+        (unsigned long)(ELF2BIN_DELTA_HEADER_SIZE + cmd_buf.len + lit_size), 
+        (unsigned long)cmd_buf.len, (unsigned long)lit_buf.len, (unsigned long)lit_size);
+  }
+  
+  for( i = 0; delta.seg != NULL && i < delta.seg_cnt; i++ )
+    free(delta.seg[i].cmd);
+  free(delta.seg);
+  free(delta.table);
+  pthread_mutex_destroy(&(delta.mutex));
+  free(zbuf);
+  free(cmd_buf.ptr);
+  free(lit_buf.ptr);
+  free(filename);
+  free(old_ptr);
+  free(new_ptr);
+  return result;
+}
+
+/* read an unsigned LEB128 value at *pos, returns 0 if the value exceeds size */
+int elf2bin_get_leb128(const unsigned char *ptr, size_t size, size_t *pos, unsigned long long *v)
+{
+  int shift = 0;
+  *v = 0;
+  while( *pos < size && shift < 64 )
+  {
+    *v |= (unsigned long long)(ptr[*pos] & 127) << shift;
+    shift += 7;
+    if ( (ptr[(*pos)++] & 128) == 0 )
+      return 1;
+  }
+  return 0;
+}
+
+/* execute the commands of a delta, returns 0 if the commands don't match the sizes */
+int elf2bin_delta_run_cmds(const unsigned char *cmd, size_t cmd_size, const unsigned char *lit, size_t lit_size, 
+  const unsigned char *old_ptr, size_t old_size, unsigned char *new_ptr, size_t new_size)
+{
+  size_t pos = 0, cur = 0, lit_pos = 0;
+  unsigned long long v, len, dist, src;
+  
+  while( pos < cmd_size )
+  {
+    if ( elf2bin_get_leb128(cmd, cmd_size, &pos, &v) == 0 )
+      return 0;
+    len = v >> 1;
+    if ( len > new_size - cur )
+      return 0;
+    if ( v & 1 )
+    {
+      /* insert */
+      if ( len > lit_size - lit_pos )
+        return 0;
+      memcpy(new_ptr + cur, lit + lit_pos, len);
+      lit_pos += len;
+    }
+    else
+    {
+      /* copy, the distance is zigzag encoded */
+      if ( elf2bin_get_leb128(cmd, cmd_size, &pos, &dist) == 0 )
+        return 0;
+      src = (dist & 1) ? cur - ((dist + 1) >> 1) : cur + (dist >> 1);
+      if ( src > old_size || len > old_size - src )
+        return 0;
+      memcpy(new_ptr + cur, old_ptr + src, len);
+    }
+    cur += len;
+  }
+  return cur == new_size && lit_pos == lit_size;
+}
+
+/*
+  Decode a delta (see elf2bin_write_delta()) against the previous binary file old_ptr.
+  The size and crc32 of both binary files are checked. Returns the malloc'd new binary file or NULL.
+*/
+unsigned char *elf2bin_decode_delta(const unsigned char *head, size_t delta_size, const unsigned char *old_ptr, size_t old_size, size_t *new_size)
+{
+  unsigned char *new_ptr, *lit_ptr = NULL;
+  const unsigned char *lit;
+  size_t cmd_size, lit_size, stored_size, r;
+  
+  elf2bin_init_crc_table();
+  if ( delta_size < ELF2BIN_DELTA_HEADER_SIZE || memcmp(head, "E2BD", 4) != 0 || head[4] != 1 )
+    return fprintf(stderr, "elf2bin: not a delta file\n"), NULL;
+  *new_size = elf2bin_get_le(head + 8, 8);
+  cmd_size = elf2bin_get_le(head + 32, 8);
+  lit_size = elf2bin_get_le(head + 40, 8);
+  stored_size = elf2bin_get_le(head + 48, 8);
+  if ( cmd_size > delta_size - ELF2BIN_DELTA_HEADER_SIZE || stored_size != delta_size - ELF2BIN_DELTA_HEADER_SIZE - cmd_size )
+    return fprintf(stderr, "elf2bin: corrupted delta file\n"), NULL;
+  if ( old_size != elf2bin_get_le(head + 16, 8) || elf2bin_update_crc(0, (unsigned char *)old_ptr, old_size) != (unsigned long)elf2bin_get_le(head + 28, 4) )
+    return fprintf(stderr, "elf2bin: the delta does not belong to the previous binary file\n"), NULL;
+  
+  lit = head + ELF2BIN_DELTA_HEADER_SIZE + cmd_size;
+  if ( head[5] & 1 )
+  {
+    lit_ptr = (unsigned char *)malloc(lit_size + 1);
+    if ( lit_ptr == NULL )
+      return fprintf(stderr, "elf2bin: out of memory\n"), NULL;
+    r = ZSTD_decompress(lit_ptr, lit_size, lit, stored_size);
+    if ( ZSTD_isError(r) || r != lit_size )
+      return free(lit_ptr), fprintf(stderr, "elf2bin: corrupted literals in the delta file\n"), NULL;
+    lit = lit_ptr;
+  }
+  else if ( lit_size != stored_size )
+    return fprintf(stderr, "elf2bin: corrupted delta file\n"), NULL;
+  
+  new_ptr = (unsigned char *)malloc(*new_size + 1);
+  if ( new_ptr == NULL )
+    return free(lit_ptr), fprintf(stderr, "elf2bin: out of memory\n"), NULL;
+  if ( elf2bin_delta_run_cmds(head + ELF2BIN_DELTA_HEADER_SIZE, cmd_size, lit, lit_size, old_ptr, old_size, new_ptr, *new_size) == 0 )
+    return free(new_ptr), free(lit_ptr), fprintf(stderr, "elf2bin: invalid commands in the delta file\n"), NULL;
+  free(lit_ptr);
+  if ( elf2bin_update_crc(0, new_ptr, *new_size) != (unsigned long)elf2bin_get_le(head + 24, 4) )
+    return free(new_ptr), fprintf(stderr, "elf2bin: crc32 error of the new binary file\n"), NULL;
+  return new_ptr;
+}
+
+/* apply the delta file to the previous binary file old_file and write the new binary file to outfile (option "-a") */
+int elf2bin_apply_delta(const char *old_file, const char *delta_file, const char *outfile)
+{
+  unsigned char *delta_ptr, *old_ptr, *new_ptr;
+  size_t delta_size, old_size, new_size;
+  int result;
+  int fd;
+  
+  delta_ptr = elf2bin_read_file(delta_file, &delta_size);
+  if ( delta_ptr == NULL )
+    return 0;
+  old_ptr = elf2bin_read_file(old_file, &old_size);
+  if ( old_ptr == NULL )
+    return free(delta_ptr), 0;
+  new_ptr = elf2bin_decode_delta(delta_ptr, delta_size, old_ptr, old_size, &new_size);
+  free(old_ptr);
+  free(delta_ptr);
+  if ( new_ptr == NULL )
+    return fprintf(stderr, "elf2bin: %s can not be applied to %s\n", delta_file, old_file), 0;
+  
+  // S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH
+  fd = creat(outfile, S_IRWXU);
+  if ( fd < 0 )
+    return perror(outfile), free(new_ptr), 0;
+  result = elf2bin_pwrite(fd, new_ptr, new_size, 0);
+  if ( close(fd) != 0 )
+    result = 0;
+  free(new_ptr);
+  if ( result == 0 )
+    return perror(outfile), unlink(outfile), 0;
+  printf("%s: %lu bytes\n", outfile, (unsigned long)new_size);
+  return 1;
+}
+
+/*==========================================*/
+/* Binary Files */
+
+/* 
+  A region starts with block first and ends before the next gap, which is larger than elf2bin_gap_max.
+  Returns the index of the first block after the region (list is sorted by address).
 */
+size_t elf2bin_get_region_last(elf2bin_block_struct *list, size_t cnt, size_t first)
+{
+  unsigned long long end = list[first].addr + list[first].size;
+  size_t last;
+  for( last = first+1; last < cnt; last++ )
+  {
+    if ( list[last].addr > end && list[last].addr - end > elf2bin_gap_max )
+      break;
+    if ( list[last].addr + list[last].size > end )
+      end = list[last].addr + list[last].size;
+  }
+  return last;
+}
 
-#include <stdio.h>
-#include <fcntl.h>
-#include <sys/stat.h>
-#include <unistd.h>
-#include <libelf.h>
-#include <gelf.h>
-#include <string.h>
-#include <assert.h>
+/*
+  Name of the binary file for the region, which starts at addr: "_<addr>" is inserted before the 
+  extension of outfile, for example "flash.bin" becomes "flash_08000000.bin".
+  Returns a malloc'd string or NULL.
+*/
+char *elf2bin_get_region_filename(const char *outfile, unsigned long long addr)
+{
+  const char *ext = strrchr(outfile, '.');
+  const char *sep = strrchr(outfile, '/');
+  size_t len;
+  char *s;
+  
+  if ( ext == NULL || (sep != NULL && ext < sep) )
+    ext = outfile + strlen(outfile);
+  len = ext - outfile;
+  s = (char *)malloc(len + strlen(ext) + 20);
+  if ( s == NULL )
+    return fprintf(stderr, "elf2bin: out of memory\n"), NULL;
+  memcpy(s, outfile, len);
+  sprintf(s + len, "_%08llx%s", addr, ext);
+  return s;
+}
+
+/* smaller gaps between two blocks are preallocated together with the blocks */
+#define ELF2BIN_SPARSE_GAP 4096
+
+/* 
+  write the blocks first ... last-1 to a binary file, which starts at base,
+  if old_file is not NULL, then the delta against old_file is written to <outfile>.delta 
+*/
+int elf2bin_write_region(int in_fd, const char *outfile, const char *old_file, elf2bin_block_struct *list, size_t first, size_t last, unsigned long long base, elf2bin_digest_struct *d)
+{
+  unsigned long long end = base;
+  unsigned long long start, stop;
+  struct stat old_st, out_st;
+  size_t i, j;
+  int result;
+  int fd;
+  
+  for( i = first; i < last; i++ )
+    if ( list[i].addr + list[i].size > end )
+      end = list[i].addr + list[i].size;
+  printf("%08llx-%08llx: %s\n", base, end, outfile);
+  
+  /* the previous binary file must not be overwritten before the delta is calculated */
+  if ( old_file != NULL && stat(old_file, &old_st) == 0 && stat(outfile, &out_st) == 0 
+    && old_st.st_dev == out_st.st_dev && old_st.st_ino == out_st.st_ino )
+    return fprintf(stderr, "elf2bin: %s is the output file and the previous binary file\n", outfile), 0;
+  
+  /* create the file with its final size, so that the blocks can be written in any order */
+  // S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH, read access is required for mmap()
+  fd = open(outfile, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, S_IRWXU);
+  if ( fd < 0 )
+    return perror(outfile), 0;
+#if defined(__linux__)
+  /* failure is ok, for example if not supported by the file system */
+  if ( elf2bin_is_gap_fill )
+  {
+    if ( end > base )
+      fallocate(fd, 0, 0, (off_t)(end - base));     // the gaps are also written
+  }
+  else
+  {
+    /* preallocate only the blocks, so that the gaps remain holes of the sparse file */
+    for( i = first; i < last; i = j )
+    {
+      start = list[i].addr;
+      stop = list[i].addr + list[i].size;
+      for( j = i + 1; j < last && list[j].addr <= stop + ELF2BIN_SPARSE_GAP; j++ )
+        if ( list[j].addr + list[j].size > stop )
+          stop = list[j].addr + list[j].size;
+      if ( stop > start )
+        fallocate(fd, 0, (off_t)(start - base), (off_t)(stop - start));
+    }
+  }
+#endif
+  if ( ftruncate(fd, (off_t)(end - base)) != 0 )
+    return perror(outfile), close(fd), unlink(outfile), 0;
+  if ( d != NULL )
+  {
+    d->crc = 0;
+    elf2bin_sha256_init(&(d->sha));
+  }
+#if defined(ELF2BIN_MMAP)
+  if ( elf2bin_is_mmap )
+  {
+    result = elf2bin_write_binary_mmap(in_fd, fd, outfile, list + first, last - first, base, end - base, d);
+    if ( close(fd) != 0 )
+      result = (perror(outfile), 0);
+  }
+  else
+#endif
+  {
+    if ( close(fd) != 0 )
+      return perror(outfile), unlink(outfile), 0;
+    result = elf2bin_write_binary(in_fd, outfile, list + first, last - first, base, d);
+  }
+  if ( result == 0 )
+    return unlink(outfile), 0;        // don't leave an incomplete binary file
+  if ( old_file != NULL )
+    result = elf2bin_write_delta(in_fd, outfile, old_file, list + first, last - first, base, end - base, d);
+  return result;
+}
+
+/*
+  Binary output: The blocks are placed by their load address relative to a base address.
+  With option "-b" the binary file starts at elf2bin_base_addr. Otherwise the file starts at 
+  the lowest load address and a gap larger than elf2bin_gap_max (for example between flash and 
+  external memory) starts a new file, see elf2bin_get_region_filename().
+*/
+int elf2bin_write_binary_regions(int in_fd, const char *outfile, elf2bin_block_struct *list, size_t cnt, elf2bin_digest_struct *d)
+{
+  size_t first, last;
+  char *filename;
+  char *old_file = NULL;
+  int result = 1;
+  
+  if ( cnt == 0 )
+    return elf2bin_write_region(in_fd, outfile, elf2bin_delta_old, list, 0, 0, 0, d);
+  if ( elf2bin_is_base_addr )
+  {
+    if ( list[0].addr < elf2bin_base_addr )
+      return fprintf(stderr, "elf2bin: load address 0x%llx is below the base address 0x%llx\n", list[0].addr, elf2bin_base_addr), 0;
+    return elf2bin_write_region(in_fd, outfile, elf2bin_delta_old, list, 0, cnt, elf2bin_base_addr, d);
+  }
+  
+  /* find the regions, the list is sorted by address */
+  for( first = 0; first < cnt; first = last )
+  {
+    last = elf2bin_get_region_last(list, cnt, first);
+    if ( first == 0 && last == cnt )
+      return elf2bin_write_region(in_fd, outfile, elf2bin_delta_old, list, first, last, list[first].addr, d);
+    /* the previous binary files of the regions have the same names */
+    filename = elf2bin_get_region_filename(outfile, list[first].addr);
+    if ( filename == NULL )
+      return 0;
+    if ( elf2bin_delta_old != NULL )
+    {
+      old_file = elf2bin_get_region_filename(elf2bin_delta_old, list[first].addr);
+      if ( old_file == NULL )
+        return free(filename), 0;
+    }
+    result = elf2bin_write_region(in_fd, filename, old_file, list, first, last, list[first].addr, d);
+    free(old_file);
+    old_file = NULL;
+    free(filename);
+    if ( result == 0 )
+      return 0;
+  }
+  return 1;
+}
 
 /*==========================================*/
-/* Target System Special Code */
+/* Compressed Container */
 
-#if defined(__MINGW32__) || defined(__MINGW64__)
-// seems to be missing on mingw
-unsigned long __stack_chk_guard = 0xaa55;
-void __attribute__ ((noreturn)) __stack_chk_fail (void)
+/*
+  Container for the binary output, which can be read at any address without decompressing the whole image:
+  The regions (see elf2bin_get_region_last()) are split into blocks of ELF2BIN_E2BZ_BLOCK_SIZE bytes
+  (the last block of a region might be smaller) and each block is compressed with zstd.
+  
+  offset  size
+    0      4    "E2BZ"
+    4      1    version (1)
+    5      3    0
+    8      4    block size
+    12     4    number of regions
+    16     8    number of blocks
+    24     8    offset of the block index
+    32          regions, 24 bytes each: address (8), size (8), index of the first block (8)
+                compressed blocks
+                block index, 24 bytes for each block: offset in the container (8), stored size (4), 
+                  size (4), crc32 of the uncompressed data (4), flags (4, bit 0: the block is stored uncompressed)
+  All numbers are little endian. The address of block i of a region is the region address plus 
+  (i - index of the first block) * block size. Gaps inside a region are filled with elf2bin_gap_fill.
+  The container is read by elf2bin_e2bz_open() and elf2bin_e2bz_read(), see also option "-x".
+*/
+
+#define ELF2BIN_E2BZ_BLOCK_SIZE (64*1024)
+#define ELF2BIN_E2BZ_LEVEL 9
+#define ELF2BIN_E2BZ_HEADER_SIZE 32
+#define ELF2BIN_E2BZ_REGION_SIZE 24
+#define ELF2BIN_E2BZ_INDEX_SIZE 24
+#define ELF2BIN_E2BZ_QUEUE 4            // max number of compressed blocks per thread, which wait for the output
+
+struct _elf2bin_zblock_struct
 {
-	exit(0);
+  unsigned long long addr;      // address of the uncompressed data
+  size_t size;
+  unsigned char *data;          // malloc'd compressed (or stored) data, NULL after the block is written
+  size_t data_size;
+  size_t pos;                   // offset in the container, valid after the block is written
+  unsigned long crc;
+  int is_stored;                // 1: the block is stored uncompressed
+  int is_done;                  // 1: data is available
+};
+typedef struct _elf2bin_zblock_struct elf2bin_zblock_struct;
+
+struct _elf2bin_zregion_struct
+{
+  unsigned long long addr;
+  size_t size;
+  size_t first_block;
+};
+typedef struct _elf2bin_zregion_struct elf2bin_zregion_struct;
+
+/* 
+  shared state of the threads, which fill and compress the blocks, the main thread writes the blocks in 
+  their order and frees the compressed data, so only a few blocks per thread are in memory
+*/
+struct _elf2bin_zip_struct
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;          // signaled for each compressed and each written block
+  int in_fd;
+  elf2bin_block_struct *list;
+  size_t list_cnt;
+  elf2bin_zblock_struct *block;
+  size_t cnt;
+  size_t next;                  // next block, which is compressed
+  size_t written;               // number of written blocks
+  size_t queue_max;             // max number of compressed blocks, which are not written yet
+  int is_error;
+};
+typedef struct _elf2bin_zip_struct elf2bin_zip_struct;
+
+/* fill one block from the elf file into buf (ELF2BIN_E2BZ_BLOCK_SIZE bytes) and compress it */
+int elf2bin_zip_block(elf2bin_zip_struct *zip, elf2bin_zblock_struct *b, unsigned char *buf, ZSTD_CCtx *cctx)
+{
+  size_t bound = ZSTD_compressBound(b->size);
+  size_t r;
+  
+  if ( elf2bin_get_image(zip->in_fd, zip->list, zip->list_cnt, b->addr, buf, b->size) == 0 )
+    return 0;
+  b->crc = elf2bin_update_crc(0, buf, b->size);
+  b->data = (unsigned char *)malloc(bound > b->size ? bound : b->size);
+  if ( b->data == NULL )
+    return fprintf(stderr, "elf2bin: out of memory\n"), 0;
+  r = ZSTD_compressCCtx(cctx, b->data, bound, buf, b->size, ELF2BIN_E2BZ_LEVEL);
+  if ( ZSTD_isError(r) || r >= b->size )
+  {
+    /* not compressible */
+    memcpy(b->data, buf, b->size);
+    b->data_size = b->size;
+    b->is_stored = 1;
+  }
+  else
+    b->data_size = r;
+  return 1;
 }
-#endif
 
-#ifndef O_BINARY
-#define O_BINARY 0
-#endif
+void *elf2bin_zip_thread(void *arg)
+{
+  elf2bin_zip_struct *zip = (elf2bin_zip_struct *)arg;
+  unsigned char *buf = (unsigned char *)malloc(ELF2BIN_E2BZ_BLOCK_SIZE);
+  ZSTD_CCtx *cctx = ZSTD_createCCtx();
+  size_t i;
+  int is_ok;
+  
+  for(;;)
+  {
+    pthread_mutex_lock(&(zip->mutex));
+    if ( cctx == NULL || buf == NULL )
+      zip->is_error = 1;
+    while( zip->is_error == 0 && zip->next < zip->cnt && zip->next >= zip->written + zip->queue_max )
+      pthread_cond_wait(&(zip->cond), &(zip->mutex));
+    i = zip->next;
+    if ( zip->is_error == 0 && i < zip->cnt )
+      zip->next++;
+    else
+      i = zip->cnt;
+    pthread_mutex_unlock(&(zip->mutex));
+    if ( i >= zip->cnt )
+      break;
+    
+    is_ok = elf2bin_zip_block(zip, zip->block + i, buf, cctx);
+    pthread_mutex_lock(&(zip->mutex));
+    if ( is_ok == 0 )
+      zip->is_error = 1;
+    zip->block[i].is_done = 1;
+    pthread_cond_broadcast(&(zip->cond));
+    pthread_mutex_unlock(&(zip->mutex));
+  }
+  if ( cctx != NULL )
+    ZSTD_freeCCtx(cctx);
+  free(buf);
+  return NULL;
+}
+
+/* write the blocks in their order to fd, while they are compressed by up to elf2bin_thread_cnt threads */
+int elf2bin_write_e2bz_blocks(elf2bin_zip_struct *zip, int fd, size_t pos)
+{
+  pthread_t *threads;
+  unsigned char *buf = NULL;
+  ZSTD_CCtx *cctx = NULL;
+  elf2bin_zblock_struct *b;
+  size_t i, n;
+  int is_ok = 1;
+  
+  elf2bin_init_crc_table();
+  n = elf2bin_thread_cnt > 1 ? (size_t)elf2bin_thread_cnt : 0;
+  if ( n > zip->cnt )
+    n = zip->cnt;
+  zip->queue_max = n*ELF2BIN_E2BZ_QUEUE;
+  threads = n > 1 ? (pthread_t *)malloc(n*sizeof(pthread_t)) : NULL;
+  i = 0;
+  if ( threads != NULL )
+    for( i = 0; i < n; i++ )
+      if ( pthread_create(threads+i, NULL, elf2bin_zip_thread, zip) != 0 )
+        break;
+  n = i;
+  if ( n == 0 )
+  {
+    /* no threads: fill, compress and write one block after the other */
+    buf = (unsigned char *)malloc(ELF2BIN_E2BZ_BLOCK_SIZE);
+    cctx = ZSTD_createCCtx();
+    if ( buf == NULL || cctx == NULL )
+      is_ok = (fprintf(stderr, "elf2bin: out of memory\n"), 0);
+  }
+  
+  for( i = 0; i < zip->cnt && is_ok; i++ )
+  {
+    b = zip->block + i;
+    if ( n == 0 )
+      is_ok = elf2bin_zip_block(zip, b, buf, cctx);
+    else
+    {
+      pthread_mutex_lock(&(zip->mutex));
+      while( b->is_done == 0 && zip->is_error == 0 )
+        pthread_cond_wait(&(zip->cond), &(zip->mutex));
+      is_ok = zip->is_error == 0;
+      pthread_mutex_unlock(&(zip->mutex));
+    }
+    if ( is_ok && elf2bin_pwrite(fd, b->data, b->data_size, pos) == 0 )
+      is_ok = (perror("elf2bin"), 0);
+    b->pos = pos;
+    pos += b->data_size;
+    free(b->data);
+    b->data = NULL;
+    pthread_mutex_lock(&(zip->mutex));
+    if ( is_ok == 0 )
+      zip->is_error = 1;
+    zip->written = i + 1;
+    pthread_cond_broadcast(&(zip->cond));
+    pthread_mutex_unlock(&(zip->mutex));
+  }
+  
+  while( n > 0 )
+    pthread_join(threads[--n], NULL);
+  free(threads);
+  if ( cctx != NULL )
+    ZSTD_freeCCtx(cctx);
+  free(buf);
+  return is_ok && zip->is_error == 0;
+}
+
+/* write header, regions and block index, the blocks are written by elf2bin_write_e2bz_blocks() */
+int elf2bin_write_e2bz_index(int fd, elf2bin_zregion_struct *region, size_t region_cnt, elf2bin_zblock_struct *block, size_t block_cnt, size_t index_pos)
+{
+  unsigned char rec[ELF2BIN_E2BZ_HEADER_SIZE];
+  size_t i;
+  
+  memset(rec, 0, sizeof(rec));
+  memcpy(rec, "E2BZ", 4);
+  rec[4] = 1;
+  elf2bin_put_le(rec + 8, ELF2BIN_E2BZ_BLOCK_SIZE, 4);
+  elf2bin_put_le(rec + 12, region_cnt, 4);
+  elf2bin_put_le(rec + 16, block_cnt, 8);
+  elf2bin_put_le(rec + 24, index_pos, 8);
+  if ( elf2bin_pwrite(fd, rec, ELF2BIN_E2BZ_HEADER_SIZE, 0) == 0 )
+    return 0;
+  for( i = 0; i < region_cnt; i++ )
+  {
+    elf2bin_put_le(rec, region[i].addr, 8);
+    elf2bin_put_le(rec + 8, region[i].size, 8);
+    elf2bin_put_le(rec + 16, region[i].first_block, 8);
+    if ( elf2bin_pwrite(fd, rec, ELF2BIN_E2BZ_REGION_SIZE, ELF2BIN_E2BZ_HEADER_SIZE + i*ELF2BIN_E2BZ_REGION_SIZE) == 0 )
+      return 0;
+  }
+  for( i = 0; i < block_cnt; i++ )
+  {
+    elf2bin_put_le(rec, block[i].pos, 8);
+    elf2bin_put_le(rec + 8, block[i].data_size, 4);
+    elf2bin_put_le(rec + 12, block[i].size, 4);
+    elf2bin_put_le(rec + 16, block[i].crc, 4);
+    elf2bin_put_le(rec + 20, block[i].is_stored, 4);
+    if ( elf2bin_pwrite(fd, rec, ELF2BIN_E2BZ_INDEX_SIZE, index_pos + i*ELF2BIN_E2BZ_INDEX_SIZE) == 0 )
+      return 0;
+  }
+  return 1;
+}
+
+/*
+  The regions are always split at gaps larger than elf2bin_gap_max, because each region has its own address.
+  With option "-b" the first region starts at elf2bin_base_addr.
+  Each block is filled from the elf file, when it is compressed, so the regions are never in memory.
+*/
+int elf2bin_write_e2bz(int in_fd, const char *outfile, elf2bin_block_struct *list, size_t cnt)
+{
+  elf2bin_zip_struct zip;
+  elf2bin_zregion_struct *region;
+  elf2bin_zblock_struct *block = NULL;
+  unsigned long long end;
+  size_t region_cnt = 0, block_cnt = 0;
+  size_t first, last, i, j, pos, image_size = 0, file_size = 0;
+  int result = 1;
+  int fd;
+  
+  if ( elf2bin_is_base_addr && cnt > 0 && list[0].addr < elf2bin_base_addr )
+    return fprintf(stderr, "elf2bin: load address 0x%llx is below the base address 0x%llx\n", list[0].addr, elf2bin_base_addr), 0;
+  region = (elf2bin_zregion_struct *)calloc(cnt + 1, sizeof(elf2bin_zregion_struct));
+  if ( region == NULL )
+    return fprintf(stderr, "elf2bin: out of memory\n"), 0;
+  
+  for( first = 0; first < cnt; first = last )
+  {
+    last = elf2bin_get_region_last(list, cnt, first);
+    region[region_cnt].addr = elf2bin_is_base_addr && first == 0 ? elf2bin_base_addr : list[first].addr;
+    end = region[region_cnt].addr;
+    for( i = first; i < last; i++ )
+      if ( list[i].addr + list[i].size > end )
+        end = list[i].addr + list[i].size;
+    region[region_cnt].size = end - region[region_cnt].addr;
+    region[region_cnt].first_block = block_cnt;
+    block_cnt += (region[region_cnt].size + ELF2BIN_E2BZ_BLOCK_SIZE - 1) / ELF2BIN_E2BZ_BLOCK_SIZE;
+    image_size += region[region_cnt].size;
+    printf("%08llx-%08llx: %s\n", region[region_cnt].addr, end, outfile);
+    region_cnt++;
+  }
+  
+  block = (elf2bin_zblock_struct *)calloc(block_cnt + 1, sizeof(elf2bin_zblock_struct));
+  if ( block == NULL )
+    return free(region), fprintf(stderr, "elf2bin: out of memory\n"), 0;
+  for( i = 0; i < region_cnt; i++ )
+    for( pos = 0, j = region[i].first_block; pos < region[i].size; pos += ELF2BIN_E2BZ_BLOCK_SIZE, j++ )
+    {
+      block[j].addr = region[i].addr + pos;
+      block[j].size = region[i].size - pos > ELF2BIN_E2BZ_BLOCK_SIZE ? ELF2BIN_E2BZ_BLOCK_SIZE : region[i].size - pos;
+    }
+  
+  // S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH
+  fd = creat(outfile, S_IRWXU);
+  if ( fd < 0 )
+    result = (perror(outfile), 0);
+  else
+  {
+    memset(&zip, 0, sizeof(zip));
+    zip.in_fd = in_fd;
+    zip.list = list;
+    zip.list_cnt = cnt;
+    zip.block = block;
+    zip.cnt = block_cnt;
+    pthread_mutex_init(&(zip.mutex), NULL);
+    pthread_cond_init(&(zip.cond), NULL);
+    pos = ELF2BIN_E2BZ_HEADER_SIZE + region_cnt*ELF2BIN_E2BZ_REGION_SIZE;
+    result = elf2bin_write_e2bz_blocks(&zip, fd, pos);
+    pthread_cond_destroy(&(zip.cond));
+    pthread_mutex_destroy(&(zip.mutex));
+    if ( result != 0 )
+    {
+      file_size = block_cnt > 0 ? block[block_cnt-1].pos + block[block_cnt-1].data_size : pos;
+      if ( elf2bin_write_e2bz_index(fd, region, region_cnt, block, block_cnt, file_size) == 0 )
+        result = (perror(outfile), 0);
+      file_size += block_cnt*ELF2BIN_E2BZ_INDEX_SIZE;
+    }
+    if ( close(fd) != 0 )
+      result = (perror(outfile), 0);
+    if ( result == 0 )
+      unlink(outfile);
+  }
+  if ( result != 0 )
+    printf("%s: %lu bytes (image %lu bytes, %lu blocks)\n", outfile, 
+      (unsigned long)file_size, (unsigned long)image_size, (unsigned long)block_cnt);
+  
+  for( i = 0; i < block_cnt; i++ )
+    free(block[i].data);
+  free(block);
+  free(region);
+  return result;
+}
+
+/*
+  Reader for the E2BZ container: elf2bin_e2bz_open() reads the header, the regions and the block index,
+  elf2bin_e2bz_read() decompresses only the blocks of the requested address range.
+*/
+struct _elf2bin_e2bz_struct
+{
+  int fd;
+  size_t block_size;
+  size_t region_cnt;
+  size_t block_cnt;
+  unsigned char *region;        // ELF2BIN_E2BZ_REGION_SIZE bytes for each region
+  unsigned char *index;         // ELF2BIN_E2BZ_INDEX_SIZE bytes for each block
+  unsigned char *data;          // compressed data of one block
+  unsigned char *buf;           // uncompressed data of block buf_block
+  size_t buf_block;             // (size_t)-1 if buf is empty
+  ZSTD_DCtx *dctx;
+};
+typedef struct _elf2bin_e2bz_struct elf2bin_e2bz_struct;
+
+void elf2bin_e2bz_close(elf2bin_e2bz_struct *z)
+{
+  free(z->region);
+  free(z->index);
+  free(z->data);
+  free(z->buf);
+  if ( z->dctx != NULL )
+    ZSTD_freeDCtx(z->dctx);
+  memset(z, 0, sizeof(elf2bin_e2bz_struct));
+  z->fd = -1;
+}
+
+/* returns 0 if fd is not a valid E2BZ container */
+int elf2bin_e2bz_open(elf2bin_e2bz_struct *z, int fd)
+{
+  unsigned char head[ELF2BIN_E2BZ_HEADER_SIZE];
+  size_t index_pos, i;
+  
+  memset(z, 0, sizeof(elf2bin_e2bz_struct));
+  z->fd = fd;
+  z->buf_block = (size_t)-1;
+  if ( elf2bin_pread(fd, head, ELF2BIN_E2BZ_HEADER_SIZE, 0) == 0 || memcmp(head, "E2BZ", 4) != 0 || head[4] != 1 )
+    return fprintf(stderr, "elf2bin: not an e2bz container\n"), 0;
+  z->block_size = elf2bin_get_le(head + 8, 4);
+  z->region_cnt = elf2bin_get_le(head + 12, 4);
+  z->block_cnt = elf2bin_get_le(head + 16, 8);
+  index_pos = elf2bin_get_le(head + 24, 8);
+  if ( z->block_size == 0 || z->block_cnt > ((size_t)-1)/ELF2BIN_E2BZ_INDEX_SIZE )
+    return fprintf(stderr, "elf2bin: corrupted e2bz header\n"), 0;
+  z->region = (unsigned char *)malloc(z->region_cnt*ELF2BIN_E2BZ_REGION_SIZE + 1);
+  z->index = (unsigned char *)malloc(z->block_cnt*ELF2BIN_E2BZ_INDEX_SIZE + 1);
+  z->data = (unsigned char *)malloc(ZSTD_compressBound(z->block_size));
+  z->buf = (unsigned char *)malloc(z->block_size);
+  z->dctx = ZSTD_createDCtx();
+  if ( z->region == NULL || z->index == NULL || z->data == NULL || z->buf == NULL || z->dctx == NULL )
+    return elf2bin_e2bz_close(z), fprintf(stderr, "elf2bin: out of memory\n"), 0;
+  if ( elf2bin_pread(fd, z->region, z->region_cnt*ELF2BIN_E2BZ_REGION_SIZE, ELF2BIN_E2BZ_HEADER_SIZE) == 0
+    || elf2bin_pread(fd, z->index, z->block_cnt*ELF2BIN_E2BZ_INDEX_SIZE, index_pos) == 0 )
+    return elf2bin_e2bz_close(z), fprintf(stderr, "elf2bin: corrupted e2bz container\n"), 0;
+  for( i = 0; i < z->block_cnt; i++ )
+    if ( elf2bin_get_le(z->index + i*ELF2BIN_E2BZ_INDEX_SIZE + 12, 4) > z->block_size 
+      || elf2bin_get_le(z->index + i*ELF2BIN_E2BZ_INDEX_SIZE + 8, 4) > ZSTD_compressBound(z->block_size) )
+      return elf2bin_e2bz_close(z), fprintf(stderr, "elf2bin: corrupted e2bz block index\n"), 0;
+  return 1;
+}
+
+/* decompress block i into z->buf and check the crc32 */
+int elf2bin_e2bz_load_block(elf2bin_e2bz_struct *z, size_t i)
+{
+  const unsigned char *rec = z->index + i*ELF2BIN_E2BZ_INDEX_SIZE;
+  size_t data_size = elf2bin_get_le(rec + 8, 4);
+  size_t size = elf2bin_get_le(rec + 12, 4);
+  size_t r;
+  
+  if ( z->buf_block == i )
+    return 1;
+  z->buf_block = (size_t)-1;
+  if ( elf2bin_pread(z->fd, z->data, data_size, elf2bin_get_le(rec, 8)) == 0 )
+    return fprintf(stderr, "elf2bin: e2bz block %lu not available\n", (unsigned long)i), 0;
+  if ( elf2bin_get_le(rec + 20, 4) & 1 )
+  {
+    if ( data_size != size )
+      return fprintf(stderr, "elf2bin: e2bz block %lu corrupted\n", (unsigned long)i), 0;
+    memcpy(z->buf, z->data, size);
+  }
+  else
+  {
+    r = ZSTD_decompressDCtx(z->dctx, z->buf, z->block_size, z->data, data_size);
+    if ( ZSTD_isError(r) || r != size )
+      return fprintf(stderr, "elf2bin: e2bz block %lu corrupted\n", (unsigned long)i), 0;
+  }
+  elf2bin_init_crc_table();
+  if ( elf2bin_update_crc(0, z->buf, size) != (unsigned long)elf2bin_get_le(rec + 16, 4) )
+    return fprintf(stderr, "elf2bin: crc32 error in e2bz block %lu\n", (unsigned long)i), 0;
+  z->buf_block = i;
+  return 1;
+}
+
+/* 
+  copy the address range addr ... addr+size-1 into buf, the range must be inside one region,
+  returns 0 if the range is not available
+*/
+int elf2bin_e2bz_read(elf2bin_e2bz_struct *z, unsigned long long addr, unsigned char *buf, size_t size)
+{
+  const unsigned char *rec;
+  unsigned long long region_addr, region_size, offset;
+  size_t i, block, len;
+  
+  for( i = 0; i < z->region_cnt; i++ )
+  {
+    rec = z->region + i*ELF2BIN_E2BZ_REGION_SIZE;
+    region_addr = elf2bin_get_le(rec, 8);
+    region_size = elf2bin_get_le(rec + 8, 8);
+    if ( addr >= region_addr && addr - region_addr <= region_size && size <= region_size - (addr - region_addr) )
+      break;
+  }
+  if ( i >= z->region_cnt )
+    return fprintf(stderr, "elf2bin: range 0x%llx-0x%llx is not part of the e2bz container\n", addr, addr + size), 0;
+  while( size > 0 )
+  {
+    offset = addr - region_addr;
+    block = elf2bin_get_le(rec + 16, 8) + offset / z->block_size;
+    if ( block >= z->block_cnt || elf2bin_e2bz_load_block(z, block) == 0 )
+      return 0;
+    len = z->block_size - offset % z->block_size;
+    if ( len > size )
+      len = size;
+    memcpy(buf, z->buf + offset % z->block_size, len);
+    buf += len;
+    addr += len;
+    size -= len;
+  }
+  return 1;
+}
+
+/*
+  Extract the regions of an E2BZ container into binary files (option "-x"), the file names are the 
+  same as for the binary output: outfile for a single region, otherwise the address is added to the name.
+*/
+int elf2bin_extract_e2bz(const char *infile, const char *outfile)
+{
+  elf2bin_e2bz_struct z;
+  unsigned long long addr, size;
+  unsigned char *buf;
+  char *filename;
+  size_t i, pos, len;
+  int result = 1;
+  int in_fd, fd;
+  
+  in_fd = open(infile, O_RDONLY | O_BINARY);
+  if ( in_fd < 0 )
+    return perror(infile), 0;
+  if ( elf2bin_e2bz_open(&z, in_fd) == 0 )
+    return close(in_fd), 0;
+  buf = (unsigned char *)malloc(z.block_size);
+  if ( buf == NULL )
+    return elf2bin_e2bz_close(&z), close(in_fd), fprintf(stderr, "elf2bin: out of memory\n"), 0;
+  for( i = 0; i < z.region_cnt && result != 0; i++ )
+  {
+    addr = elf2bin_get_le(z.region + i*ELF2BIN_E2BZ_REGION_SIZE, 8);
+    size = elf2bin_get_le(z.region + i*ELF2BIN_E2BZ_REGION_SIZE + 8, 8);
+    filename = z.region_cnt == 1 ? (char *)outfile : elf2bin_get_region_filename(outfile, addr);
+    if ( filename == NULL )
+    {
+      result = 0;
+      break;
+    }
+    printf("%08llx-%08llx: %s\n", addr, addr + size, filename);
+    // S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH
+    fd = creat(filename, S_IRWXU);
+    if ( fd < 0 )
+      result = (perror(filename), 0);
+    for( pos = 0; pos < size && result != 0; pos += len )
+    {
+      len = size - pos > z.block_size ? z.block_size : size - pos;
+      if ( elf2bin_e2bz_read(&z, addr + pos, buf, len) == 0 )
+        result = 0;
+      else if ( elf2bin_pwrite(fd, buf, len, pos) == 0 )
+        result = (perror(filename), 0);
+    }
+    if ( fd >= 0 && close(fd) != 0 )
+      result = (perror(filename), 0);
+    if ( fd >= 0 && result == 0 )
+      unlink(filename);
+    if ( filename != outfile )
+      free(filename);
+  }
+  free(buf);
+  elf2bin_e2bz_close(&z);
+  close(in_fd);
+  return result;
+}
 
 /*==========================================*/
+/* Format Selection */
 
+/* derive the output format from the extension of the output file */
+int elf2bin_get_format_by_name(const char *outfile)
+{
+  const char *ext = strrchr(outfile, '.');
+  if ( ext == NULL )
+    return ELF2BIN_FORMAT_BINARY;
+  if ( strcmp(ext, ".hex") == 0 || strcmp(ext, ".ihex") == 0 || strcmp(ext, ".ihx") == 0 )
+    return ELF2BIN_FORMAT_IHEX;
+  if ( strcmp(ext, ".srec") == 0 || strcmp(ext, ".mot") == 0 )
+    return ELF2BIN_FORMAT_SREC;
+  if ( strcmp(ext, ".s19") == 0 )
+    return ELF2BIN_FORMAT_S19;
+  if ( strcmp(ext, ".s28") == 0 )
+    return ELF2BIN_FORMAT_S28;
+  if ( strcmp(ext, ".s37") == 0 )
+    return ELF2BIN_FORMAT_S37;
+  if ( strcmp(ext, ".e2bz") == 0 )
+    return ELF2BIN_FORMAT_E2BZ;
+  return ELF2BIN_FORMAT_BINARY;
+}
 
-int elf2bin(Elf *elf, const char *outfile)
+/* returns -1 for an unknown format name */
+int elf2bin_get_format_by_option(const char *name)
 {
-  Elf_Scn  *scn  = NULL;
-  GElf_Shdr shdr;
-  size_t block_addr = 0;
+  if ( strcmp(name, "binary") == 0 ) return ELF2BIN_FORMAT_BINARY;
+  if ( strcmp(name, "ihex") == 0 ) return ELF2BIN_FORMAT_IHEX;
+  if ( strcmp(name, "srec") == 0 ) return ELF2BIN_FORMAT_SREC;
+  if ( strcmp(name, "s19") == 0 ) return ELF2BIN_FORMAT_S19;
+  if ( strcmp(name, "s28") == 0 ) return ELF2BIN_FORMAT_S28;
+  if ( strcmp(name, "s37") == 0 ) return ELF2BIN_FORMAT_S37;
+  if ( strcmp(name, "e2bz") == 0 ) return ELF2BIN_FORMAT_E2BZ;
+  return -1;
+}
+
+/* binary output with the optional checksums (options "-s", "-c" and "-f") */
+int elf2bin_write_binary_output(Elf *elf, int elf_fd, GElf_Ehdr *ehdr, const char *outfile, elf2bin_block_struct *list, size_t cnt)
+{
+  elf2bin_digest_struct *d;
+  char sha[65];
+  int result;
+  
+  if ( elf2bin_is_digest == 0 && elf2bin_is_gap_fill == 0 && elf2bin_crc_symbol == NULL )
+    return elf2bin_write_binary_regions(elf_fd, outfile, list, cnt, NULL);
+  
+  d = (elf2bin_digest_struct *)malloc(sizeof(elf2bin_digest_struct));
+  if ( d == NULL )
+    return fprintf(stderr, "elf2bin: out of memory\n"), 0;
+  memset(d, 0, sizeof(elf2bin_digest_struct));
+  elf2bin_init_crc_table();
+  elf2bin_sha256_init(&(d->image_sha));
+  d->is_msb = ehdr->e_ident[EI_DATA] == ELFDATA2MSB;
+  if ( elf2bin_crc_symbol != NULL )
+  {
+    if ( elf2bin_get_symbol_lma(elf, elf2bin_crc_symbol, &(d->crc_addr)) == 0 )
+      return free(d), 0;
+    d->is_crc_addr = 1;
+  }
+  result = elf2bin_write_binary_regions(elf_fd, outfile, list, cnt, d);
+  if ( result != 0 && d->is_crc_addr != 0 && d->is_crc_stored == 0 )
+  {
+    fprintf(stderr, "elf2bin: address 0x%llx of symbol %s is not part of the binary output\n", d->crc_addr, elf2bin_crc_symbol);
+    result = 0;
+  }
+  if ( result != 0 && elf2bin_is_digest )
+  {
+    elf2bin_sha256_get_hex(&(d->image_sha), sha);
+    printf("image: crc32 %08lx sha256 %s\n", d->image_crc, sha);
+  }
+  free(d);
+  return result;
+}
+
+/*==========================================*/
+
+/* elf_fd is the file descriptor of the elf file, which was passed to elf_begin() */
+int elf2bin(Elf *elf, int elf_fd, const char *outfile, int format)
+{
+  GElf_Ehdr ehdr;
+  elf2bin_block_struct *list;
+  elf2bin_out_struct *out;
+  size_t cnt;
+  int result;
   
   if ( elf_kind( elf ) != ELF_K_ELF )
   {
     fprintf(stderr, "Not an elf file (found kind %d)\n", elf_kind( elf ));
     return 0;
   }
+  if ( gelf_getehdr(elf, &ehdr) == NULL )
+    return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
+  
+  list = elf2bin_get_block_list(elf, elf_fd, format == ELF2BIN_FORMAT_BINARY || format == ELF2BIN_FORMAT_E2BZ, &cnt);
+  if ( list == NULL )
+    return 0;
+  if ( elf2bin_check_overlap(list, cnt) == 0 )
+    return free(list), 0;
+  
+  if ( format == ELF2BIN_FORMAT_E2BZ )
+  {
+    result = elf2bin_write_e2bz(elf_fd, outfile, list, cnt);
+    free(list);
+    return result;
+  }
+  
+  if ( format == ELF2BIN_FORMAT_BINARY )
+  {
+#if defined(ELF2BIN_MMAP)
+    struct stat st;
+    void *map;
+    /* if the elf file can't be mapped, then the blocks are read with pread() */
+    if ( elf2bin_is_mmap && fstat(elf_fd, &st) == 0 && st.st_size > 0 )
+    {
+      map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, elf_fd, 0);
+      if ( map != MAP_FAILED )
+      {
+        elf2bin_in_map = (const unsigned char *)map;
+        elf2bin_in_map_size = (size_t)st.st_size;
+      }
+    }
+#endif
+    result = elf2bin_write_binary_output(elf, elf_fd, &ehdr, outfile, list, cnt);
+#if defined(ELF2BIN_MMAP)
+    if ( elf2bin_in_map != NULL )
+      munmap((void *)elf2bin_in_map, elf2bin_in_map_size);
+    elf2bin_in_map = NULL;
+    elf2bin_in_map_size = 0;
+#endif
+    free(list);
+    return result;
+  }
+
+  /* check the address range first, so that no output file is created for an invalid format */
+  if ( elf2bin_check_record_format(list, cnt, ehdr.e_entry, &format) == 0 )
+    return free(list), 0;
 
   // S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH
   int fd = creat(outfile, S_IRWXU);
   if ( fd < 0 )
   {
     perror(outfile);
+    free(list);
     return 0;
   }
   
-  printf("address   size      starting values...\n");
-
-  /* loop over all sections */
-  while (( scn = elf_nextscn(elf, scn)) != NULL ) 
+  out = (elf2bin_out_struct *)malloc(sizeof(elf2bin_out_struct));
+  if ( out == NULL )
+    return close(fd), unlink(outfile), free(list), fprintf(stderr, "elf2bin: out of memory\n"), 0;
+  out->fd = fd;
+  out->len = 0;
+  out->is_error = 0;
+  elf2bin_init_hex_table();
+  if ( format == ELF2BIN_FORMAT_IHEX )
+    result = elf2bin_write_ihex(out, list, cnt, ehdr.e_entry);
+  else
+    result = elf2bin_write_srec(out, list, cnt, ehdr.e_entry, format, outfile);
+  if ( elf2bin_out_flush(out) == 0 )
   {
-    if ( gelf_getshdr( scn, &shdr ) != &shdr )
-      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
-    if ( (shdr.sh_flags & SHF_ALLOC) != 0 && shdr.sh_size > 0 )
-    {
-      /* loop over the data blocks of the section */
-      Elf_Data *data = NULL;
-      for(;;)
-      {
-        data = elf_getdata(scn , data);     // if data==NULL return first data, otherwise return next data
-        if ( data == NULL )
-          break;
-        if ( data->d_buf == NULL )
-          break;
-        
-        block_addr = shdr.sh_addr + data->d_off;    // calculate the address of this data in the target system, not 100% sure whether this is correct
-        /* data->d_size contains the size of the block, data->d_buf a ptr to the internal memory */
-        {
-          size_t i;
-          size_t cnt = data->d_size;
-          if ( cnt > 16 )
-            cnt = 16;
-          /* output address and size to stdout */
-          printf("%08lx: %08lx ", (unsigned long)block_addr, (unsigned long)data->d_size);
-
-          /* output first 16 data values of the section */
-          for( i = 0; i < cnt; i++ )
-          {
-            printf(" %02x", ((unsigned char *)data->d_buf)[i]);
-          }
-          printf("\n");          
-        }
-        
-        lseek(fd, block_addr, SEEK_SET);
-        write(fd, data->d_buf, data->d_size);        
-      }
-    }
+    perror(outfile);
+    result = 0;
   }
-  close(fd);
-  return 1;
+  free(out);
+  if ( close(fd) != 0 )
+  {
+    perror(outfile);
+    result = 0;
+  }
+  if ( result == 0 )
+    unlink(outfile);      // don't leave an incomplete output file
+  free(list);
+  return result;
 }
 
+/*
+  elf2bin [-O <format>] [-b <base>] [-g <gap>] [-j <threads>] [-f <fill>] [-s] [-c <symbol>] [-m] [-d <previous> [-z]] <input.elf> <output>
+    -O    output format: binary, ihex, srec, s19, s28, s37 or e2bz (compressed container)
+          default: derived from the extension of <output> (.hex, .srec, .s19, .s28, .s37, .e2bz), otherwise binary
+    -b    binary output: address of the first byte of the binary file (default: lowest load address)
+    -g    binary output: max gap in bytes between two blocks of the same binary file (default: 0x10000), 
+          a larger gap starts a new binary file
+    -j    number of threads for binary, delta and e2bz output (default: 4)
+    -f    binary and e2bz output: fill the gaps between the sections with this byte value (default: 0)
+    -s    binary output: write crc32 and sha256 of each binary file and of all binary files to stdout
+    -c    binary output: store the crc32 of all bytes from the start of the binary file up to the symbol
+          at the address of the symbol (4 bytes, byte order of the elf file)
+    -m    binary output: assemble the binary file in a memory mapping of the file instead of writing each section
+    -d    binary output: write the delta against the previous binary file to <output>.delta
+    -z    compress the literals of the delta with zstd
+  elf2bin -x <input.e2bz> <output>
+    -x    extract the regions of an e2bz container into binary files (same file names as for the binary output)
+  elf2bin -a <previous> <input.delta> <output>
+    -a    apply the delta (option "-d") to the previous binary file and write the new binary file
+  Numbers can be decimal or hex (0x prefix). -c, -s and -d are rejected for other output formats, 
+  -f is rejected for ihex and S-records.
+*/
 int main(int argc, char **argv)
 {
   int fd = -1;
   Elf *elf = NULL;
   char *elf_filename = NULL;
-  if ( argc < 3 )
+  char *out_filename = NULL;
+  int format = -1;
+  int i;
+  
+  for( i = 1; i < argc; i++ )
+  {
+    if ( strcmp(argv[i], "-O") == 0 && i+1 < argc )
+    {
+      format = elf2bin_get_format_by_option(argv[++i]);
+      if ( format < 0 )
+        return fprintf(stderr, "Unknown output format '%s'\n", argv[i]), 1;
+    }
+    else if ( strcmp(argv[i], "-b") == 0 && i+1 < argc )
+    {
+      elf2bin_base_addr = strtoull(argv[++i], NULL, 0);
+      elf2bin_is_base_addr = 1;
+    }
+    else if ( strcmp(argv[i], "-g") == 0 && i+1 < argc )
+      elf2bin_gap_max = strtoull(argv[++i], NULL, 0);
+    else if ( strcmp(argv[i], "-j") == 0 && i+1 < argc )
+      elf2bin_thread_cnt = atoi(argv[++i]);
+    else if ( strcmp(argv[i], "-f") == 0 && i+1 < argc )
+    {
+      elf2bin_gap_fill = (int)strtoul(argv[++i], NULL, 0) & 255;
+      elf2bin_is_gap_fill = 1;
+    }
+    else if ( strcmp(argv[i], "-s") == 0 )
+      elf2bin_is_digest = 1;
+    else if ( strcmp(argv[i], "-d") == 0 && i+1 < argc )
+      elf2bin_delta_old = argv[++i];
+    else if ( strcmp(argv[i], "-z") == 0 )
+      elf2bin_is_delta_zstd = 1;
+    else if ( strcmp(argv[i], "-m") == 0 )
+      elf2bin_is_mmap = 1;
+    else if ( strcmp(argv[i], "-c") == 0 && i+1 < argc )
+      elf2bin_crc_symbol = argv[++i];
+    else if ( strcmp(argv[i], "-x") == 0 )
+      elf2bin_is_extract = 1;
+    else if ( strcmp(argv[i], "-a") == 0 && i+1 < argc )
+      elf2bin_apply_old = argv[++i];
+    else if ( elf_filename == NULL )
+      elf_filename = argv[i];
+    else
+      out_filename = argv[i];
+  }
+  if ( elf_filename == NULL || out_filename == NULL )
   {
-    printf("%s <input.elf> <output.bin>\n", argv[0]);
+    printf("%s [-O binary|ihex|srec|s19|s28|s37|e2bz] [-b <base>] [-g <gap>] [-j <threads>] [-f <fill>] [-s] [-c <symbol>] [-m] [-d <previous> [-z]] <input.elf> <output>\n", argv[0]);
+    printf("%s -x <input.e2bz> <output>\n", argv[0]);
+    printf("%s -a <previous> <input.delta> <output>\n", argv[0]);
     return 1;
   }
+  if ( elf2bin_is_extract )
+    return elf2bin_extract_e2bz(elf_filename, out_filename) ? 0 : 1;
+  if ( elf2bin_apply_old != NULL )
+    return elf2bin_apply_delta(elf2bin_apply_old, elf_filename, out_filename) ? 0 : 1;
+  if ( format < 0 )
+    format = elf2bin_get_format_by_name(out_filename);
+  /* the checksums and the delta are calculated for the binary files only */
+  if ( format != ELF2BIN_FORMAT_BINARY && (elf2bin_crc_symbol != NULL || elf2bin_is_digest || elf2bin_delta_old != NULL) )
+    return fprintf(stderr, "Options -c, -s and -d require binary output\n"), 1;
+  if ( format != ELF2BIN_FORMAT_BINARY && format != ELF2BIN_FORMAT_E2BZ && elf2bin_is_gap_fill )
+    return fprintf(stderr, "Option -f requires binary or e2bz output\n"), 1;
 
   if ( elf_version( EV_CURRENT ) == EV_NONE )
-    return fprintf(stderr, "Incorrect libelf version: %s\n", elf_errmsg(-1) ), 0;
+    return fprintf(stderr, "Incorrect libelf version: %s\n", elf_errmsg(-1) ), 1;
   
-  elf_filename = argv[1];
   fd = open( elf_filename, O_RDONLY | O_BINARY, 0);
   if ( fd >= 0 )
   {
     if (( elf = elf_begin( fd , ELF_C_READ, NULL )) != NULL )
     {
-      if ( elf2bin(elf, argv[2]) )
+      if ( elf2bin(elf, fd, out_filename, format) )
       {
         elf_end(elf); 
         close(fd);  
@@ -159,6 +2843,6 @@ int main(int argc, char **argv)
   {
     perror(elf_filename);
   }
-  return 0;
+  return 1;
 }
 
@@ -39,10 +39,13 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <libelf.h>
-#include <gelf.h>
+#include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#include "relf.h"
+#include "relfdwarf.h"
 
 /*==========================================*/
 /* Target System Special Code */
@@ -62,165 +65,124 @@ void __attribute__ ((noreturn)) __stack_chk_fail (void)
 
 
 /*==========================================*/
-/* CRC32 from https://datatracker.ietf.org/doc/html/rfc1952#section-8 */
-/* updated names and data-types */
-
-/* Table of CRCs of all 8-bit messages. */
-unsigned long crc_table[256];
+/* String Dictionary */
+/*
+  Each unique string gets an index, starting with 0.
+  With option "-d" the names of sections and symbols are written only once into
+  the "string_list" of the JSON output. All other places refer to this string
+  with the index into the "string_list".
+
+  The strings itself are not copied: The dictionary stores the pointers returned 
+  by elf_strptr(), which stay valid until elf_end() is called.
+  The hash table is an open addressing table, which contains the string index + 1
+  (value 0 marks an empty slot).
+*/
 
-/* Flag: has the table been computed? Initially false. */
-int is_crc_table_computed = 0;
+struct _relf_strdict_struct
+{
+  const char **list;            // list of strings, index is the string index
+  size_t cnt;                   // number of strings in "list"
+  size_t list_max;              // allocated size of "list"
+  size_t *hash_table;           // string index + 1, 0 for an empty slot
+  size_t hash_size;             // number of slots in hash_table, always a power of 2
+};
+typedef struct _relf_strdict_struct relf_strdict_struct;
 
-/* Make the table for a fast CRC. */
-void compute_crc_table(void)
+/* FNV-1a hash */
+size_t relf_strdict_hash(const char *s)
 {
-  unsigned long c;
-  int n, k;
-  for (n = 0; n < 256; n++) 
+  size_t h = (size_t)2166136261UL;
+  while( *s != '\0' )
   {
-    c = (unsigned long) n;
-    for (k = 0; k < 8; k++) 
-    {
-      if (c & 1) 
-      {
-        c = 0xedb88320L ^ (c >> 1);
-      } 
-      else 
-      {
-        c = c >> 1;
-      }
-    }
-    crc_table[n] = c;
+    h ^= (unsigned char)*s++;
+    h *= (size_t)16777619UL;
   }
-  is_crc_table_computed = 1;
+  return h;
 }
 
-/*
- Update a running crc with the bytes buf[0..len-1] and return
- the updated crc. The crc should be initialized to zero. Pre- and
- post-conditioning (one's complement) is performed within this
- function so it shouldn't be done by the caller. Usage example:
-
-   unsigned long crc = 0L;
-
-   while (read_buffer(buffer, length) != EOF) {
-     crc = update_crc(crc, buffer, length);
-   }
-   if (crc != original_crc) error();
-*/
-unsigned long update_crc(unsigned long crc, unsigned char *buf, size_t len)
+int relf_strdict_init(relf_strdict_struct *strdict)
 {
-  unsigned long c = crc ^ 0xffffffffL;
-  size_t n;
-
-  if (!is_crc_table_computed)
-    compute_crc_table();
-  for (n = 0; n < len; n++) 
-  {
-    c = crc_table[(c ^ buf[n]) & 0xff] ^ (c >> 8);
-  }
-  return c ^ 0xffffffffL;
+  memset(strdict, 0, sizeof(relf_strdict_struct));
+  strdict->list_max = 1024;
+  strdict->list = (const char **)malloc(strdict->list_max*sizeof(const char *));
+  strdict->hash_size = 2048;
+  strdict->hash_table = (size_t *)calloc(strdict->hash_size, sizeof(size_t));
+  if ( strdict->list == NULL || strdict->hash_table == NULL )
+    return fprintf(stderr, "strdict: out of memory\n"), 0;
+  return 1;
 }
 
-/* Return the CRC of the bytes buf[0..len-1]. */
-unsigned long get_crc(unsigned char *buf, size_t len)
+void relf_strdict_destroy(relf_strdict_struct *strdict)
 {
-  return update_crc(0L, buf, len);
+  free(strdict->list);
+  free(strdict->hash_table);
+  memset(strdict, 0, sizeof(relf_strdict_struct));
 }
-      
 
-/*==========================================*/
-
-/* return an SHF_ALLOC section which is most close to the given addess */
-/* addr will be updated */
-Elf_Scn  *get_section_by_address(Elf * e, Elf64_Addr *addr)
+/* returns the index of the string s or (size_t)-1 if not found */
+size_t relf_strdict_find(relf_strdict_struct *strdict, const char *s)
 {
-  Elf64_Addr min_delta;
-  Elf_Scn  *min_scn  = NULL;
-  Elf64_Addr new_addr;
-  
-  GElf_Shdr shdr;
-  Elf_Scn  *scn  = NULL;
-  /* loop over all sections */
-  scn = NULL;
-  while (( scn = elf_nextscn(e, scn)) != NULL ) 
-  {
-    if ( gelf_getshdr( scn, &shdr ) != &shdr )
-      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
-    if ( (shdr.sh_flags & SHF_ALLOC) != 0 && shdr.sh_size > 0 )
-    {
-      if ( shdr.sh_addr >= *addr )
-      {
-        if ( min_delta > shdr.sh_addr -  *addr )
-        {
-          min_delta = shdr.sh_addr -  *addr;
-          min_scn = scn;
-          new_addr = shdr.sh_addr + shdr.sh_size;
-        }
-      }
-    }
-  }
-  if ( min_scn != NULL )
+  size_t mask = strdict->hash_size - 1;
+  size_t pos = relf_strdict_hash(s) & mask;
+  while( strdict->hash_table[pos] != 0 )
   {
-    /*
-    if ( gelf_getshdr( min_scn, &shdr ) != &shdr )
-      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
-    fprintf(stderr, "%09lx: %09lx %09lx\n", *addr, shdr.sh_addr, shdr.sh_size);
-    */
-    *addr = new_addr;
+    if ( strcmp(strdict->list[strdict->hash_table[pos]-1], s) == 0 )
+      return strdict->hash_table[pos]-1;
+    pos = (pos + 1) & mask;
   }
-  return min_scn;
+  return (size_t)-1;
 }
 
-/* return symbel with index sym_idx from section with the number scn_idx */
-const GElf_Sym *get_symbol(Elf *elf, size_t scn_idx, int sym_idx)
+/* double the size of the hash table, the hash table should be at most half full */
+int relf_strdict_grow_hash_table(relf_strdict_struct *strdict)
 {
-  static GElf_Sym symbol;
-  
-  Elf_Scn *scn = elf_getscn(elf, scn_idx);
-  if ( scn != NULL )
+  size_t new_size = strdict->hash_size*2;
+  size_t *new_table = (size_t *)calloc(new_size, sizeof(size_t));
+  size_t i, pos;
+  if ( new_table == NULL )
+    return fprintf(stderr, "strdict: out of memory\n"), 0;
+  for( i = 0; i < strdict->cnt; i++ )
   {
-    // Elf_Data *elf_getdata (Elf_Scn *__scn, Elf_Data *__data);
-    Elf_Data *data = NULL;
-    size_t symbols_per_data;
-    GElf_Shdr shdr;
-    if ( gelf_getshdr( scn, &shdr ) != &shdr )
-      return NULL;
-    
-    for(;;)
-    {
-      data = elf_getdata(scn , data);     // if data==NULL return first data, otherwise return next data
-      if ( data == NULL )
-        return NULL;
-      symbols_per_data = data->d_size / shdr.sh_entsize;
-      assert(shdr.sh_entsize*symbols_per_data == data->d_size);
-      if ( sym_idx < symbols_per_data )
-        break;
-      sym_idx -= data->d_size / shdr.sh_entsize;
-    }
-    return gelf_getsym(data, sym_idx, &symbol);
+    pos = relf_strdict_hash(strdict->list[i]) & (new_size-1);
+    while( new_table[pos] != 0 )
+      pos = (pos + 1) & (new_size-1);
+    new_table[pos] = i+1;
   }
-  return NULL;
+  free(strdict->hash_table);
+  strdict->hash_table = new_table;
+  strdict->hash_size = new_size;
+  return 1;
 }
 
-const char *get_symbol_name(Elf *elf, size_t scn_idx, int sym_idx)
+/* add string s to the dictionary (if not yet there), returns 0 on error */
+int relf_strdict_add(relf_strdict_struct *strdict, const char *s)
 {
-  const GElf_Sym *sym = get_symbol(elf, scn_idx, sym_idx);
-  if ( sym != NULL )
+  size_t pos;
+  if ( s == NULL )
+    return 1;
+  if ( relf_strdict_find(strdict, s) != (size_t)-1 )
+    return 1;
+  if ( strdict->cnt >= strdict->list_max )
   {
-    Elf_Scn *scn = elf_getscn(elf, scn_idx);
-    GElf_Shdr shdr;
-    if ( gelf_getshdr( scn, &shdr ) != &shdr )
-      return NULL;
-
-    return elf_strptr(elf, shdr.sh_link, sym->st_name );
+    const char **new_list = (const char **)realloc(strdict->list, strdict->list_max*2*sizeof(const char *));
+    if ( new_list == NULL )
+      return fprintf(stderr, "strdict: out of memory\n"), 0;
+    strdict->list = new_list;
+    strdict->list_max *= 2;
   }
-  return NULL;
+  if ( (strdict->cnt+1)*2 > strdict->hash_size )
+    if ( relf_strdict_grow_hash_table(strdict) == 0 )
+      return 0;
+  pos = relf_strdict_hash(s) & (strdict->hash_size-1);
+  while( strdict->hash_table[pos] != 0 )
+    pos = (pos + 1) & (strdict->hash_size-1);
+  strdict->list[strdict->cnt] = s;
+  strdict->cnt++;
+  strdict->hash_table[pos] = strdict->cnt;
+  return 1;
 }
 
 
-
-
 /*==========================================*/
 /* ELF value, macro names and comments */
 
@@ -1054,6 +1016,129 @@ elf_translate_struct et_d_tag[] = {
   ETNONE()
 };
 
+/* n_type of notes with owner "CORE" or "LINUX" (core files) */
+elf_translate_struct et_core_note_type[] = {
+  ET(  NT_PRSTATUS	, "Contains copy of prstatus struct"),
+  ET(  NT_PRFPREG	, "Contains copy of fpregset struct"),
+  ET(  NT_PRPSINFO	, "Contains copy of prpsinfo struct"),
+  ET(  NT_TASKSTRUCT	, "Contains copy of task structure"),
+  ET(  NT_AUXV		, "Contains copy of auxv array"),
+#ifdef NT_SIGINFO
+  ET(  NT_SIGINFO	, "Contains copy of siginfo_t"),
+#endif
+#ifdef NT_FILE
+  ET(  NT_FILE		, "Contains information about mapped files"),
+#endif
+#ifdef NT_PRXFPREG
+  ET(  NT_PRXFPREG	, "Contains copy of user_fxsr_struct"),
+#endif
+#ifdef NT_X86_XSTATE
+  ET(  NT_X86_XSTATE	, "x86 extended state using xsave"),
+#endif
+  ETNONE()
+};
+
+/* n_type of notes with owner "GNU" */
+elf_translate_struct et_gnu_note_type[] = {
+  ET(  NT_GNU_ABI_TAG	, "ABI information"),
+  ET(  NT_GNU_HWCAP	, "Synthetic hwcap information"),
+  ET(  NT_GNU_BUILD_ID	, "Build ID bits as generated by ld --build-id"),
+  ET(  NT_GNU_GOLD_VERSION	, "Version note generated by GNU gold"),
+#ifdef NT_GNU_PROPERTY_TYPE_0
+  ET(  NT_GNU_PROPERTY_TYPE_0	, "Program property"),
+#endif
+  ETNONE()
+};
+
+#ifndef NT_FDO_PACKAGING_METADATA
+#define NT_FDO_PACKAGING_METADATA 0xcafe1a7e
+#endif
+
+/* n_type of notes with owner "FDO" */
+elf_translate_struct et_fdo_note_type[] = {
+  ET(  NT_FDO_PACKAGING_METADATA	, "Packaging metadata as defined on https://systemd.io/ELF_PACKAGE_METADATA/"),
+  ETNONE()
+};
+
+/* first word of the NT_GNU_ABI_TAG note */
+elf_translate_struct et_abi_tag_os[] = {
+  ET(  ELF_NOTE_OS_LINUX	, "Linux"),
+  ET(  ELF_NOTE_OS_GNU		, "GNU"),
+  ET(  ELF_NOTE_OS_SOLARIS2	, "Solaris"),
+  ET(  ELF_NOTE_OS_FREEBSD	, "FreeBSD"),
+  ETNONE()
+};
+
+#ifdef GNU_PROPERTY_STACK_SIZE
+/* pr_type of the properties in the NT_GNU_PROPERTY_TYPE_0 note */
+elf_translate_struct et_gnu_property_type[] = {
+  ET(  GNU_PROPERTY_STACK_SIZE	, "Stack size"),
+  ET(  GNU_PROPERTY_NO_COPY_ON_PROTECTED	, "No copy relocation on protected data symbol"),
+#ifdef GNU_PROPERTY_1_NEEDED
+  ET(  GNU_PROPERTY_1_NEEDED	, "Features required by the object"),
+#endif
+#ifdef GNU_PROPERTY_X86_FEATURE_1_AND
+  ET(  GNU_PROPERTY_X86_FEATURE_1_AND	, "x86 features (IBT, SHSTK)"),
+#endif
+#ifdef GNU_PROPERTY_X86_ISA_1_NEEDED
+  ET(  GNU_PROPERTY_X86_ISA_1_NEEDED	, "x86 ISA level required by the object"),
+#endif
+#ifdef GNU_PROPERTY_X86_ISA_1_USED
+  ET(  GNU_PROPERTY_X86_ISA_1_USED	, "x86 ISA level used by the object"),
+#endif
+#ifdef GNU_PROPERTY_AARCH64_FEATURE_1_AND
+  ET(  GNU_PROPERTY_AARCH64_FEATURE_1_AND	, "AArch64 features (BTI, PAC)"),
+#endif
+  ETNONE()
+};
+#endif
+
+/* a_type of the NT_AUXV entries */
+elf_translate_struct et_auxv_type[] = {
+  ET(  AT_NULL		, "End of vector"),
+  ET(  AT_IGNORE	, "Entry should be ignored"),
+  ET(  AT_EXECFD	, "File descriptor of program"),
+  ET(  AT_PHDR		, "Program headers for program"),
+  ET(  AT_PHENT	        , "Size of program header entry"),
+  ET(  AT_PHNUM	        , "Number of program headers"),
+  ET(  AT_PAGESZ	, "System page size"),
+  ET(  AT_BASE		, "Base address of interpreter"),
+  ET(  AT_FLAGS	        , "Flags"),
+  ET(  AT_ENTRY	        , "Entry point of program"),
+  ET(  AT_NOTELF	, "Program is not ELF"),
+  ET(  AT_UID		, "Real uid"),
+  ET(  AT_EUID		, "Effective uid"),
+  ET(  AT_GID		, "Real gid"),
+  ET(  AT_EGID		, "Effective gid"),
+  ET(  AT_CLKTCK	, "Frequency of times()"),
+  ET(  AT_PLATFORM	, "String identifying platform"),
+  ET(  AT_HWCAP	        , "Machine-dependent hints about processor capabilities"),
+  ET(  AT_FPUCW	        , "Used FPU control word"),
+  ET(  AT_DCACHEBSIZE	, "Data cache block size"),
+  ET(  AT_ICACHEBSIZE	, "Instruction cache block size"),
+  ET(  AT_UCACHEBSIZE	, "Unified cache block size"),
+  ET(  AT_IGNOREPPC	, "Entry should be ignored"),
+  ET(  AT_SECURE	, "Boolean, was exec setuid-like?"),
+  ET(  AT_BASE_PLATFORM	, "String identifying real platforms"),
+  ET(  AT_RANDOM	, "Address of 16 random bytes"),
+#ifdef AT_HWCAP2
+  ET(  AT_HWCAP2	, "More machine-dependent hints about processor capabilities"),
+#endif
+  ET(  AT_EXECFN	, "Filename of executable"),
+  ET(  AT_SYSINFO	, "Entry point of the vsyscall page"),
+  ET(  AT_SYSINFO_EHDR	, "Address of the vDSO"),
+#ifdef AT_MINSIGSTKSZ
+  ET(  AT_MINSIGSTKSZ	, "Minimal stack size for signal delivery"),
+#endif
+#ifdef AT_RSEQ_FEATURE_SIZE
+  ET(  AT_RSEQ_FEATURE_SIZE	, "rseq supported feature size"),
+#endif
+#ifdef AT_RSEQ_ALIGN
+  ET(  AT_RSEQ_ALIGN	, "rseq allocation alignment"),
+#endif
+  ETNONE()
+};
+
 const char *et_get_macro(elf_translate_struct *et, size_t n)
 {
   size_t i = 0;
@@ -1083,149 +1168,294 @@ const char *et_get_description(elf_translate_struct *et, size_t n)
 }
 
 /*==========================================*/
-/* Read-Onle ELF wrapper for the gelf/elf library */
+/* Output */
+/*
+  All JSON output is done with relf_printf().
+  By default the output goes to stdout. If relf_out is not NULL, then the 
+  output is appended to the memory buffer instead. relf_out is local to
+  each thread, so that several threads can render different parts of
+  the JSON output at the same time (see relf_show_section_list_parallel()).
+*/
+
+struct _relf_buf_struct
+{
+  char *ptr;
+  size_t len;                   // number of bytes in ptr, excluding the terminating '\0'
+  size_t max;                   // allocated size of ptr
+};
+typedef struct _relf_buf_struct relf_buf_struct;
 
+__thread relf_buf_struct *relf_out = NULL;
 
-/* read only elf */
-struct _relf_struct
+void relf_buf_init(relf_buf_struct *buf)
 {
-  int fd;
-  Elf *elf;                                     // elf object, returned from elf_begin
-  
-  size_t section_header_total;               // shdrnum, total number of section headers (each section has a section header, so this is the same as the total number of sectios)
-  size_t section_header_string_table_index;  // shdrstrndx, the index of the section where we find the strings for the the section header names;
-  size_t program_header_total;               // phdrnum, total number of program headers
-  
-  GElf_Ehdr elf_file_header;                    // ehdr elf file header
-  GElf_Shdr section_header;                     // shdr section header
-  
-  size_t symtab_section_index;             // section header index of the ".symtab" section, 0 if not found
-  size_t strtab_section_index;               // section header index of the ".strtab" section, this contains the strings for the symbols from .symtab, 0 if not found
-  size_t dynsym_section_index;          // section header index of the ".dynsym" section, 0 if not found
-  size_t dynstr_section_index;          // section header index of the ".dynstr" section, 0 if not found
+  memset(buf, 0, sizeof(relf_buf_struct));
+}
+
+void relf_buf_destroy(relf_buf_struct *buf)
+{
+  free(buf->ptr);
+  memset(buf, 0, sizeof(relf_buf_struct));
+}
+
+/* ensure that there are at least "size" bytes free in buf, returns 0 on error */
+int relf_buf_reserve(relf_buf_struct *buf, size_t size)
+{
+  size_t new_max;
+  char *new_ptr;
+  if ( buf->len + size <= buf->max )
+    return 1;
+  new_max = buf->max < 4096 ? 4096 : buf->max*2;
+  while( new_max < buf->len + size )
+    new_max *= 2;
+  new_ptr = (char *)realloc(buf->ptr, new_max);
+  if ( new_ptr == NULL )
+    return fprintf(stderr, "relf_buf: out of memory\n"), 0;
+  buf->ptr = new_ptr;
+  buf->max = new_max;
+  return 1;
+}
+
+void relf_printf(const char *fmt, ...)
+{
+  va_list va;
+  int n;
   
+  if ( relf_out == NULL )
+  {
+    va_start(va, fmt);
+    vprintf(fmt, va);
+    va_end(va);
+    return;
+  }
   
+  if ( relf_buf_reserve(relf_out, 256) == 0 )
+    return;
+  for(;;)
+  {
+    va_start(va, fmt);
+    n = vsnprintf(relf_out->ptr + relf_out->len, relf_out->max - relf_out->len, fmt, va);
+    va_end(va);
+    if ( n < 0 )
+      return;
+    if ( (size_t)n < relf_out->max - relf_out->len )
+      break;
+    if ( relf_buf_reserve(relf_out, (size_t)n + 1) == 0 )
+      return;
+  }
+  relf_out->len += n;
+}
+
+/* write len bytes from ptr to the current output */
+void relf_write(const char *ptr, size_t len)
+{
+  if ( relf_out == NULL )
+  {
+    fwrite(ptr, 1, len, stdout);
+    return;
+  }
+  if ( relf_buf_reserve(relf_out, len+1) == 0 )
+    return;
+  memcpy(relf_out->ptr + relf_out->len, ptr, len);
+  relf_out->len += len;
+  relf_out->ptr[relf_out->len] = '\0';
+}
+
+/*==========================================*/
+/* Task Pool */
+/*
+  A task renders a part of the JSON output into its own buffer.
+  Tasks are executed by the worker threads of the pool. A thread, which 
+  waits for a task (relf_pool_wait()), executes other tasks from the queue
+  in the meantime, so tasks may also wait for other tasks.
+*/
+
+typedef struct _relf_task_struct relf_task_struct;
+struct _relf_task_struct
+{
+  int (*fn)(relf_task_struct *task);    // the procedure which renders the task into relf_out
+  relf_struct *relf;
+  Elf_Scn *scn;                 // section for relf_section_task()
+  relf_records_struct *records;  // symbol records for relf_symbol_task()
+  int sh_link;
+  size_t first;                 // range of the symbol index for relf_symbol_task()
+  size_t last;
+  relf_buf_struct buf;          // rendered output of this task
+  int result;                   // return value of fn
+  int is_done;
+  relf_task_struct *next;       // next task in the queue of the pool
+};
+
+struct _relf_pool_struct
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  pthread_t *thread_list;
+  int thread_cnt;               // number of worker threads
+  relf_task_struct *first;      // queue of tasks, which are not yet started
+  relf_task_struct *last;
+  int is_shutdown;
 };
-typedef struct _relf_struct relf_struct;
+typedef struct _relf_pool_struct relf_pool_struct;
 
+/* number of threads for rendering, option "-j" */
+int relf_thread_cnt = 1;
 
+/* the pool for the worker threads, NULL if option "-j" is not used */
+relf_pool_struct *relf_pool = NULL;
 
-// returns NULL if not found
-Elf_Scn *relf_find_scn_by_name(relf_struct *relf, const char *name)
+/* execute a task, must be called without the pool mutex, pool can be NULL to execute the task in the current thread */
+void relf_pool_run_task(relf_pool_struct *pool, relf_task_struct *task)
 {
-  Elf_Scn  *scn;        // section descriptor
-  GElf_Shdr shdr;
-  const char *section_name;
-  /* loop over all sections */
-  scn = elf_nextscn(relf->elf, NULL);
-  while ( scn != NULL ) 
+  relf_buf_struct *prev_out = relf_out;
+  relf_out = &(task->buf);
+  task->result = task->fn(task);
+  relf_out = prev_out;
+  
+  if ( pool == NULL )
   {
-    if ( gelf_getshdr( scn, &shdr ) != &shdr )
-        return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
-    section_name = elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name );
-    if ( section_name == NULL )
-      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
-    if ( strcmp(section_name, name) == 0 )
-      return scn;
-    scn = elf_nextscn(relf->elf, scn);
+    task->is_done = 1;
+    return;
   }
-  return NULL; /* section not found */
+  pthread_mutex_lock(&(pool->mutex));
+  task->is_done = 1;
+  pthread_cond_broadcast(&(pool->cond));
+  pthread_mutex_unlock(&(pool->mutex));
 }
 
-// returns 0 if not found
-size_t relf_find_section_index_by_name(relf_struct *relf, const char *name)
+/* remove the first task from the queue, must be called with the pool mutex */
+relf_task_struct *relf_pool_get_task(relf_pool_struct *pool)
 {
-  Elf_Scn *scn = relf_find_scn_by_name(relf, name);
-  if ( scn == NULL )
-    return 0;
-  return elf_ndxscn( scn ); // returns SHN_UNDEF in case of error, SHN_UNDEF is zero  (elf.h)
+  relf_task_struct *task = pool->first;
+  if ( task != NULL )
+  {
+    pool->first = task->next;
+    if ( pool->first == NULL )
+      pool->last = NULL;
+    task->next = NULL;
+  }
+  return task;
 }
 
-int relf_init(relf_struct *relf, const char *elf_filename)
+void *relf_pool_worker(void *arg)
 {
-  memset(relf, 0, sizeof(relf_struct));
-    
-  if ( elf_version( EV_CURRENT ) == EV_NONE )
-    return fprintf(stderr, "Incorrect libelf version: %s\n", elf_errmsg(-1) ), 0;
-
-  relf->fd = open( elf_filename , O_RDONLY , 0);
-  if ( relf->fd >= 0 )
+  relf_pool_struct *pool = (relf_pool_struct *)arg;
+  relf_task_struct *task;
+  
+  pthread_mutex_lock(&(pool->mutex));
+  for(;;)
   {
-    if (( relf->elf = elf_begin( relf->fd , ELF_C_READ, NULL )) != NULL )
+    task = relf_pool_get_task(pool);
+    if ( task != NULL )
     {
-      if ( elf_kind( relf->elf ) == ELF_K_ELF )
-      {
-        if ( gelf_getehdr(relf->elf, &(relf->elf_file_header) ) != NULL )
-        {
-          if ( elf_getshdrnum(relf->elf, &(relf->section_header_total) ) == 0 )
-          {
-            if ( elf_getshdrstrndx(relf->elf, &(relf->section_header_string_table_index) ) == 0 )
-            {
-              if ( elf_getphdrnum(relf->elf, &(relf->program_header_total) ) == 0 )
-              {
-                /* section index is 0 if not found */
-                relf->symtab_section_index = relf_find_section_index_by_name(relf, ".symtab"); 
-                relf->strtab_section_index = relf_find_section_index_by_name(relf, ".strtab"); 
-                relf->dynsym_section_index = relf_find_section_index_by_name(relf, ".dynsym"); 
-                relf->dynstr_section_index = relf_find_section_index_by_name(relf, ".dynstr"); 
-                
-                return 1;
-              }
-              else
-              {
-                fprintf(stderr, "elf_getphdrnum failed: %s\n", elf_errmsg(-1));
-              }
-            }
-            else
-            {
-              fprintf(stderr, "elf_getshdrstrndx failed: %s\n", elf_errmsg(-1));
-            }
-          }
-          else
-          {
-            fprintf(stderr, "elf_getshdrnum failed: %s\n", elf_errmsg(-1));
-          }
-        }
-        else
-        {
-          fprintf(stderr, "Unable to get elf file header: %s\n", elf_errmsg(-1));
-        }
-      }
-      else
-      {
-        fprintf(stderr, "Not an elf file (found kind %d)\n", elf_kind( relf->elf ));
-      }
-      elf_end(relf->elf);
+      pthread_mutex_unlock(&(pool->mutex));
+      relf_pool_run_task(pool, task);
+      pthread_mutex_lock(&(pool->mutex));
     }
     else
     {
-      fprintf(stderr, "elf_begin failed: %s\n", elf_errmsg(-1));
+      if ( pool->is_shutdown )
+        break;
+      pthread_cond_wait(&(pool->cond), &(pool->mutex));
     }
-    close(relf->fd);
   }
-  else
+  pthread_mutex_unlock(&(pool->mutex));
+  return NULL;
+}
+
+int relf_pool_init(relf_pool_struct *pool, int thread_cnt)
+{
+  int i;
+  memset(pool, 0, sizeof(relf_pool_struct));
+  pthread_mutex_init(&(pool->mutex), NULL);
+  pthread_cond_init(&(pool->cond), NULL);
+  pool->thread_list = (pthread_t *)malloc(sizeof(pthread_t)*thread_cnt);
+  if ( pool->thread_list == NULL )
+    return fprintf(stderr, "relf_pool: out of memory\n"), 0;
+  for( i = 0; i < thread_cnt; i++ )
   {
-    perror(elf_filename);
+    if ( pthread_create(pool->thread_list+i, NULL, relf_pool_worker, pool) != 0 )
+    {
+      fprintf(stderr, "relf_pool: pthread_create failed\n");
+      break;
+    }
+    pool->thread_cnt++;
   }
-  
-  memset(relf, 0, sizeof(relf_struct));
-  return 0;
+  return 1;
+}
+
+void relf_pool_destroy(relf_pool_struct *pool)
+{
+  int i;
+  pthread_mutex_lock(&(pool->mutex));
+  pool->is_shutdown = 1;
+  pthread_cond_broadcast(&(pool->cond));
+  pthread_mutex_unlock(&(pool->mutex));
+  for( i = 0; i < pool->thread_cnt; i++ )
+    pthread_join(pool->thread_list[i], NULL);
+  free(pool->thread_list);
+  pthread_cond_destroy(&(pool->cond));
+  pthread_mutex_destroy(&(pool->mutex));
 }
 
+void relf_pool_add(relf_pool_struct *pool, relf_task_struct *task)
+{
+  pthread_mutex_lock(&(pool->mutex));
+  task->is_done = 0;
+  task->next = NULL;
+  if ( pool->last == NULL )
+    pool->first = task;
+  else
+    pool->last->next = task;
+  pool->last = task;
+  pthread_cond_signal(&(pool->cond));
+  pthread_mutex_unlock(&(pool->mutex));
+}
 
-void relf_destroy(relf_struct *relf)
+/* add a task to the beginning of the queue, so that it is executed before all other tasks */
+void relf_pool_push(relf_pool_struct *pool, relf_task_struct *task)
 {
-  elf_end(relf->elf);  
-  close(relf->fd);  
+  pthread_mutex_lock(&(pool->mutex));
+  task->is_done = 0;
+  task->next = pool->first;
+  pool->first = task;
+  if ( pool->last == NULL )
+    pool->last = task;
+  pthread_cond_signal(&(pool->cond));
+  pthread_mutex_unlock(&(pool->mutex));
 }
 
+/* 
+  wait until the task is done.
+  While waiting, the calling thread will execute other tasks from the queue.
+*/
+void relf_pool_wait(relf_pool_struct *pool, relf_task_struct *task)
+{
+  relf_task_struct *other;
+  pthread_mutex_lock(&(pool->mutex));
+  while( task->is_done == 0 )
+  {
+    other = relf_pool_get_task(pool);
+    if ( other != NULL )
+    {
+      pthread_mutex_unlock(&(pool->mutex));
+      relf_pool_run_task(pool, other);
+      pthread_mutex_lock(&(pool->mutex));
+    }
+    else
+    {
+      pthread_cond_wait(&(pool->cond), &(pool->mutex));
+    }
+  }
+  pthread_mutex_unlock(&(pool->mutex));
+}
 
 
 void relf_show_flag_list(elf_translate_struct *et, size_t flags)
 {
   int is_first = 1;
   size_t i = 0;
-  printf("[");
+  relf_printf("[");
   for(;;)
   {
     if ( et[i].m == NULL )
@@ -1235,18 +1465,18 @@ void relf_show_flag_list(elf_translate_struct *et, size_t flags)
       if ( is_first )   
         is_first = 0;
       else
-        printf(", ");
-      printf( "\"%s\"", et[i].m);
+        relf_printf(", ");
+      relf_printf( "\"%s\"", et[i].m);
     }
     i++;
   }
-  printf("]");
+  relf_printf("]");
 }
 
 
 void relf_member(const char *s)
 {
-  printf("\"%s\":", s);
+  relf_printf("\"%s\":", s);
 }
 
 /*
@@ -1258,22 +1488,22 @@ void relf_member(const char *s)
 void relf_show_et_value(elf_translate_struct *et, const char *variable, size_t n)
 {
   relf_member(variable);
-  printf("[%zu, \"%s\", \"%s\"]", n, et_get_macro(et, n), et_get_description(et, n));
+  relf_printf("[%zu, \"%s\", \"%s\"]", n, et_get_macro(et, n), et_get_description(et, n));
 }
 
 void relf_show_pure_value(const char *variable, long long unsigned n)
 {
   relf_member(variable);  
-  printf("[%llu, \"0x%08llx\"]", n, n);
+  relf_printf("[%llu, \"0x%08llx\"]", n, n);
 }
 
 
 void relf_show_flag_value_list(elf_translate_struct *et, const char *variable, long long unsigned n)
 {
   relf_member(variable);
-  printf("[%llu, ", n);
+  relf_printf("[%llu, ", n);
   relf_show_flag_list(et, n);
-  printf("]");
+  relf_printf("]");
 }
 
 /* 54 0x85a53329 */
@@ -1282,7 +1512,32 @@ void relf_show_flag_value_list(elf_translate_struct *et, const char *variable, l
 
 void relf_show_string_value(const char *variable, const char *value)
 {
-  printf("\"%s\": \"%s\"", variable, value);
+  relf_printf("\"%s\": \"%s\"", variable, value);
+}
+
+/* 
+  if not NULL, then names are written as index into this dictionary,
+  see relf_show_string_list() and relf_show_name_value()
+*/
+relf_strdict_struct *relf_string_dictionary = NULL;
+
+/*
+  Show a section or symbol name.
+  The name is either the string itself or the index into the string_list (option -d)
+*/
+void relf_show_name_value(const char *variable, const char *value)
+{
+  size_t idx;
+  if ( relf_string_dictionary != NULL )
+  {
+    idx = relf_strdict_find(relf_string_dictionary, value);
+    if ( idx != (size_t)-1 )
+    {
+      relf_printf("\"%s\": %zu", variable, idx);
+      return;
+    }
+  }
+  relf_show_string_value(variable, value);
 }
 
 
@@ -1290,35 +1545,66 @@ void relf_show_memory(const char *variable, unsigned char *ptr, size_t cnt)
 {
   int i;
   relf_member(variable);
-  printf("[");
+  relf_printf("[");
   for( i = 0; i < cnt; i++ )
   {
       if ( i > 0 )
-        printf(",");
-      printf("%u", (int)ptr[i]);
+        relf_printf(",");
+      relf_printf("%u", (int)ptr[i]);
   }
-  printf("]");
+  relf_printf("]");
 }
 
 
+/* 
+  show a string from the elf file content, the string ends with '\0' or after max bytes, 
+  quotes and control characters are escaped 
+*/
+void relf_show_raw_string_value(const char *variable, const unsigned char *ptr, size_t max)
+{
+  size_t i;
+  relf_member(variable);
+  relf_printf(" \"");
+  for( i = 0; i < max && ptr[i] != '\0'; i++ )
+  {
+    if ( ptr[i] == '\"' || ptr[i] == '\\' )
+      relf_printf("\\%c", ptr[i]);
+    else if ( ptr[i] < 32 || ptr[i] == 127 )
+      relf_printf("\\u%04x", (unsigned)ptr[i]);
+    else
+      relf_write((const char *)ptr+i, 1);
+  }
+  relf_printf("\"");
+}
+
+/* show bytes from the elf file as hex string, for example a build-id */
+void relf_show_hex_value(const char *variable, const unsigned char *ptr, size_t cnt)
+{
+  size_t i;
+  relf_member(variable);
+  relf_printf(" \"");
+  for( i = 0; i < cnt; i++ )
+    relf_printf("%02x", (unsigned)ptr[i]);
+  relf_printf("\"");
+}
 
 void relf_indent(int n)
 {
   while( n > 0 )
   {
-    printf("    ");
+    relf_printf("    ");
     n--;
   }
 }
 
 void relf_n()
 {
-  printf("\n");
+  relf_printf("\n");
 }
 
 void relf_c()
 {
-  printf(",");
+  relf_printf(",");
 }
 
 void relf_cn()
@@ -1329,22 +1615,22 @@ void relf_cn()
 
 void relf_oo()  // open object
 {
-  printf("{\n");
+  relf_printf("{\n");
 }
 
 void relf_co()  // close object
 {
-  printf("}");
+  relf_printf("}");
 }
 
 void relf_oa()  // open array
 {
-  printf("[\n");
+  relf_printf("[\n");
 }
 
 void relf_ca()  // close array
 {
-  printf("]");
+  relf_printf("]");
 }
 
 
@@ -1430,42 +1716,373 @@ void relf_show_elf_header(relf_struct *relf)
   relf_show_pure_value("dynstr_section_index", relf->dynstr_section_index);
 }
 
+/*==========================================*/
+/* Notes */
+
 /*
-  phdr member
-  Elf64_Word	p_type;		Segment type
-  Elf64_Word	p_flags;		Segment flags
-  Elf64_Off	p_offset;		Segment file offset
-  Elf64_Addr	p_vaddr;		Segment virtual address
-  Elf64_Addr	p_paddr;		Segment physical address
-  Elf64_Xword	p_filesz;		Segment size in file
-  Elf64_Xword	p_memsz;	Segment size in memory
-  Elf64_Xword	p_align;		Segment alignment
+  Layout of the core file notes, see elf_prstatus and elf_prpsinfo in linux/include/uapi/linux/elfcore.h
+  Offsets depend on the word size (4 or 8 bytes), pr_uid/pr_gid are 16 bit on some 32 bit systems.
 */
+#define RELF_PRSTATUS_PID_OFFSET(w) ((w) == 8 ? 32 : 24)
+#define RELF_PRSTATUS_REG_OFFSET(w) ((w) == 8 ? 112 : 72)
+#define RELF_PRPSINFO_FNAME_SIZE 16
+#define RELF_PRPSINFO_PSARGS_SIZE 80
 
-int relf_show_program_header(relf_struct *relf, GElf_Phdr *phdr)
+/* PT_NOTE segments which are larger are not decoded */
+#define RELF_NOTE_SIZE_MAX (16*1024*1024)
+
+void relf_show_note_word(const char *variable, const unsigned char *ptr, size_t size, int is_msb, int indent)
 {
-  // et_phdr_type
-// et_phdr_flags
-  int indent = 3;
-  
-  relf_indent(indent-1);
-  relf_oo();
+  relf_cn();
+  relf_indent(indent);
+  relf_show_pure_value(variable, relf_get_word(ptr, size, is_msb));
+}
+
+void relf_show_prstatus(relf_note_struct *note, size_t w, int is_msb, int indent)
+{
+  size_t pid_offset = RELF_PRSTATUS_PID_OFFSET(w);
+  size_t reg_offset = RELF_PRSTATUS_REG_OFFSET(w);
+  size_t i;
   
-  //relf_indent(indent);
-  //relf_show_pure_value("section_index", (long long unsigned)elf_ndxscn(scn));   // get the "official" section index
-  //relf_cn();    
+  if ( note->descsz < reg_offset + w )
+    return;
+  relf_show_note_word("si_signo", note->desc, 4, is_msb, indent);
+  relf_show_note_word("si_code", note->desc+4, 4, is_msb, indent);
+  relf_show_note_word("si_errno", note->desc+8, 4, is_msb, indent);
+  relf_show_note_word("pr_cursig", note->desc+12, 2, is_msb, indent);
+  relf_show_note_word("pr_pid", note->desc+pid_offset, 4, is_msb, indent);
+  relf_show_note_word("pr_ppid", note->desc+pid_offset+4, 4, is_msb, indent);
+  relf_show_note_word("pr_pgrp", note->desc+pid_offset+8, 4, is_msb, indent);
+  relf_show_note_word("pr_sid", note->desc+pid_offset+12, 4, is_msb, indent);
   
-  //relf_indent(indent);
-  //relf_show_string_value("sh_name", section_name);
-  //relf_cn();  
+  /* pr_reg is followed by the int pr_fpvalid, which is padded to the word size */
+  relf_cn();
+  relf_indent(indent);
+  relf_member("pr_reg");
+  relf_printf("[");
+  for( i = reg_offset; i + 2*w <= note->descsz; i += w )
+  {
+    if ( i > reg_offset )
+      relf_printf(",");
+    relf_printf("%llu", relf_get_word(note->desc+i, w, is_msb));
+  }
+  relf_printf("]");
+}
+
+void relf_show_prpsinfo(relf_note_struct *note, size_t w, int is_msb, int indent)
+{
+  size_t id_size = note->descsz == 124 ? 2 : 4;
+  size_t uid_offset = 2*w;
+  size_t pid_offset = uid_offset + 2*id_size;
+  size_t fname_offset = pid_offset + 16;
+  size_t psargs_offset = fname_offset + RELF_PRPSINFO_FNAME_SIZE;
   
+  if ( note->descsz != psargs_offset + RELF_PRPSINFO_PSARGS_SIZE )
+    return;
+  relf_show_note_word("pr_state", note->desc, 1, is_msb, indent);
+  relf_cn();
   relf_indent(indent);
-  relf_show_et_value(et_phdr_type, "p_type", phdr->p_type);
+  relf_show_raw_string_value("pr_sname", note->desc+1, 1);
+  relf_show_note_word("pr_zomb", note->desc+2, 1, is_msb, indent);
+  relf_show_note_word("pr_nice", note->desc+3, 1, is_msb, indent);
+  relf_show_note_word("pr_flag", note->desc+w, w, is_msb, indent);
+  relf_show_note_word("pr_uid", note->desc+uid_offset, id_size, is_msb, indent);
+  relf_show_note_word("pr_gid", note->desc+uid_offset+id_size, id_size, is_msb, indent);
+  relf_show_note_word("pr_pid", note->desc+pid_offset, 4, is_msb, indent);
+  relf_show_note_word("pr_ppid", note->desc+pid_offset+4, 4, is_msb, indent);
+  relf_show_note_word("pr_pgrp", note->desc+pid_offset+8, 4, is_msb, indent);
+  relf_show_note_word("pr_sid", note->desc+pid_offset+12, 4, is_msb, indent);
   relf_cn();
   relf_indent(indent);
-  relf_show_flag_value_list(et_phdr_flags, "p_flags", phdr->p_flags);
+  relf_show_raw_string_value("pr_fname", note->desc+fname_offset, RELF_PRPSINFO_FNAME_SIZE);
   relf_cn();
-
+  relf_indent(indent);
+  relf_show_raw_string_value("pr_psargs", note->desc+psargs_offset, RELF_PRPSINFO_PSARGS_SIZE);
+}
+
+/*
+  NT_FILE: count and page_size, followed by count entries (start, end, file_ofs), 
+  followed by count '\0' terminated file names 
+*/
+void relf_show_file_note(relf_note_struct *note, size_t w, int is_msb, int indent)
+{
+  size_t cnt, i, pos;
+  const unsigned char *entry;
+  
+  if ( note->descsz < 2*w )
+    return;
+  cnt = relf_get_word(note->desc, w, is_msb);
+  if ( cnt > (note->descsz - 2*w) / (3*w) )
+    return;
+  relf_show_note_word("page_size", note->desc+w, w, is_msb, indent);
+  relf_cn();
+  relf_indent(indent);
+  relf_member("file_list");
+  relf_n();
+  relf_indent(indent);
+  relf_oa();
+  pos = 2*w + cnt*3*w;          // position of the first file name
+  for( i = 0; i < cnt; i++ )
+  {
+    if ( i > 0 )
+      relf_cn();
+    entry = note->desc + 2*w + i*3*w;
+    relf_indent(indent+1);
+    relf_oo();
+    relf_indent(indent+2);
+    relf_show_pure_value("start", relf_get_word(entry, w, is_msb));
+    relf_show_note_word("end", entry+w, w, is_msb, indent+2);
+    relf_show_note_word("file_ofs", entry+2*w, w, is_msb, indent+2);
+    relf_cn();
+    relf_indent(indent+2);
+    relf_show_raw_string_value("filename", note->desc+pos, note->descsz-pos);
+    while( pos < note->descsz && note->desc[pos] != '\0' )
+      pos++;
+    if ( pos < note->descsz )
+      pos++;
+    relf_n();
+    relf_indent(indent+1);
+    relf_co();
+  }
+  relf_n();
+  relf_indent(indent);
+  relf_ca();
+}
+
+/* NT_AUXV: (a_type, a_val) pairs, terminated by AT_NULL */
+void relf_show_auxv_note(relf_note_struct *note, size_t w, int is_msb, int indent)
+{
+  size_t i;
+  size_t a_type;
+  
+  relf_cn();
+  relf_indent(indent);
+  relf_member("auxv_list");
+  relf_n();
+  relf_indent(indent);
+  relf_oa();
+  for( i = 0; i + 2*w <= note->descsz; i += 2*w )
+  {
+    a_type = relf_get_word(note->desc+i, w, is_msb);
+    if ( a_type == AT_NULL )
+      break;
+    if ( i > 0 )
+      relf_cn();
+    relf_indent(indent+1);
+    relf_oo();
+    relf_indent(indent+2);
+    relf_show_et_value(et_auxv_type, "a_type", a_type);
+    relf_show_note_word("a_val", note->desc+i+w, w, is_msb, indent+2);
+    relf_n();
+    relf_indent(indent+1);
+    relf_co();
+  }
+  relf_n();
+  relf_indent(indent);
+  relf_ca();
+}
+
+/* NT_GNU_PROPERTY_TYPE_0: list of (pr_type, pr_datasz, pr_data), each property is aligned to the word size */
+void relf_show_gnu_property_note(relf_note_struct *note, size_t w, int is_msb, int indent)
+{
+  size_t pos = 0;
+  size_t pr_type, pr_datasz;
+  
+  relf_cn();
+  relf_indent(indent);
+  relf_member("property_list");
+  relf_n();
+  relf_indent(indent);
+  relf_oa();
+  while( pos + 8 <= note->descsz )
+  {
+    pr_type = relf_get_word(note->desc+pos, 4, is_msb);
+    pr_datasz = relf_get_word(note->desc+pos+4, 4, is_msb);
+    if ( pr_datasz > note->descsz - pos - 8 )
+      break;
+    if ( pos > 0 )
+      relf_cn();
+    relf_indent(indent+1);
+    relf_oo();
+    relf_indent(indent+2);
+#ifdef GNU_PROPERTY_STACK_SIZE
+    relf_show_et_value(et_gnu_property_type, "pr_type", pr_type);
+#else
+    relf_show_pure_value("pr_type", pr_type);
+#endif
+    relf_cn();
+    relf_indent(indent+2);
+    if ( pr_datasz == 4 || pr_datasz == 8 )
+      relf_show_pure_value("pr_data", relf_get_word(note->desc+pos+8, pr_datasz, is_msb));
+    else
+      relf_show_memory("pr_data", (unsigned char *)note->desc+pos+8, pr_datasz);
+    relf_n();
+    relf_indent(indent+1);
+    relf_co();
+    pos += 8 + ((pr_datasz + w - 1) & ~(w - 1));
+  }
+  relf_n();
+  relf_indent(indent);
+  relf_ca();
+}
+
+void relf_show_gnu_note(relf_note_struct *note, size_t w, int is_msb, int indent)
+{
+  char abi_version[64];
+  
+  switch(note->n_type)
+  {
+    case NT_GNU_BUILD_ID:
+      relf_cn();
+      relf_indent(indent);
+      relf_show_hex_value("build_id", note->desc, note->descsz);
+      break;
+    case NT_GNU_ABI_TAG:
+      if ( note->descsz < 16 )
+        break;
+      relf_cn();
+      relf_indent(indent);
+      relf_show_et_value(et_abi_tag_os, "abi_os", relf_get_word(note->desc, 4, is_msb));
+      snprintf(abi_version, sizeof(abi_version), "%llu.%llu.%llu", 
+        relf_get_word(note->desc+4, 4, is_msb), relf_get_word(note->desc+8, 4, is_msb), relf_get_word(note->desc+12, 4, is_msb));
+      relf_cn();
+      relf_indent(indent);
+      relf_show_string_value("abi_version", abi_version);
+      break;
+    case NT_GNU_GOLD_VERSION:
+      relf_cn();
+      relf_indent(indent);
+      relf_show_raw_string_value("gold_version", note->desc, note->descsz);
+      break;
+#ifdef NT_GNU_PROPERTY_TYPE_0
+    case NT_GNU_PROPERTY_TYPE_0:
+      relf_show_gnu_property_note(note, w, is_msb, indent);
+      break;
+#endif
+  }
+}
+
+void relf_show_note(relf_struct *relf, relf_note_struct *note, int indent)
+{
+  size_t w = gelf_getclass(relf->elf) == ELFCLASS64 ? 8 : 4;
+  int is_msb = elf_getident(relf->elf, NULL)[EI_DATA] == ELFDATA2MSB;
+  
+  relf_indent(indent);
+  relf_oo();
+  relf_indent(indent+1);
+  relf_show_raw_string_value("n_name", (const unsigned char *)note->name, note->namesz);
+  relf_cn();
+  relf_indent(indent+1);
+  if ( relf_is_note_name(note, "CORE") || relf_is_note_name(note, "LINUX") )
+    relf_show_et_value(et_core_note_type, "n_type", note->n_type);
+  else if ( relf_is_note_name(note, "GNU") )
+    relf_show_et_value(et_gnu_note_type, "n_type", note->n_type);
+  else if ( relf_is_note_name(note, "FDO") )
+    relf_show_et_value(et_fdo_note_type, "n_type", note->n_type);
+  else
+    relf_show_pure_value("n_type", note->n_type);
+  relf_cn();
+  relf_indent(indent+1);
+  relf_show_pure_value("n_descsz", note->descsz);
+  
+  if ( relf_is_note_name(note, "CORE") )
+  {
+    switch(note->n_type)
+    {
+      case NT_PRSTATUS:
+        relf_show_prstatus(note, w, is_msb, indent+1);
+        break;
+      case NT_PRPSINFO:
+        relf_show_prpsinfo(note, w, is_msb, indent+1);
+        break;
+      case NT_AUXV:
+        relf_show_auxv_note(note, w, is_msb, indent+1);
+        break;
+#ifdef NT_FILE
+      case NT_FILE:
+        relf_show_file_note(note, w, is_msb, indent+1);
+        break;
+#endif
+    }
+  }
+  else if ( relf_is_note_name(note, "GNU") )
+  {
+    relf_show_gnu_note(note, w, is_msb, indent+1);
+  }
+  else if ( relf_is_note_name(note, "FDO") && note->n_type == NT_FDO_PACKAGING_METADATA )
+  {
+    /* the package metadata is a JSON object, but it is written as string, because it is not verified */
+    relf_cn();
+    relf_indent(indent+1);
+    relf_show_raw_string_value("package", note->desc, note->descsz);
+  }
+  relf_n();
+  relf_indent(indent);
+  relf_co();
+}
+
+/* show all notes of a SHT_NOTE section or PT_NOTE segment as "note_list" member */
+void relf_show_note_list(relf_struct *relf, const unsigned char *ptr, size_t size, size_t align, int indent)
+{
+  relf_note_struct note;
+  size_t offset = 0;
+  size_t next;
+  
+  relf_indent(indent-1);
+  relf_member("note_list");
+  relf_n();
+  relf_indent(indent-1);
+  relf_oa();
+  while( (next = relf_get_note(ptr, size, offset, align, elf_getident(relf->elf, NULL)[EI_DATA] == ELFDATA2MSB, &note)) != 0 )
+  {
+    if ( offset > 0 )
+      relf_cn();
+    relf_show_note(relf, &note, indent);
+    offset = next;
+  }
+  relf_n();
+  relf_indent(indent-1);
+  relf_ca();
+}
+
+/*
+  phdr member
+  Elf64_Word	p_type;		Segment type
+  Elf64_Word	p_flags;		Segment flags
+  Elf64_Off	p_offset;		Segment file offset
+  Elf64_Addr	p_vaddr;		Segment virtual address
+  Elf64_Addr	p_paddr;		Segment physical address
+  Elf64_Xword	p_filesz;		Segment size in file
+  Elf64_Xword	p_memsz;	Segment size in memory
+  Elf64_Xword	p_align;		Segment alignment
+*/
+
+int relf_show_program_header(relf_struct *relf, GElf_Phdr *phdr)
+{
+  // et_phdr_type
+// et_phdr_flags
+  int indent = 3;
+  unsigned char *note_ptr;
+  unsigned long crc;
+  
+  relf_indent(indent-1);
+  relf_oo();
+  
+  //relf_indent(indent);
+  //relf_show_pure_value("section_index", (long long unsigned)elf_ndxscn(scn));   // get the "official" section index
+  //relf_cn();    
+  
+  //relf_indent(indent);
+  //relf_show_string_value("sh_name", section_name);
+  //relf_cn();  
+  
+  relf_indent(indent);
+  relf_show_et_value(et_phdr_type, "p_type", phdr->p_type);
+  relf_cn();
+  relf_indent(indent);
+  relf_show_flag_value_list(et_phdr_flags, "p_flags", phdr->p_flags);
+  relf_cn();
+
   relf_indent(indent);
   relf_show_pure_value("p_offset", phdr->p_offset);
   relf_cn();
@@ -1483,6 +2100,28 @@ int relf_show_program_header(relf_struct *relf, GElf_Phdr *phdr)
   relf_cn();
   relf_indent(indent);
   relf_show_pure_value("p_align", phdr->p_align);
+  
+  if ( phdr->p_type == PT_NOTE && phdr->p_filesz <= RELF_NOTE_SIZE_MAX && (relf_max_memory == 0 || phdr->p_filesz <= relf_max_memory) )
+  {
+    /* notes are read directly from the file, the segment might not be covered by a section */
+    note_ptr = relf_read_alloc(relf, phdr->p_filesz, phdr->p_offset);
+    if ( note_ptr != NULL )
+    {
+      relf_cn();
+      relf_show_note_list(relf, note_ptr, phdr->p_filesz, phdr->p_align, indent+1);
+      free(note_ptr);
+    }
+  }
+  else if ( phdr->p_type == PT_LOAD && relf->elf_file_header.e_type == ET_CORE )
+  {
+    /* the memory of a core dump is streamed through relf_get_file_crc() */
+    if ( relf_get_file_crc(relf, phdr->p_filesz, phdr->p_offset, &crc) != 0 )
+    {
+      relf_cn();
+      relf_indent(indent);
+      relf_show_pure_value("p_crc", crc);
+    }
+  }
   relf_n();
   
   relf_indent(indent-1);
@@ -1530,120 +2169,291 @@ int relf_show_program_header_list(relf_struct *relf)
   return 1;
 }
 
-/* returns a pointer to a memory location within a section */
-void *relf_get_mem_ptr(relf_struct *relf, size_t section_index, size_t addr)
+/*==========================================*/
+/* Segment Section Map */
+
+/*
+  Mapping from the program headers to the sections (similar to readelf -l).
+  Segments and allocated sections are sorted together by address (segments first), 
+  then a single sweep keeps the list of segments, which cover the current address. 
+  Each section is only compared against these active segments. 
+  The result pairs are grouped by segment with a counting sort, so that the sections 
+  of each segment stay in address order.
+*/
+
+struct _relf_segment_event_struct
 {
-  GElf_Shdr shdr;
-  Elf_Scn *scn;
-  Elf_Data *data = NULL;
-  size_t block_addr = 0;
-  
-  if ( section_index == 0 || section_index > 0x0fff0 )
-    return NULL;
-  
-  scn = elf_getscn (relf->elf,  section_index);  
-  if ( scn == NULL )
-    return fprintf(stderr, "libelf: %s, section_index=%lld \n", elf_errmsg(-1), (long long int)section_index), NULL;
-  if ( gelf_getshdr( scn, &shdr ) != &shdr )
-    return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
+  unsigned long long addr;
+  unsigned long long end;
+  size_t index;                 // program header index or section index
+  int is_section;
+};
+typedef struct _relf_segment_event_struct relf_segment_event_struct;
 
-  /*
-    shdr.sh_addr                contains the base address for the target memory
-    shdr.sh_size                 contains the size of the section
-  */
+struct _relf_segment_pair_struct
+{
+  size_t segment_index;
+  size_t section_index;
+};
+typedef struct _relf_segment_pair_struct relf_segment_pair_struct;
+
+int relf_cmp_segment_event(const void *a, const void *b)
+{
+  const relf_segment_event_struct *x = (const relf_segment_event_struct *)a;
+  const relf_segment_event_struct *y = (const relf_segment_event_struct *)b;
+  if ( x->addr != y->addr )
+    return x->addr < y->addr ? -1 : 1;
+  if ( x->is_section != y->is_section )
+    return x->is_section - y->is_section;       // segments before sections
+  if ( x->index != y->index )
+    return x->index < y->index ? -1 : 1;
+  return 0;
+}
+
+/* same rules as ELF_SECTION_IN_SEGMENT from binutils, but only for allocated sections */
+int relf_is_section_in_segment(GElf_Shdr *shdr, GElf_Phdr *phdr)
+{
+  int is_tls = (shdr->sh_flags & SHF_TLS) != 0;
   
-  if ( shdr.sh_size == 0 )
-    return NULL;
+  /* TLS sections are only in PT_TLS, PT_LOAD and PT_GNU_RELRO, .tbss is only in PT_TLS */
+  if ( is_tls && phdr->p_type != PT_TLS && phdr->p_type != PT_LOAD && phdr->p_type != PT_GNU_RELRO )
+    return 0;
+  if ( !is_tls && phdr->p_type == PT_TLS )
+    return 0;
+  if ( is_tls && shdr->sh_type == SHT_NOBITS && phdr->p_type != PT_TLS )
+    return 0;
   
-  for(;;)
+  if ( shdr->sh_addr < phdr->p_vaddr || shdr->sh_addr - phdr->p_vaddr > phdr->p_memsz )
+    return 0;
+  if ( shdr->sh_size > phdr->p_memsz - (shdr->sh_addr - phdr->p_vaddr) )
+    return 0;
+  /* empty sections at the end of a segment belong to the next segment */
+  if ( shdr->sh_size == 0 && phdr->p_memsz > 0 && shdr->sh_addr - phdr->p_vaddr == phdr->p_memsz )
+    return 0;
+  
+  /* sections with content must also be inside the file part of the segment */
+  if ( shdr->sh_type != SHT_NOBITS )
   {
-    data = elf_getdata(scn , data);     // if data==NULL return first data, otherwise return next data
-    if ( data == NULL )
-      break;
-    if ( data->d_buf == NULL )
-      break;
-    block_addr = shdr.sh_addr + data->d_off;    // calculate the address of this data in the target system, not 100% sure whether this is correct
-    //printf("block_addr=%08lx addr=%08lx d_buf=%p\n", block_addr, addr, data->d_buf);
-    if ( addr >= block_addr && addr < block_addr+data->d_size )  // check if the requested addr is inside the current block
+    if ( shdr->sh_offset < phdr->p_offset || shdr->sh_offset - phdr->p_offset > phdr->p_filesz )
+      return 0;
+    if ( shdr->sh_size > phdr->p_filesz - (shdr->sh_offset - phdr->p_offset) )
+      return 0;
+  }
+  return 1;
+}
+
+void relf_show_segment_name_value(const char *name)
+{
+  size_t idx;
+  if ( relf_string_dictionary != NULL )
+  {
+    idx = relf_strdict_find(relf_string_dictionary, name);
+    if ( idx != (size_t)-1 )
     {
-      return data->d_buf + addr - block_addr;   // found
+      relf_printf("%zu", idx);
+      return;
     }
-  }  
-  return NULL;
+  }
+  relf_printf("\"%s\"", name);
 }
 
-
-int relf_show_symbol_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data, int sh_link)
+int relf_show_segment_section_map(relf_struct *relf)
 {
+  int indent = 1;
+  relf_segment_event_struct *event_list;
+  relf_segment_pair_struct *pair_list = NULL;
+  relf_segment_pair_struct *new_pair_list;
+  relf_segment_pair_struct *sorted_pair_list;
+  GElf_Phdr *phdr_list;
+  size_t *active_list;
+  size_t *first_list;
+  size_t event_cnt = 0, active_cnt = 0, pair_cnt = 0, pair_max = 0;
+  size_t i, j, k;
+  Elf_Scn *scn = NULL;
+  GElf_Shdr shdr;
+  const char *name;
   
-  /*
-    GElf_Sym contains the following members:  
-      st_name;		Symbol name (string tbl index) 
-      st_value;		Symbol value 
-      st_size;		Symbol size
-      st_info;		Symbol type and binding         GELF_ST_BIND(st_info), GELF_ST_TYPE(st_info)
-      st_other;		Symbol visibility               GELF_ST_VISIBILITY(st_other)
-      st_shndx;		Section index
-                                    https://refspecs.linuxbase.org/elf/gabi4+/ch4.symtab.html
-                                    Every symbol table entry is defined in relation to some section.
-                                    This member holds the relevant section header table index. 
-                                    As the sh_link and sh_info interpretation table and the related text describe, some section indexes indicate special meanings.
-                                    If this member contains SHN_XINDEX, then the actual section header index is too large to fit in this field. 
-                                    The actual value is contained in the associated section of type SHT_SYMTAB_SHNDX.   
-  
-                                    The interpretation of the st_value field depends on the st_shndx value:
-                                    SHN_UNDEF	        0x0000          Undefined section 
-                                        This section table index means the symbol is undefined. 
-                                        When the link editor combines this object file with another that defines the indicated symbol, this file's references to the symbol will be linked to the actual definition. 
-                                    SHN_ABS		0xfff1	        Associated symbol is absolute
-                                        The symbol has an absolute value that will not change because of relocation. 
-                                    SHN_COMMON	0xfff2		Associated symbol is common
-                                        The symbol labels a common block that has not yet been allocated. 
-                                        The symbol's value gives alignment constraints, similar to a section's sh_addralign member. 
-                                        The link editor will allocate the storage for the symbol at an address that is a multiple of st_value. 
-                                        The symbol's size tells how many bytes are required. Symbols with section index SHN_COMMON may appear only in relocatable objects. 
-                                    SHN_XINDEX	        0xffff		Index is in extra table.
-                                        This value is an escape value. 
-                                        It indicates that the symbol refers to a specific location within a section, 
-                                        but that the section header index for that section is too large to be represented directly in the symbol table entry. 
-                                        The actual section header index is found in the associated SHT_SYMTAB_SHNDX section. 
-                                        The entries in that section correspond one to one with the entries in the symbol table. 
-                                        Only those entries in SHT_SYMTAB_SHNDX that correspond to symbol table entries with SHN_XINDEX will hold valid section header indexes; all other entries will have value 0. 
-
+  event_list = (relf_segment_event_struct *)malloc((relf->program_header_total + relf->section_header_total + 1) * sizeof(relf_segment_event_struct));
+  phdr_list = (GElf_Phdr *)malloc((relf->program_header_total + 1) * sizeof(GElf_Phdr));
+  active_list = (size_t *)malloc((relf->program_header_total + 1) * sizeof(size_t));
+  first_list = (size_t *)calloc(relf->program_header_total + 2, sizeof(size_t));
+  if ( event_list == NULL || phdr_list == NULL || active_list == NULL || first_list == NULL )
+  {
+    free(event_list); free(phdr_list); free(active_list); free(first_list);
+    return fprintf(stderr, "relf_show_segment_section_map: out of memory\n"), 0;
+  }
   
-  */
-  int i = 0;
-  GElf_Sym symbol;
+  for( i = 0; i < relf->program_header_total; i++ )
+  {
+    if ( gelf_getphdr(relf->elf, i, phdr_list + i) == NULL )
+      memset(phdr_list + i, 0, sizeof(GElf_Phdr));
+    if ( phdr_list[i].p_type == PT_NULL )
+      continue;
+    event_list[event_cnt].addr = phdr_list[i].p_vaddr;
+    event_list[event_cnt].end = phdr_list[i].p_vaddr + phdr_list[i].p_memsz;
+    event_list[event_cnt].index = i;
+    event_list[event_cnt].is_section = 0;
+    event_cnt++;
+  }
+  while( (scn = elf_nextscn(relf->elf, scn)) != NULL && event_cnt < relf->program_header_total + relf->section_header_total )
+  {
+    if ( gelf_getshdr(scn, &shdr) != &shdr )
+      break;
+    if ( (shdr.sh_flags & SHF_ALLOC) == 0 )
+      continue;
+    event_list[event_cnt].addr = shdr.sh_addr;
+    event_list[event_cnt].end = shdr.sh_addr + shdr.sh_size;
+    event_list[event_cnt].index = elf_ndxscn(scn);
+    event_list[event_cnt].is_section = 1;
+    event_cnt++;
+  }
+  qsort(event_list, event_cnt, sizeof(relf_segment_event_struct), relf_cmp_segment_event);
   
-  int indent = 6;
-  int is_first = 1;
-  const char *symbol_name;
-
-
-  relf_cn();
-  relf_indent(indent-1);
-  relf_member("symbol_list");
+  /* sweep */
+  for( i = 0; i < event_cnt; i++ )
+  {
+    if ( event_list[i].is_section == 0 )
+    {
+      active_list[active_cnt++] = event_list[i].index;
+      continue;
+    }
+    scn = elf_getscn(relf->elf, event_list[i].index);
+    if ( scn == NULL || gelf_getshdr(scn, &shdr) != &shdr )
+      continue;
+    for( j = 0, k = 0; j < active_cnt; j++ )
+    {
+      /* remove segments which end before the current section (empty segments are kept for empty sections) */
+      GElf_Phdr *phdr = phdr_list + active_list[j];
+      if ( phdr->p_vaddr + phdr->p_memsz < event_list[i].addr )
+        continue;
+      active_list[k++] = active_list[j];
+      if ( relf_is_section_in_segment(&shdr, phdr) )
+      {
+        if ( pair_cnt >= pair_max )
+        {
+          pair_max = pair_max*2 + 64;
+          new_pair_list = (relf_segment_pair_struct *)realloc(pair_list, pair_max * sizeof(relf_segment_pair_struct));
+          if ( new_pair_list == NULL )
+          {
+            free(event_list); free(phdr_list); free(active_list); free(first_list); free(pair_list);
+            return fprintf(stderr, "relf_show_segment_section_map: out of memory\n"), 0;
+          }
+          pair_list = new_pair_list;
+        }
+        pair_list[pair_cnt].segment_index = active_list[j];
+        pair_list[pair_cnt].section_index = event_list[i].index;
+        pair_cnt++;
+      }
+    }
+    active_cnt = k;
+  }
+  
+  /* counting sort by segment, the sections keep their address order */
+  for( i = 0; i < pair_cnt; i++ )
+    first_list[pair_list[i].segment_index+1]++;
+  for( i = 0; i < relf->program_header_total; i++ )
+    first_list[i+1] += first_list[i];
+  sorted_pair_list = (relf_segment_pair_struct *)malloc((pair_cnt+1) * sizeof(relf_segment_pair_struct));
+  if ( sorted_pair_list == NULL )
+  {
+    free(event_list); free(phdr_list); free(active_list); free(first_list); free(pair_list);
+    return fprintf(stderr, "relf_show_segment_section_map: out of memory\n"), 0;
+  }
+  for( i = 0; i < relf->program_header_total; i++ )
+    active_list[i] = first_list[i];     // next free position for segment i
+  for( i = 0; i < pair_cnt; i++ )
+    sorted_pair_list[active_list[pair_list[i].segment_index]++] = pair_list[i];
+  
+  relf_indent(indent);
+  relf_member("segment_section_map");
   relf_n();
-  relf_indent(indent-1);
-  relf_oa();    // open array
+  relf_indent(indent);
+  relf_oa();            // open array
+  for( i = 0; i < relf->program_header_total; i++ )
+  {
+    if ( i > 0 )
+      relf_cn();
+    relf_indent(indent+1);
+    relf_printf("{");
+    relf_show_pure_value("program_header_index", i);
+    relf_printf(", ");
+    relf_member("section_index_list");
+    relf_printf("[");
+    for( j = first_list[i]; j < first_list[i+1]; j++ )
+      relf_printf(j > first_list[i] ? ", %zu" : "%zu", sorted_pair_list[j].section_index);
+    relf_printf("], ");
+    relf_member("sh_name_list");
+    relf_printf("[");
+    for( j = first_list[i]; j < first_list[i+1]; j++ )
+    {
+      if ( j > first_list[i] )
+        relf_printf(", ");
+      scn = elf_getscn(relf->elf, sorted_pair_list[j].section_index);
+      name = NULL;
+      if ( scn != NULL && gelf_getshdr(scn, &shdr) == &shdr )
+        name = elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name);
+      relf_show_segment_name_value(name != NULL ? name : "");
+    }
+    relf_printf("]}");
+  }
+  relf_n();
+  relf_indent(indent);
+  relf_ca();    // close array
+  
+  free(event_list);
+  free(phdr_list);
+  free(active_list);
+  free(first_list);
+  free(pair_list);
+  free(sorted_pair_list);
+  return 1;
+}
 
+/*
+  obj_crc and obj_data for a symbol with relf_max_memory:
+  The symbol is read in chunks from the elf file, so the section is not loaded into memory.
+*/
+void relf_show_obj_from_file(relf_struct *relf, const GElf_Sym *symbol, int indent)
+{
+  unsigned char obj_data[64];
+  size_t offset = relf_get_file_offset(relf, symbol->st_shndx, symbol->st_value);
+  size_t len = symbol->st_size > 64 ? 64 : symbol->st_size;
+  unsigned long crc;
   
-  /*
-    There is no function to get the total number of symbols, so start with index zero and loop
-    until gelf_getsym() returns an error,
+  if ( offset == 0 )
+    return;
+  if ( relf_get_file_crc(relf, symbol->st_size, offset, &crc) == 0 || relf_read(relf, obj_data, len, offset) == 0 )
+    return;
+  relf_cn();    
+  relf_indent(indent);
+  relf_show_pure_value("obj_crc", crc);
+  relf_cn();    
+  relf_indent(indent);
+  relf_show_memory("obj_data", obj_data, len);
+}
+
+/* number of symbols per task, if the symbol list is rendered by the worker threads */
+#define RELF_SYMBOL_CHUNK_SIZE 4096
+
+/*
+  Show the symbols with index first ... last-1 from the symbol data.
+  All symbols except the symbol with index 0 are prefixed with a comma, so
+  the output of consecutive ranges can be concatenated.
+*/
+int relf_show_symbol_range(relf_struct *relf, Elf_Scn *scn, relf_records_struct *records, int sh_link, size_t first, size_t last)
+{
+  size_t i;
+  GElf_Sym symbol;
+  int indent = 6;
+  const char *symbol_name;
+  /* symbol versions are only available for the dynamic symbol table */
+  int is_version = relf->symbol_version_cnt > 0 && elf_ndxscn(scn) == relf->dynsym_section_index;
   
-    Note: It seems that then total number is equal to the data block sized / sizeof(symbol struct), 
-      but sizeof(symbol struct) depends on the type of the elf file (32 or 64 bit).
-      
-    if st_shndx has the value SHN_XINDEX then
-     GElf_Sym *gelf_getsymshndx(Elf_Data *symdata, Elf_Data *xndxdata, int ndx, GElf_Sym *sym, Elf32_Word *xndxptr);
-    will calculate the correct section index in xndxptr. xndxdata must be a section of type SHT_SYMTAB_SHNDX
-  */
-  while( gelf_getsym(data, i, &symbol) != NULL )
+  for( i = first; i < last; i++ )
   {
-    if ( is_first ) 
-      is_first = 0;
-    else
+    if ( relf_get_sym(records, i, &symbol) == NULL )
+      break;
+    if ( i > 0 ) 
       relf_cn();
 
     symbol_name = elf_strptr(relf->elf, sh_link, symbol.st_name );
@@ -1655,7 +2465,7 @@ int relf_show_symbol_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data, int
     relf_oo();
 
     relf_indent(indent+1);
-    relf_show_string_value("st_name", symbol_name);
+    relf_show_name_value("st_name", symbol_name);
     relf_cn();    
 
     relf_indent(indent+1);
@@ -1686,6 +2496,19 @@ int relf_show_symbol_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data, int
 #endif 
     //relf_cn();
     
+    if ( is_version && i < relf->symbol_version_cnt )
+    {
+      relf_cn();
+      relf_indent(indent+1);
+      relf_show_pure_value("version_index", relf->symbol_version_list[i]);
+      if ( relf->symbol_version_name_list[i] != NULL )
+      {
+        relf_cn();
+        relf_indent(indent+1);
+        relf_show_string_value("version_name", relf->symbol_version_name_list[i]);
+      }
+    }
+    
     if ( symbol.st_shndx > 0 )
     {
       unsigned char * ptr = (unsigned char *)relf_get_mem_ptr(relf, symbol.st_shndx, symbol.st_value);
@@ -1699,6 +2522,10 @@ int relf_show_symbol_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data, int
         relf_indent(indent+1);
         relf_show_memory("obj_data", ptr, symbol.st_size > 64 ? 64 : symbol.st_size);
       }
+      else if ( relf_max_memory != 0 )
+      {
+        relf_show_obj_from_file(relf, &symbol, indent+1);
+      }
     }
 
     
@@ -1707,7 +2534,137 @@ int relf_show_symbol_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data, int
     relf_co();
     
     
-    i++;
+  }
+  return 1;
+}
+
+int relf_symbol_task(relf_task_struct *task)
+{
+  relf_records_struct records;
+  int result;
+  /* with relf_max_memory, each task reads the symbols into its own window */
+  if ( relf_copy_records(&records, task->records) == 0 )
+    return fprintf(stderr, "relf_symbol_task: out of memory\n"), 0;
+  result = relf_show_symbol_range(task->relf, task->scn, &records, task->sh_link, task->first, task->last);
+  relf_destroy_records(&records);
+  return result;
+}
+
+/*
+  Split the symbol list into chunks of RELF_SYMBOL_CHUNK_SIZE symbols. 
+  Each chunk is decoded, hashed and formatted by one of the worker threads,
+  the results are concatenated in the original order.
+*/
+int relf_show_symbol_range_parallel(relf_struct *relf, Elf_Scn *scn, relf_records_struct *records, int sh_link, size_t symbol_cnt)
+{
+  relf_task_struct *task_list;
+  size_t task_cnt = (symbol_cnt + RELF_SYMBOL_CHUNK_SIZE - 1) / RELF_SYMBOL_CHUNK_SIZE;
+  size_t i;
+  int result = 1;
+  
+  task_list = (relf_task_struct *)calloc(task_cnt, sizeof(relf_task_struct));
+  if ( task_list == NULL )
+    return relf_show_symbol_range(relf, scn, records, sh_link, 0, symbol_cnt);
+  for( i = 0; i < task_cnt; i++ )
+  {
+    task_list[i].fn = relf_symbol_task;
+    task_list[i].relf = relf;
+    task_list[i].scn = scn;
+    task_list[i].records = records;
+    task_list[i].sh_link = sh_link;
+    task_list[i].first = i*RELF_SYMBOL_CHUNK_SIZE;
+    task_list[i].last = task_list[i].first + RELF_SYMBOL_CHUNK_SIZE;
+    if ( task_list[i].last > symbol_cnt )
+      task_list[i].last = symbol_cnt;
+  }
+  /* the chunks are put in front of the queue, the calling task waits for them */
+  for( i = task_cnt; i > 0; i-- )
+    relf_pool_push(relf_pool, task_list + i - 1);
+  
+  for( i = 0; i < task_cnt; i++ )
+  {
+    relf_pool_wait(relf_pool, task_list + i);
+    if ( result != 0 )
+    {
+      relf_write(task_list[i].buf.ptr, task_list[i].buf.len);
+      result = task_list[i].result;
+    }
+    relf_buf_destroy(&(task_list[i].buf));
+  }
+  free(task_list);
+  return result;
+}
+
+int relf_show_symbol_data(relf_struct *relf, Elf_Scn  *scn, relf_records_struct *records, int sh_link)
+{
+  
+  /*
+    GElf_Sym contains the following members:  
+      st_name;		Symbol name (string tbl index) 
+      st_value;		Symbol value 
+      st_size;		Symbol size
+      st_info;		Symbol type and binding         GELF_ST_BIND(st_info), GELF_ST_TYPE(st_info)
+      st_other;		Symbol visibility               GELF_ST_VISIBILITY(st_other)
+      st_shndx;		Section index
+                                    https://refspecs.linuxbase.org/elf/gabi4+/ch4.symtab.html
+                                    Every symbol table entry is defined in relation to some section.
+                                    This member holds the relevant section header table index. 
+                                    As the sh_link and sh_info interpretation table and the related text describe, some section indexes indicate special meanings.
+                                    If this member contains SHN_XINDEX, then the actual section header index is too large to fit in this field. 
+                                    The actual value is contained in the associated section of type SHT_SYMTAB_SHNDX.   
+  
+                                    The interpretation of the st_value field depends on the st_shndx value:
+                                    SHN_UNDEF	        0x0000          Undefined section 
+                                        This section table index means the symbol is undefined. 
+                                        When the link editor combines this object file with another that defines the indicated symbol, this file's references to the symbol will be linked to the actual definition. 
+                                    SHN_ABS		0xfff1	        Associated symbol is absolute
+                                        The symbol has an absolute value that will not change because of relocation. 
+                                    SHN_COMMON	0xfff2		Associated symbol is common
+                                        The symbol labels a common block that has not yet been allocated. 
+                                        The symbol's value gives alignment constraints, similar to a section's sh_addralign member. 
+                                        The link editor will allocate the storage for the symbol at an address that is a multiple of st_value. 
+                                        The symbol's size tells how many bytes are required. Symbols with section index SHN_COMMON may appear only in relocatable objects. 
+                                    SHN_XINDEX	        0xffff		Index is in extra table.
+                                        This value is an escape value. 
+                                        It indicates that the symbol refers to a specific location within a section, 
+                                        but that the section header index for that section is too large to be represented directly in the symbol table entry. 
+                                        The actual section header index is found in the associated SHT_SYMTAB_SHNDX section. 
+                                        The entries in that section correspond one to one with the entries in the symbol table. 
+                                        Only those entries in SHT_SYMTAB_SHNDX that correspond to symbol table entries with SHN_XINDEX will hold valid section header indexes; all other entries will have value 0. 
+
+  
+  */
+  size_t sym_size = gelf_fsize(relf->elf, ELF_T_SYM, 1, EV_CURRENT);
+  size_t symbol_cnt = records->native != NULL ? records->cnt : (sym_size > 0 ? records->data->d_size / sym_size : 0);
+  int indent = 6;
+
+
+  relf_cn();
+  relf_indent(indent-1);
+  relf_member("symbol_list");
+  relf_n();
+  relf_indent(indent-1);
+  relf_oa();    // open array
+
+  /*
+    There is no function to get the total number of symbols. The total number is equal to 
+    the data block size / sizeof(symbol struct), but sizeof(symbol struct) depends on the 
+    type of the elf file (32 or 64 bit), so gelf_fsize() is used to get the size.
+    relf_show_symbol_range() will also stop if gelf_getsym() returns an error.
+      
+    if st_shndx has the value SHN_XINDEX then
+     GElf_Sym *gelf_getsymshndx(Elf_Data *symdata, Elf_Data *xndxdata, int ndx, GElf_Sym *sym, Elf32_Word *xndxptr);
+    will calculate the correct section index in xndxptr. xndxdata must be a section of type SHT_SYMTAB_SHNDX
+  */
+  if ( relf_pool != NULL && symbol_cnt > RELF_SYMBOL_CHUNK_SIZE )
+  {
+    if ( relf_show_symbol_range_parallel(relf, scn, records, sh_link, symbol_cnt) == 0 )
+      return 0;
+  }
+  else
+  {
+    if ( relf_show_symbol_range(relf, scn, records, sh_link, 0, symbol_cnt) == 0 )
+      return 0;
   }
   relf_n();
   relf_indent(indent-1);
@@ -1715,7 +2672,7 @@ int relf_show_symbol_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data, int
   return 1;
 }
 
-int relf_show_dyn_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data)
+int relf_show_dyn_data(relf_struct *relf, Elf_Scn  *scn, relf_records_struct *records)
 {
   int i = 0;
 /*
@@ -1742,7 +2699,7 @@ int relf_show_dyn_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data)
   relf_oa();    // open array
   
   /* extern GElf_Dyn *gelf_getdyn (Elf_Data *__data, int __ndx, GElf_Dyn *__dst); */
-  while( gelf_getdyn(data, i, &dynamic) != NULL )
+  while( relf_get_dyn(records, i, &dynamic) != NULL )
   {
     if ( is_first ) 
       is_first = 0;
@@ -1768,7 +2725,7 @@ int relf_show_dyn_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data)
     {
       relf_cn();
       relf_indent(indent+1);
-      relf_show_string_value("lib_name", elf_strptr(relf->elf, relf->dynstr_section_index, dynamic.d_un.d_val ));
+      relf_show_name_value("lib_name", elf_strptr(relf->elf, relf->dynstr_section_index, dynamic.d_un.d_val ));
     }
     
     relf_n();
@@ -1825,9 +2782,9 @@ int relf_show_dyn_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data)
     sh_info                      	The section header index of the section to which the relocation applies.
 */
 
-int relf_show_rela_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data, int sh_link)
+int relf_show_rela_data(relf_struct *relf, Elf_Scn  *scn, relf_records_struct *records, int sh_link)
 {
-  const char *symbol_name;
+  const char *symbol_name = NULL;
   int i = 0;
 /*
 typedef struct
@@ -1852,7 +2809,7 @@ typedef struct
   relf_oa();    // open array
   
   /* extern GElf_Rela *gelf_getrela (Elf_Data *__data, int __ndx, GElf_Rela *__dst); */
-  while( gelf_getrela(data, i, &rela) != NULL )
+  while( relf_get_rela(records, i, &rela) != NULL )
   {
     if ( is_first ) 
       is_first = 0;
@@ -1862,7 +2819,7 @@ typedef struct
 
     if ( sh_link > 0 )
     {
-      symbol_name = get_symbol_name(relf->elf, sh_link, GELF_R_SYM(rela.r_info));
+      symbol_name = relf_get_symbol_name(relf, sh_link, GELF_R_SYM(rela.r_info));
     }
 
 
@@ -1883,7 +2840,7 @@ typedef struct
     if ( symbol_name != NULL )
     {
       relf_indent(indent+1);
-      relf_show_string_value("symbol_name", symbol_name);
+      relf_show_name_value("symbol_name", symbol_name);
       relf_cn();    
     }
     
@@ -1913,19 +2870,63 @@ typedef struct
   note: corresponding_section_string_table_index is used for ELF_T_SYM only, but is probably obsolete, because this is also aavailable in shdr.sh_link
       see Figure 4-12 in https://refspecs.linuxbase.org/elf/gabi4+/ch4.sheader.html
 */
-int relf_show_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data, int sh_link)
+/*
+  SHT_NOTE section: libelf only converts the note headers to the host byte order,
+  so the notes are read again from the file and decoded by relf_show_note_list() 
+*/
+/* show the notes of size bytes at offset within the SHT_NOTE section scn, the notes are read from the elf file */
+int relf_show_note_data(relf_struct *relf, Elf_Scn  *scn, size_t size, size_t offset)
 {
-  switch(data->d_type)
+  GElf_Shdr shdr;
+  unsigned char *ptr;
+  
+  if ( gelf_getshdr( scn, &shdr ) != &shdr )
+    return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
+  if ( size > RELF_NOTE_SIZE_MAX )
+    return 1;
+  ptr = relf_read_alloc(relf, size, shdr.sh_offset + offset);
+  if ( ptr == NULL )
+    return 1;
+  relf_cn();
+  relf_show_note_list(relf, ptr, size, shdr.sh_addralign, 6);
+  free(ptr);
+  return 1;
+}
+
+/* show symbols, dynamic entries or relocations */
+int relf_show_records(relf_struct *relf, Elf_Scn  *scn, relf_records_struct *records, int sh_link)
+{
+  switch(records->type)
   {
     case ELF_T_SYM:             // used by SHT_SYMTAB, SHT_DYNSYM
-      return relf_show_symbol_data(relf, scn, data, sh_link);
+      return relf_show_symbol_data(relf, scn, records, sh_link);
     case ELF_T_DYN:             // used by SHT_DYNAMIC
-      return relf_show_dyn_data(relf, scn, data);
+      return relf_show_dyn_data(relf, scn, records);
     case ELF_T_RELA:
-      return relf_show_rela_data(relf, scn, data, sh_link);
+      return relf_show_rela_data(relf, scn, records, sh_link);
     default:
-      return 1;
+      break;
+  }
+  return 1;
+}
+
+int relf_show_data(relf_struct *relf, Elf_Scn  *scn, Elf_Data *data, int sh_link)
+{
+  GElf_Shdr shdr;
+  relf_records_struct records;
+  switch(data->d_type)
+  {
+    case ELF_T_SYM:
+    case ELF_T_DYN:
+    case ELF_T_RELA:
+      relf_init_records(relf, &records, scn, data);
+      return relf_show_records(relf, scn, &records, sh_link);
+    default:
+      break;
   }
+  /* SHT_NOTE uses ELF_T_NHDR or ELF_T_NHDR8, which are not available in all libelf versions */
+  if ( gelf_getshdr( scn, &shdr ) == &shdr && shdr.sh_type == SHT_NOTE )
+    return relf_show_note_data(relf, scn, data->d_size, data->d_off);
   return 1;
 }
 
@@ -1945,7 +2946,9 @@ int relf_show_data_list(relf_struct *relf, Elf_Scn  *scn, int corresponding_sect
   GElf_Shdr shdr;
   long long unsigned data_cnt = 0;
   Elf_Data *data = NULL;
+  relf_records_struct records;
   int is_first = 1;
+  int is_ok;
 
   if ( gelf_getshdr( scn, &shdr ) != &shdr )
     return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
@@ -1956,10 +2959,76 @@ int relf_show_data_list(relf_struct *relf, Elf_Scn  *scn, int corresponding_sect
   relf_indent(indent-1);
   relf_oa();    // open array
   
+  /* 
+    symbols, relocations and dynamic entries are decoded from the mapped file (or read in windows with relf_max_memory), 
+    without elf_getdata(), the data block is the same, which libelf would return for an uncompressed section
+  */
+  if ( shdr.sh_size > 0 && relf_init_scn_records(relf, &records, scn, &shdr) )
+  {
+    relf_indent(indent);
+    relf_oo();
+    relf_indent(indent+1);
+    relf_show_et_value(et_d_type, "d_type", records.type);
+    relf_cn();
+    relf_indent(indent+1);
+    relf_show_pure_value("d_size", shdr.sh_size);
+    relf_cn();
+    relf_indent(indent+1);
+    relf_show_pure_value("d_off", 0);
+    relf_cn();
+    relf_indent(indent+1);
+    relf_show_pure_value("d_align", shdr.sh_addralign > 0 ? shdr.sh_addralign : 1);
+    is_ok = relf_show_records(relf, scn, &records, shdr.sh_link);
+    relf_destroy_records(&records);
+    if ( is_ok == 0 )
+      return 0;
+    relf_n();
+    relf_indent(indent);
+    relf_co();
+    relf_n();
+    relf_indent(indent-1);
+    relf_ca(); // close array
+    return 1;
+  }
+  
+  /*
+    with relf_max_memory, libelf does not read the other sections (except string and version tables), 
+    instead the raw section content is described as one block. Notes are read from the elf file, if they fit into the limit.
+  */
+  if ( shdr.sh_size > 0 && relf_max_memory != 0 && relf_is_scn_data_allowed(relf, scn) == 0 
+    && relf_get_scn_skip_reason(relf, elf_ndxscn(scn)) == NULL )
+  {
+    relf_indent(indent);
+    relf_oo();
+    relf_indent(indent+1);
+    relf_show_et_value(et_d_type, "d_type", ELF_T_BYTE);
+    relf_cn();
+    relf_indent(indent+1);
+    relf_show_pure_value("d_size", shdr.sh_size);
+    relf_cn();
+    relf_indent(indent+1);
+    relf_show_pure_value("d_off", 0);
+    relf_cn();
+    relf_indent(indent+1);
+    relf_show_pure_value("d_align", shdr.sh_addralign > 0 ? shdr.sh_addralign : 1);
+    if ( shdr.sh_type == SHT_NOTE && (shdr.sh_flags & SHF_COMPRESSED) == 0 )
+      if ( relf_show_note_data(relf, scn, shdr.sh_size, 0) == 0 )
+        return 0;
+    relf_n();
+    relf_indent(indent);
+    relf_co();
+    relf_n();
+    relf_indent(indent-1);
+    relf_ca(); // close array
+    return 1;
+  }
+  
   for(;;)
   {
     if ( data_cnt >= shdr.sh_size )
       break;
+    if ( relf_is_scn_data_allowed(relf, scn) == 0 )
+      break;            // listed in skipped_section_list
     
     data = elf_getdata(scn , data);     // if data==NULL return first data, otherwise return next data
     if ( data == NULL )
@@ -2011,6 +3080,7 @@ int relf_show_section(relf_struct *relf, Elf_Scn  *scn, int is_data)
   GElf_Shdr shdr;
   int section_string_table_index = 0;
   const char *section_name;
+  const char *skip_reason;
   if ( gelf_getshdr( scn, &shdr ) != &shdr )
     return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
   section_name = elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name );
@@ -2051,7 +3121,7 @@ int relf_show_section(relf_struct *relf, Elf_Scn  *scn, int is_data)
   relf_cn();
     
   relf_indent(indent);
-  relf_show_string_value("sh_name", section_name);
+  relf_show_name_value("sh_name", section_name);
   relf_cn();
   relf_indent(indent);
   relf_show_et_value(et_sh_type, "sh_type", shdr.sh_type);
@@ -2080,6 +3150,13 @@ int relf_show_section(relf_struct *relf, Elf_Scn  *scn, int is_data)
   relf_cn();
   relf_indent(indent);
   relf_show_pure_value("sh_entsize", shdr.sh_entsize);
+  skip_reason = relf_get_scn_skip_reason(relf, elf_ndxscn(scn));
+  if ( skip_reason != NULL )
+  {
+    relf_cn();
+    relf_indent(indent);
+    relf_show_string_value("data_skipped", skip_reason);     // only with relf_max_memory, data_list is empty
+  }
   if ( is_data )
   {
     relf_cn();
@@ -2129,21 +3206,505 @@ int relf_show_section_list(relf_struct *relf)
 
 
 
-int relf_show_section_addr_list(relf_struct *relf)
+/*==========================================*/
+/* Parallel Output */
+/*
+  The sections of the section_list are independent from each other.
+  With option "-j <n>" each section is rendered as a task by a pool of
+  worker threads into a private output buffer (relf_out). 
+  The main thread writes the buffers in the original section order, 
+  so the output is the same as for the sequential relf_show_section_list().
+
+  libelf is not thread safe for the lazy loading of the section data.
+  relf_prepare_parallel() reads all section data in advance, after this,
+  libelf is only used for read access.
+*/
+
+/* read all section data, so that libelf is used read-only by the worker threads */
+int relf_prepare_parallel(relf_struct *relf)
 {
-  int indent = 1;
-  Elf64_Addr addr = 0;
-  Elf_Scn  *scn;        // section descriptor
-  int is_first = 1;
-  /* loop over all sections */
-  relf_indent(indent);
-  relf_member("section_addr_list");
-  relf_n();
-  relf_indent(indent);
-  relf_oa();            // open array
+  Elf_Scn  *scn;
+  GElf_Shdr shdr;
+  Elf_Data *data;
+  
+  if ( !is_crc_table_computed )
+    compute_crc_table();
+  
   scn = elf_nextscn(relf->elf, NULL);
-  //while ( scn != NULL ) 
-  for(;;)
+  while ( scn != NULL ) 
+  {
+    if ( gelf_getshdr( scn, &shdr ) != &shdr )
+      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
+    data = NULL;
+    while( relf_is_scn_data_allowed(relf, scn) && (data = elf_getdata(scn , data)) != NULL )
+      ;
+    if ( shdr.sh_type == SHT_STRTAB )
+      elf_strptr(relf->elf, elf_ndxscn(scn), 0);
+    scn = elf_nextscn(relf->elf, scn);
+  }
+  return 1;
+}
+
+int relf_section_task(relf_task_struct *task)
+{
+  return relf_show_section(task->relf, task->scn, 1);
+}
+
+/* same output as relf_show_section_list(), but uses the worker threads of the pool */
+int relf_show_section_list_parallel(relf_struct *relf, relf_pool_struct *pool)
+{
+  int indent = 1;
+  Elf_Scn  *scn;        // section descriptor
+  relf_task_struct *task_list;
+  size_t task_cnt = 0;
+  size_t submit_cnt = 0;
+  size_t window = (size_t)(pool->thread_cnt+1)*4;     // max number of tasks which are submitted but not yet written
+  size_t i;
+  int result = 1;
+  
+  task_list = (relf_task_struct *)calloc(relf->section_header_total+1, sizeof(relf_task_struct));
+  if ( task_list == NULL )
+    return fprintf(stderr, "relf_show_section_list_parallel: out of memory\n"), 0;
+  scn = elf_nextscn(relf->elf, NULL);
+  while ( scn != NULL && task_cnt <= relf->section_header_total ) 
+  {
+    task_list[task_cnt].fn = relf_section_task;
+    task_list[task_cnt].relf = relf;
+    task_list[task_cnt].scn = scn;
+    task_cnt++;
+    scn = elf_nextscn(relf->elf, scn);
+  }
+  
+  relf_indent(indent);
+  relf_member("section_list");
+  relf_n();
+  relf_indent(indent);
+  relf_oa();            // open array
+  for( i = 0; i < task_cnt; i++ )
+  {
+    /* keep the number of buffered sections limited */
+    while( submit_cnt < task_cnt && submit_cnt < i + window )
+      relf_pool_add(pool, task_list + submit_cnt++);
+    relf_pool_wait(pool, task_list + i);
+    
+    if ( i > 0 )
+      relf_cn();                // comma + new line
+    relf_write(task_list[i].buf.ptr, task_list[i].buf.len);
+    relf_buf_destroy(&(task_list[i].buf));
+    if ( task_list[i].result == 0 )
+    {
+      relf_ca();
+      relf_n();
+      result = 0;
+      break;
+    }
+  }
+  
+  /* wait for the remaining tasks in case of an error */
+  for( i++; i < submit_cnt; i++ )
+  {
+    relf_pool_wait(pool, task_list + i);
+    relf_buf_destroy(&(task_list[i].buf));
+  }
+  free(task_list);
+  if ( result == 0 )
+    return 0;
+  
+  relf_n();
+  relf_indent(indent);
+  relf_ca();    // close array
+  return 1;
+}
+
+
+/*==========================================*/
+/* Section Fragments */
+/*
+  A fragment is the rendered JSON output of one entry of the section_list.
+  Each fragment has a key, which is a hash over everything what is used 
+  to render the section: section header, section name, section data and
+  the data of the sections, which are referenced by the section.
+  If the key of a section is the same as for a fragment of a previous run,
+  then the fragment is reused and the section is not rendered again.
+*/
+
+struct _relf_fragment_struct
+{
+  unsigned long long key;
+  relf_buf_struct buf;
+};
+typedef struct _relf_fragment_struct relf_fragment_struct;
+
+struct _relf_fragment_list_struct
+{
+  relf_fragment_struct *list;   // sorted by key
+  size_t cnt;
+  size_t reuse_cnt;             // number of fragments, which were taken from the previous list
+  size_t cache_cnt;             // number of fragments, which were read from the cache directory
+};
+typedef struct _relf_fragment_list_struct relf_fragment_list_struct;
+
+void relf_fragment_list_init(relf_fragment_list_struct *fl)
+{
+  memset(fl, 0, sizeof(relf_fragment_list_struct));
+}
+
+void relf_fragment_list_destroy(relf_fragment_list_struct *fl)
+{
+  size_t i;
+  for( i = 0; i < fl->cnt; i++ )
+    relf_buf_destroy(&(fl->list[i].buf));
+  free(fl->list);
+  memset(fl, 0, sizeof(relf_fragment_list_struct));
+}
+
+int relf_cmp_fragment(const void *a, const void *b)
+{
+  const relf_fragment_struct *x = (const relf_fragment_struct *)a;
+  const relf_fragment_struct *y = (const relf_fragment_struct *)b;
+  if ( x->key != y->key )
+    return x->key < y->key ? -1 : 1;
+  return 0;
+}
+
+/*
+  Fragment cache: With option "-c <dir>", each rendered fragment is also stored 
+  in the cache directory as file "<key>.json". If a fragment is not available from a 
+  previous run, then it is read from the cache directory before the section is rendered.
+  The cache directory can be deleted at any time.
+  RELF_FRAGMENT_VERSION is part of the key and must be increased if the output of a section changes.
+*/
+#define RELF_FRAGMENT_VERSION 4
+
+/* directory for the fragment cache, option "-c" */
+const char *relf_cache_dir = NULL;
+
+/* returns a malloc'd filename for the fragment with the given key */
+char *relf_cache_get_filename(unsigned long long key, const char *suffix)
+{
+  size_t len = strlen(relf_cache_dir) + 48;
+  char *filename = (char *)malloc(len);
+  if ( filename != NULL )
+    snprintf(filename, len, "%s/%016llx.json%s", relf_cache_dir, key, suffix);
+  return filename;
+}
+
+/* read the fragment with the given key from the cache directory, returns 0 if not found */
+int relf_cache_read(unsigned long long key, relf_buf_struct *buf)
+{
+  char *filename;
+  FILE *fp;
+  long size;
+  int result = 0;
+  
+  if ( relf_cache_dir == NULL )
+    return 0;
+  filename = relf_cache_get_filename(key, "");
+  if ( filename == NULL )
+    return 0;
+  fp = fopen(filename, "rb");
+  free(filename);
+  if ( fp == NULL )
+    return 0;
+  if ( fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0 )
+  {
+    if ( relf_buf_reserve(buf, (size_t)size+1) != 0 )
+    {
+      if ( fread(buf->ptr, 1, (size_t)size, fp) == (size_t)size )
+      {
+        buf->len = (size_t)size;
+        buf->ptr[buf->len] = '\0';
+        result = 1;
+      }
+      else
+      {
+        relf_buf_destroy(buf);
+      }
+    }
+  }
+  fclose(fp);
+  return result;
+}
+
+/* write the fragment to the cache directory, a temp file is used so that other processes never see a partial fragment */
+int relf_cache_write(unsigned long long key, relf_buf_struct *buf)
+{
+  char suffix[32];
+  char *filename;
+  char *tmp_filename;
+  FILE *fp;
+  int result = 0;
+  
+  if ( relf_cache_dir == NULL )
+    return 0;
+  snprintf(suffix, sizeof(suffix), ".%ld.tmp", (long)getpid());
+  filename = relf_cache_get_filename(key, "");
+  tmp_filename = relf_cache_get_filename(key, suffix);
+  if ( filename != NULL && tmp_filename != NULL )
+  {
+    fp = fopen(tmp_filename, "wb");
+    if ( fp != NULL )
+    {
+      if ( fwrite(buf->ptr, 1, buf->len, fp) == buf->len )
+        result = 1;
+      if ( fclose(fp) != 0 )
+        result = 0;
+      if ( result == 0 || rename(tmp_filename, filename) != 0 )
+      {
+        unlink(tmp_filename);
+        result = 0;
+      }
+    }
+  }
+  free(filename);
+  free(tmp_filename);
+  return result;
+}
+
+/* returns NULL if there is no fragment with that key */
+relf_fragment_struct *relf_fragment_list_find(relf_fragment_list_struct *fl, unsigned long long key)
+{
+  relf_fragment_struct f;
+  if ( fl == NULL || fl->cnt == 0 )
+    return NULL;
+  f.key = key;
+  return (relf_fragment_struct *)bsearch(&f, fl->list, fl->cnt, sizeof(relf_fragment_struct), relf_cmp_fragment);
+}
+
+/* hash over section header, section name and section data */
+unsigned long long relf_get_section_content_hash(relf_struct *relf, Elf_Scn *scn)
+{
+  GElf_Shdr shdr;
+  Elf_Data *data = NULL;
+  const char *name;
+  size_t index = elf_ndxscn(scn);
+  unsigned long long h = 0;
+  
+  h = relf_hash64(h, &index, sizeof(size_t));
+  if ( gelf_getshdr( scn, &shdr ) != &shdr )
+    return h;
+  h = relf_hash64(h, &shdr, sizeof(GElf_Shdr));
+  name = elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name );
+  if ( name != NULL )
+    h = relf_hash64(h, name, strlen(name));
+  if ( relf_is_scn_data_allowed(relf, scn) == 0 )
+  {
+    /* with relf_max_memory: use the crc of the file content instead of the data, SHT_NOBITS has no content */
+    unsigned long crc;
+    if ( shdr.sh_type != SHT_NOBITS && relf_get_file_crc(relf, shdr.sh_size, shdr.sh_offset, &crc) != 0 )
+      h = relf_hash64(h, &crc, sizeof(unsigned long));
+    return h;
+  }
+  while( (data = elf_getdata(scn , data)) != NULL )
+  {
+    h = relf_hash64(h, &(data->d_type), sizeof(Elf_Type));
+    h = relf_hash64(h, &(data->d_size), sizeof(size_t));
+    h = relf_hash64(h, &(data->d_off), sizeof(data->d_off));
+    h = relf_hash64(h, &(data->d_align), sizeof(size_t));
+    if ( data->d_buf != NULL )
+      h = relf_hash64(h, data->d_buf, data->d_size);
+  }
+  return h;
+}
+
+/*
+  Calculate the fragment key for all sections, key_list[i] is the key for section index i.
+  extra_hash is added to all keys (for example the hash of the string dictionary).
+  returns a malloc'd array with relf->section_header_total elements or NULL
+*/
+unsigned long long *relf_get_section_key_list(relf_struct *relf, unsigned long long extra_hash)
+{
+  unsigned long long *content_list;
+  unsigned long long *key_list;
+  unsigned long long all_hash = 0;
+  size_t cnt = relf->section_header_total;
+  size_t i, link;
+  Elf_Scn *scn;
+  GElf_Shdr shdr;
+  
+  content_list = (unsigned long long *)calloc(cnt+1, sizeof(unsigned long long));
+  key_list = (unsigned long long *)calloc(cnt+1, sizeof(unsigned long long));
+  if ( content_list == NULL || key_list == NULL )
+    return free(content_list), free(key_list), fprintf(stderr, "relf_get_section_key_list: out of memory\n"), NULL;
+  
+  for( i = 1; i < cnt; i++ )
+  {
+    scn = elf_getscn(relf->elf, i);
+    if ( scn != NULL )
+      content_list[i] = relf_get_section_content_hash(relf, scn);
+    all_hash = relf_hash64(all_hash, content_list+i, sizeof(unsigned long long));
+  }
+  
+  for( i = 1; i < cnt; i++ )
+  {
+    key_list[i] = relf_hash64(extra_hash, content_list+i, sizeof(unsigned long long));
+    scn = elf_getscn(relf->elf, i);
+    if ( scn == NULL || gelf_getshdr( scn, &shdr ) != &shdr )
+      continue;
+    link = shdr.sh_link < cnt ? shdr.sh_link : 0;
+    switch(shdr.sh_type)
+    {
+      case SHT_SYMTAB:
+      case SHT_DYNSYM:
+        /* obj_crc and obj_data are taken from other sections */
+        key_list[i] = relf_hash64(key_list[i], &all_hash, sizeof(unsigned long long));
+        break;
+      case SHT_RELA:
+        /* symbol names are taken from the symbol table and its string table */
+        key_list[i] = relf_hash64(key_list[i], content_list+link, sizeof(unsigned long long));
+        scn = elf_getscn(relf->elf, link);
+        if ( link > 0 && scn != NULL && gelf_getshdr( scn, &shdr ) == &shdr && shdr.sh_link < cnt )
+          key_list[i] = relf_hash64(key_list[i], content_list+shdr.sh_link, sizeof(unsigned long long));
+        break;
+      case SHT_DYNAMIC:
+        if ( relf->dynstr_section_index < cnt )
+          key_list[i] = relf_hash64(key_list[i], content_list+relf->dynstr_section_index, sizeof(unsigned long long));
+        break;
+    }
+  }
+  free(content_list);
+  return key_list;
+}
+
+/*
+  Same output as relf_show_section_list(), but sections are only rendered
+  if there is no fragment with the same key in prev (prev may be NULL) or 
+  in the cache directory. The fragments of all sections are stored in next.
+  Buffers of reused fragments are moved from prev to next.
+*/
+int relf_show_section_list_fragments(relf_struct *relf, unsigned long long extra_hash, relf_fragment_list_struct *prev, relf_fragment_list_struct *next)
+{
+  int indent = 1;
+  Elf_Scn  *scn;        // section descriptor
+  relf_task_struct *task_list;
+  unsigned long long *key_list;
+  unsigned char *is_rendered_list;      // 1 if the fragment is not from prev or from the cache
+  relf_fragment_struct *f;
+  size_t task_cnt = 0;
+  size_t i;
+  int result = 1;
+  
+  relf_fragment_list_init(next);
+  extra_hash = relf_hash64(extra_hash, elf_getident(relf->elf, NULL), EI_NIDENT);
+  i = RELF_FRAGMENT_VERSION;
+  extra_hash = relf_hash64(extra_hash, &i, sizeof(size_t));
+  extra_hash = relf_hash64(extra_hash, &relf_max_memory, sizeof(size_t));
+  key_list = relf_get_section_key_list(relf, extra_hash);
+  if ( key_list == NULL )
+    return relf_show_section_list(relf);
+  task_list = (relf_task_struct *)calloc(relf->section_header_total+1, sizeof(relf_task_struct));
+  next->list = (relf_fragment_struct *)calloc(relf->section_header_total+1, sizeof(relf_fragment_struct));
+  is_rendered_list = (unsigned char *)calloc(relf->section_header_total+1, 1);
+  if ( task_list == NULL || next->list == NULL || is_rendered_list == NULL )
+  {
+    free(key_list);
+    free(task_list);
+    free(next->list);
+    free(is_rendered_list);
+    next->list = NULL;
+    return relf_show_section_list(relf);
+  }
+  
+  scn = elf_nextscn(relf->elf, NULL);
+  while ( scn != NULL && task_cnt < relf->section_header_total ) 
+  {
+    task_list[task_cnt].fn = relf_section_task;
+    task_list[task_cnt].relf = relf;
+    task_list[task_cnt].scn = scn;
+    task_list[task_cnt].is_done = 0;
+    next->list[task_cnt].key = key_list[elf_ndxscn(scn) < relf->section_header_total ? elf_ndxscn(scn) : 0];
+    f = relf_fragment_list_find(prev, next->list[task_cnt].key);
+    if ( f != NULL && f->buf.ptr != NULL )
+    {
+      task_list[task_cnt].buf = f->buf;         // move the buffer from prev
+      relf_buf_init(&(f->buf));
+      task_list[task_cnt].result = 1;
+      task_list[task_cnt].is_done = 1;
+      next->reuse_cnt++;
+    }
+    else if ( relf_cache_read(next->list[task_cnt].key, &(task_list[task_cnt].buf)) != 0 )
+    {
+      task_list[task_cnt].result = 1;
+      task_list[task_cnt].is_done = 1;
+      next->cache_cnt++;
+    }
+    else 
+    {
+      is_rendered_list[task_cnt] = 1;
+      if ( relf_pool != NULL )
+        relf_pool_add(relf_pool, task_list + task_cnt);
+    }
+    task_cnt++;
+    scn = elf_nextscn(relf->elf, scn);
+  }
+  free(key_list);
+  
+  relf_indent(indent);
+  relf_member("section_list");
+  relf_n();
+  relf_indent(indent);
+  relf_oa();            // open array
+  for( i = 0; i < task_cnt; i++ )
+  {
+    if ( relf_pool != NULL )
+      relf_pool_wait(relf_pool, task_list + i);
+    else if ( task_list[i].is_done == 0 && result != 0 )
+      relf_pool_run_task(NULL, task_list + i);
+    
+    if ( result != 0 )
+    {
+      if ( i > 0 )
+        relf_cn();                // comma + new line
+      relf_write(task_list[i].buf.ptr, task_list[i].buf.len);
+      if ( task_list[i].result == 0 )
+      {
+        relf_ca();
+        relf_n();
+        result = 0;
+      }
+    }
+    /* only complete fragments are kept */
+    if ( task_list[i].result != 0 )
+    {
+      if ( is_rendered_list[i] )
+        relf_cache_write(next->list[i].key, &(task_list[i].buf));
+      next->list[next->cnt].key = next->list[i].key;
+      next->list[next->cnt].buf = task_list[i].buf;
+      next->cnt++;
+    }
+    else
+    {
+      relf_buf_destroy(&(task_list[i].buf));
+    }
+  }
+  free(task_list);
+  free(is_rendered_list);
+  qsort(next->list, next->cnt, sizeof(relf_fragment_struct), relf_cmp_fragment);
+  if ( result == 0 )
+    return 0;
+  
+  relf_n();
+  relf_indent(indent);
+  relf_ca();    // close array
+  return 1;
+}
+
+
+int relf_show_section_addr_list(relf_struct *relf)
+{
+  int indent = 1;
+  Elf64_Addr addr = 0;
+  Elf_Scn  *scn;        // section descriptor
+  int is_first = 1;
+  /* loop over all sections */
+  relf_indent(indent);
+  relf_member("section_addr_list");
+  relf_n();
+  relf_indent(indent);
+  relf_oa();            // open array
+  scn = elf_nextscn(relf->elf, NULL);
+  //while ( scn != NULL ) 
+  for(;;)
   {
     scn = get_section_by_address(relf->elf, &addr);
     if ( scn == NULL )
@@ -2169,33 +3730,1720 @@ int relf_show_section_addr_list(relf_struct *relf)
 }
 
 
-int default_return_value = 123;
-
-int main( int argc , char ** argv )
+/*
+  Sections, which are not read because of relf_max_memory (option "-m"), see relf_init_memory_budget().
+  The data_list of these sections is empty, "data_skipped" of the section contains the reason.
+*/
+int relf_show_skipped_section_list(relf_struct *relf)
 {
-  relf_struct relf;
-  
-  if ( argc < 2)
-    return 0;
-  
-  if ( relf_init(&relf, argv[1]) == 0 )
-    return 0;
-  relf_oo();
-  relf_show_elf_header(&relf);
-  relf_cn();
-  
-  relf_show_program_header_list(&relf);
-  relf_cn();
+  int indent = 1;
+  Elf_Scn *scn;
+  GElf_Shdr shdr;
+  const char *name;
+  size_t i;
+  int is_first = 1;
   
-  relf_show_section_list(&relf);
-  relf_cn();
-
-  relf_show_section_addr_list(&relf);
+  relf_indent(indent);
+  relf_member("skipped_section_list");
   relf_n();
-
-  relf_co();
+  relf_indent(indent);
+  relf_oa();
+  for( i = 1; i < relf->section_header_total; i++ )
+  {
+    if ( relf->is_scn_skipped_list[i] == 0 )
+      continue;
+    scn = elf_getscn(relf->elf, i);
+    if ( scn == NULL || gelf_getshdr( scn, &shdr ) != &shdr )
+      continue;
+    name = elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name );
+    if ( is_first )
+      is_first = 0;
+    else
+      relf_cn();
+    relf_indent(indent+1);
+    relf_printf("{");
+    relf_show_pure_value("section_index", i);
+    relf_printf(", ");
+    relf_show_name_value("sh_name", name != NULL ? name : "");
+    relf_printf(", ");
+    relf_show_pure_value("sh_size", shdr.sh_size);
+    relf_printf(", ");
+    relf_show_string_value("reason", relf_get_scn_skip_reason(relf, i));
+    relf_printf("}");
+  }
   relf_n();
+  relf_indent(indent);
+  relf_ca();
+  return 1;
+}
+
+
+/* add the symbol names of the records of one section (or data block) to strdict */
+int relf_add_record_names_to_strdict(relf_struct *relf, relf_strdict_struct *strdict, GElf_Shdr *shdr, relf_records_struct *records)
+{
+  GElf_Sym symbol;
+  GElf_Dyn dynamic;
+  GElf_Rela rela;
+  int i = 0;
   
+  switch(records->type)
+  {
+    case ELF_T_SYM:
+      while( relf_get_sym(records, i, &symbol) != NULL )
+      {
+        if ( relf_strdict_add(strdict, elf_strptr(relf->elf, shdr->sh_link, symbol.st_name )) == 0 )
+          return 0;
+        i++;
+      }
+      break;
+    case ELF_T_DYN:
+      while( relf_get_dyn(records, i, &dynamic) != NULL )
+      {
+        if ( dynamic.d_tag == DT_NEEDED )
+          if ( relf_strdict_add(strdict, elf_strptr(relf->elf, relf->dynstr_section_index, dynamic.d_un.d_val )) == 0 )
+            return 0;
+        i++;
+      }
+      break;
+    case ELF_T_RELA:
+      if ( shdr->sh_link > 0 )
+      {
+        while( relf_get_rela(records, i, &rela) != NULL )
+        {
+          if ( relf_strdict_add(strdict, relf_get_symbol_name(relf, shdr->sh_link, GELF_R_SYM(rela.r_info))) == 0 )
+            return 0;
+          i++;
+        }
+      }
+      break;
+    default:
+      break;
+  }
+  return 1;
+}
+
+/*
+  Collect all names, which are shown with relf_show_name_value().
+  The order of the strings follows the order of the JSON output.
+*/
+int relf_add_names_to_strdict(relf_struct *relf, relf_strdict_struct *strdict)
+{
+  Elf_Scn  *scn;        // section descriptor
+  GElf_Shdr shdr;
+  Elf_Data *data;
+  long long unsigned data_cnt;
+  relf_records_struct records;
+  int is_ok;
+  
+  scn = elf_nextscn(relf->elf, NULL);
+  while ( scn != NULL ) 
+  {
+    if ( gelf_getshdr( scn, &shdr ) != &shdr )
+      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
+    if ( relf_strdict_add(strdict, elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name )) == 0 )
+      return 0;
+    
+    if ( relf_init_scn_records(relf, &records, scn, &shdr) )
+    {
+      is_ok = relf_add_record_names_to_strdict(relf, strdict, &shdr, &records);
+      relf_destroy_records(&records);
+      if ( is_ok == 0 )
+        return 0;
+    }
+    else
+    {
+      /* same loop as in relf_show_data_list() */
+      data_cnt = 0;
+      data = NULL;
+      for(;;)
+      {
+        if ( data_cnt >= shdr.sh_size )
+          break;
+        if ( relf_is_scn_data_allowed(relf, scn) == 0 )
+          break;
+        data = elf_getdata(scn , data);
+        if ( data == NULL )
+          break;
+        relf_init_records(relf, &records, scn, data);
+        if ( relf_add_record_names_to_strdict(relf, strdict, &shdr, &records) == 0 )
+          return 0;
+        data_cnt += data->d_size;
+      }
+    }
+    scn = elf_nextscn(relf->elf, scn);
+  }
+  return 1;
+}
+
+/* output the string dictionary as "string_list" */
+void relf_show_string_list(relf_strdict_struct *strdict)
+{
+  int indent = 1;
+  size_t i;
+  relf_indent(indent);
+  relf_member("string_list");
+  relf_n();
+  relf_indent(indent);
+  relf_oa();            // open array
+  for( i = 0; i < strdict->cnt; i++ )
+  {
+    if ( i > 0 )
+      relf_cn();
+    relf_indent(indent+1);
+    relf_printf("\"%s\"", strdict->list[i]);
+  }
+  relf_n();
+  relf_indent(indent);
+  relf_ca();    // close array
+}
+
+
+/*==========================================*/
+/* Query Server */
+/*
+  elf2json -S <socket>
+
+  Listen on a local unix socket and answer queries about elf files.
+  Each request is a JSON object in one line, each response is also a 
+  JSON object in one line. Examples:
+  
+    {"file": "a.out", "query": "symbols_in_section", "section": ".text"}
+    {"file": "a.out", "query": "symbol_by_name", "name": "main"}
+    {"file": "a.out", "query": "section_by_address", "address": "0x1040"}
+    
+  Response:
+    {"file": "a.out", "query": "symbol_by_name", "result": [{"st_name": "main", ... }]}
+    {"error": "..."}
+    
+  The last RELF_SERVER_HANDLE_MAX elf files are kept open together with 
+  a symbol table sorted by name, a symbol table sorted by section and 
+  address and a section table sorted by address. A file is read again, if 
+  it has been changed since the last request.
+*/
+
+#if !defined(__MINGW32__) && !defined(__MINGW64__)
+
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <signal.h>
+#include <errno.h>
+
+#define RELF_SERVER_HANDLE_MAX 8
+#define RELF_SERVER_CLIENT_MAX 64
+#define RELF_REQUEST_MEMBER_MAX 8
+#define RELF_REQUEST_STRING_MAX 4096
+
+struct _relf_symbol_entry_struct
+{
+  const char *name;
+  GElf_Sym sym;
+  size_t symtab_section_index;  // section index of the symbol table (.symtab or .dynsym)
+};
+typedef struct _relf_symbol_entry_struct relf_symbol_entry_struct;
+
+struct _relf_section_entry_struct
+{
+  size_t section_index;
+  const char *name;
+  GElf_Shdr shdr;
+};
+typedef struct _relf_section_entry_struct relf_section_entry_struct;
+
+struct _relf_handle_struct
+{
+  char *filename;
+  struct stat st;               // used to detect changes of the file
+  relf_struct relf;
+  unsigned long last_used;      // for the LRU replacement
+  
+  relf_symbol_entry_struct *symbol_list;        // sorted by name
+  relf_symbol_entry_struct **symbol_by_section;  // sorted by st_shndx and st_value
+  size_t symbol_cnt;
+  size_t symbol_max;
+  
+  relf_section_entry_struct *section_list;      // sorted by section index
+  relf_section_entry_struct **section_by_addr;  // sections with SHF_ALLOC, sorted by sh_addr
+  size_t section_cnt;
+  size_t section_max;
+  size_t section_addr_cnt;
+  GElf_Xword section_size_max;  // max sh_size in section_by_addr
+};
+typedef struct _relf_handle_struct relf_handle_struct;
+
+struct _relf_request_struct
+{
+  int cnt;
+  char key[RELF_REQUEST_MEMBER_MAX][64];
+  char value[RELF_REQUEST_MEMBER_MAX][RELF_REQUEST_STRING_MAX];
+};
+typedef struct _relf_request_struct relf_request_struct;
+
+struct _relf_client_struct
+{
+  int fd;
+  relf_buf_struct in;           // received bytes, which do not yet form a complete line
+};
+typedef struct _relf_client_struct relf_client_struct;
+
+relf_handle_struct *relf_handle_list[RELF_SERVER_HANDLE_MAX];
+unsigned long relf_handle_clock = 0;
+volatile sig_atomic_t relf_is_stop = 0;
+
+void relf_stop_signal(int sig)
+{
+  relf_is_stop = 1;
+}
+
+/* visitor callbacks to fill the tables of the handle */
+int relf_handle_add_section(void *user, relf_struct *relf, Elf_Scn *scn, const GElf_Shdr *shdr, const char *name)
+{
+  relf_handle_struct *h = (relf_handle_struct *)user;
+  relf_section_entry_struct *e;
+  if ( h->section_cnt >= h->section_max )
+  {
+    size_t new_max = h->section_max == 0 ? 64 : h->section_max*2;
+    e = (relf_section_entry_struct *)realloc(h->section_list, new_max*sizeof(relf_section_entry_struct));
+    if ( e == NULL )
+      return fprintf(stderr, "relf_handle: out of memory\n"), 0;
+    h->section_list = e;
+    h->section_max = new_max;
+  }
+  e = h->section_list + h->section_cnt++;
+  e->section_index = elf_ndxscn(scn);
+  e->name = name;
+  e->shdr = *shdr;
+  return 1;
+}
+
+int relf_handle_add_symbol(void *user, relf_struct *relf, Elf_Scn *scn, size_t index, const GElf_Sym *sym, const char *name)
+{
+  relf_handle_struct *h = (relf_handle_struct *)user;
+  relf_symbol_entry_struct *e;
+  if ( h->symbol_cnt >= h->symbol_max )
+  {
+    size_t new_max = h->symbol_max == 0 ? 1024 : h->symbol_max*2;
+    e = (relf_symbol_entry_struct *)realloc(h->symbol_list, new_max*sizeof(relf_symbol_entry_struct));
+    if ( e == NULL )
+      return fprintf(stderr, "relf_handle: out of memory\n"), 0;
+    h->symbol_list = e;
+    h->symbol_max = new_max;
+  }
+  e = h->symbol_list + h->symbol_cnt++;
+  e->name = name;
+  e->sym = *sym;
+  e->symtab_section_index = elf_ndxscn(scn);
+  return 1;
+}
+
+int relf_cmp_symbol_by_name(const void *a, const void *b)
+{
+  const relf_symbol_entry_struct *x = (const relf_symbol_entry_struct *)a;
+  const relf_symbol_entry_struct *y = (const relf_symbol_entry_struct *)b;
+  int r = strcmp(x->name, y->name);
+  if ( r != 0 )
+    return r;
+  if ( x->symtab_section_index != y->symtab_section_index )
+    return x->symtab_section_index < y->symtab_section_index ? -1 : 1;
+  if ( x->sym.st_value != y->sym.st_value )
+    return x->sym.st_value < y->sym.st_value ? -1 : 1;
+  return 0;
+}
+
+int relf_cmp_symbol_by_section(const void *a, const void *b)
+{
+  const relf_symbol_entry_struct *x = *(const relf_symbol_entry_struct **)a;
+  const relf_symbol_entry_struct *y = *(const relf_symbol_entry_struct **)b;
+  if ( x->sym.st_shndx != y->sym.st_shndx )
+    return x->sym.st_shndx < y->sym.st_shndx ? -1 : 1;
+  if ( x->sym.st_value != y->sym.st_value )
+    return x->sym.st_value < y->sym.st_value ? -1 : 1;
+  return strcmp(x->name, y->name);
+}
+
+int relf_cmp_section_by_addr(const void *a, const void *b)
+{
+  const relf_section_entry_struct *x = *(const relf_section_entry_struct **)a;
+  const relf_section_entry_struct *y = *(const relf_section_entry_struct **)b;
+  if ( x->shdr.sh_addr != y->shdr.sh_addr )
+    return x->shdr.sh_addr < y->shdr.sh_addr ? -1 : 1;
+  return x->section_index < y->section_index ? -1 : (x->section_index > y->section_index ? 1 : 0);
+}
+
+void relf_handle_destroy(relf_handle_struct *h)
+{
+  if ( h == NULL )
+    return;
+  relf_destroy(&(h->relf));
+  free(h->filename);
+  free(h->symbol_list);
+  free(h->symbol_by_section);
+  free(h->section_list);
+  free(h->section_by_addr);
+  free(h);
+}
+
+/* open the elf file and build the tables */
+relf_handle_struct *relf_handle_open(const char *filename, struct stat *st)
+{
+  relf_handle_struct *h;
+  relf_visitor_struct visitor;
+  size_t i;
+  
+  h = (relf_handle_struct *)calloc(1, sizeof(relf_handle_struct));
+  if ( h == NULL )
+    return fprintf(stderr, "relf_handle: out of memory\n"), NULL;
+  if ( relf_init(&(h->relf), filename) == 0 )
+    return free(h), NULL;
+  h->filename = strdup(filename);
+  h->st = *st;
+  
+  memset(&visitor, 0, sizeof(relf_visitor_struct));
+  visitor.section = relf_handle_add_section;
+  visitor.symbol = relf_handle_add_symbol;
+  if ( h->filename == NULL || relf_visit(&(h->relf), &visitor, h) == 0 )
+    return relf_handle_destroy(h), NULL;
+  
+  if ( h->symbol_cnt > 0 )
+  {
+    qsort(h->symbol_list, h->symbol_cnt, sizeof(relf_symbol_entry_struct), relf_cmp_symbol_by_name);
+    h->symbol_by_section = (relf_symbol_entry_struct **)malloc(h->symbol_cnt*sizeof(relf_symbol_entry_struct *));
+    if ( h->symbol_by_section == NULL )
+      return relf_handle_destroy(h), NULL;
+    for( i = 0; i < h->symbol_cnt; i++ )
+      h->symbol_by_section[i] = h->symbol_list + i;
+    qsort(h->symbol_by_section, h->symbol_cnt, sizeof(relf_symbol_entry_struct *), relf_cmp_symbol_by_section);
+  }
+  
+  if ( h->section_cnt > 0 )
+  {
+    h->section_by_addr = (relf_section_entry_struct **)malloc(h->section_cnt*sizeof(relf_section_entry_struct *));
+    if ( h->section_by_addr == NULL )
+      return relf_handle_destroy(h), NULL;
+    for( i = 0; i < h->section_cnt; i++ )
+    {
+      if ( (h->section_list[i].shdr.sh_flags & SHF_ALLOC) != 0 && h->section_list[i].shdr.sh_size > 0 )
+      {
+        h->section_by_addr[h->section_addr_cnt++] = h->section_list + i;
+        if ( h->section_size_max < h->section_list[i].shdr.sh_size )
+          h->section_size_max = h->section_list[i].shdr.sh_size;
+      }
+    }
+    qsort(h->section_by_addr, h->section_addr_cnt, sizeof(relf_section_entry_struct *), relf_cmp_section_by_addr);
+  }
+  return h;
+}
+
+/* compare the modification time, with nanosecond resolution if available */
+int relf_is_same_mtime(const struct stat *a, const struct stat *b)
+{
+#if defined(__APPLE__)
+  return a->st_mtimespec.tv_sec == b->st_mtimespec.tv_sec && a->st_mtimespec.tv_nsec == b->st_mtimespec.tv_nsec;
+#elif defined(st_mtime)
+  /* st_mtime is a macro for st_mtim.tv_sec if st_mtim is available */
+  return a->st_mtim.tv_sec == b->st_mtim.tv_sec && a->st_mtim.tv_nsec == b->st_mtim.tv_nsec;
+#else
+  return a->st_mtime == b->st_mtime;
+#endif
+}
+
+/* return the handle for the file, the file is opened or read again if required */
+relf_handle_struct *relf_handle_get(const char *filename)
+{
+  struct stat st;
+  int i;
+  int lru = 0;
+  
+  if ( stat(filename, &st) != 0 )
+    return perror(filename), NULL;
+  
+  for( i = 0; i < RELF_SERVER_HANDLE_MAX; i++ )
+  {
+    if ( relf_handle_list[i] != NULL && strcmp(relf_handle_list[i]->filename, filename) == 0 )
+    {
+      if ( relf_is_same_mtime(&(relf_handle_list[i]->st), &st) 
+        && relf_handle_list[i]->st.st_size == st.st_size 
+        && relf_handle_list[i]->st.st_ino == st.st_ino )
+      {
+        relf_handle_list[i]->last_used = ++relf_handle_clock;
+        return relf_handle_list[i];
+      }
+      /* file has been changed */
+      relf_handle_destroy(relf_handle_list[i]);
+      relf_handle_list[i] = NULL;
+      lru = i;
+      break;
+    }
+    if ( relf_handle_list[i] == NULL || ( relf_handle_list[lru] != NULL && relf_handle_list[i]->last_used < relf_handle_list[lru]->last_used ) )
+      lru = i;
+  }
+  
+  relf_handle_destroy(relf_handle_list[lru]);
+  relf_handle_list[lru] = relf_handle_open(filename, &st);
+  if ( relf_handle_list[lru] != NULL )
+    relf_handle_list[lru]->last_used = ++relf_handle_clock;
+  return relf_handle_list[lru];
+}
+
+/* parse a string at *s into value, returns 0 on error */
+int relf_parse_json_string(const char **s, char *value, size_t max)
+{
+  const char *p = *s;
+  size_t len = 0;
+  char c;
+  if ( *p != '\"' )
+    return 0;
+  p++;
+  while( *p != '\"' )
+  {
+    if ( *p == '\0' )
+      return 0;
+    c = *p++;
+    if ( c == '\\' )
+    {
+      c = *p++;
+      switch(c)
+      {
+        case 'n': c = '\n'; break;
+        case 't': c = '\t'; break;
+        case 'r': c = '\r'; break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'u': 
+          if ( strlen(p) < 4 )
+            return 0;
+          p += 4; c = '?';  // non-ascii characters are not supported
+          break;
+        case '\0': 
+          return 0;
+        default: break;         // '\"', '\\', '/'
+      }
+    }
+    if ( len+1 < max )
+      value[len++] = c;
+  }
+  value[len] = '\0';
+  *s = p+1;
+  return 1;
+}
+
+/* 
+  parse a JSON object with string, number or literal members (nested objects are not supported)
+  returns 0 on error
+*/
+int relf_parse_request(const char *s, relf_request_struct *req)
+{
+  size_t len;
+  req->cnt = 0;
+  while( *s == ' ' || *s == '\t' ) s++;
+  if ( *s++ != '{' )
+    return 0;
+  for(;;)
+  {
+    while( *s == ' ' || *s == '\t' ) s++;
+    if ( *s == '}' )
+      return 1;
+    if ( req->cnt >= RELF_REQUEST_MEMBER_MAX )
+      return 0;
+    if ( relf_parse_json_string(&s, req->key[req->cnt], 64) == 0 )
+      return 0;
+    while( *s == ' ' || *s == '\t' ) s++;
+    if ( *s++ != ':' )
+      return 0;
+    while( *s == ' ' || *s == '\t' ) s++;
+    if ( *s == '\"' )
+    {
+      if ( relf_parse_json_string(&s, req->value[req->cnt], RELF_REQUEST_STRING_MAX) == 0 )
+        return 0;
+    }
+    else
+    {
+      len = 0;
+      while( *s != ',' && *s != '}' && *s != ' ' && *s != '\t' && *s != '\0' )
+      {
+        if ( len+1 < RELF_REQUEST_STRING_MAX )
+          req->value[req->cnt][len++] = *s;
+        s++;
+      }
+      req->value[req->cnt][len] = '\0';
+      if ( len == 0 )
+        return 0;
+    }
+    req->cnt++;
+    while( *s == ' ' || *s == '\t' ) s++;
+    if ( *s == ',' )
+      s++;
+    else if ( *s != '}' )
+      return 0;
+  }
+}
+
+/* returns NULL if the member does not exist */
+const char *relf_request_get(relf_request_struct *req, const char *key)
+{
+  int i;
+  for( i = 0; i < req->cnt; i++ )
+    if ( strcmp(req->key[i], key) == 0 )
+      return req->value[i];
+  return NULL;
+}
+
+const char *relf_handle_get_section_name(relf_handle_struct *h, size_t section_index)
+{
+  if ( section_index > 0 && section_index <= h->section_cnt && h->section_list[section_index-1].section_index == section_index )
+    return h->section_list[section_index-1].name;
+  return "";
+}
+
+/* names and strings from the elf file or from the request are escaped */
+void relf_show_escaped_string_value(const char *variable, const char *value)
+{
+  relf_show_raw_string_value(variable, (const unsigned char *)value, strlen(value));
+}
+
+void relf_show_symbol_entry(relf_handle_struct *h, relf_symbol_entry_struct *e)
+{
+  relf_printf("{");
+  relf_show_escaped_string_value("st_name", e->name);
+  relf_c();
+  relf_show_pure_value("st_value", e->sym.st_value);
+  relf_c();
+  relf_show_pure_value("st_size", e->sym.st_size);
+  relf_c();
+  relf_show_pure_value("st_shndx", e->sym.st_shndx);
+  relf_c();
+  relf_show_et_value(et_st_bind, "ST_BIND", GELF_ST_BIND(e->sym.st_info));
+  relf_c();
+  relf_show_et_value(et_st_type, "ST_TYPE", GELF_ST_TYPE(e->sym.st_info));
+  relf_c();
+  relf_show_escaped_string_value("sh_name", relf_handle_get_section_name(h, e->sym.st_shndx));
+  relf_c();
+  relf_show_escaped_string_value("symtab", relf_handle_get_section_name(h, e->symtab_section_index));
+  relf_printf("}");
+}
+
+void relf_show_section_entry(relf_section_entry_struct *e)
+{
+  relf_printf("{");
+  relf_show_pure_value("section_index", e->section_index);
+  relf_c();
+  relf_show_escaped_string_value("sh_name", e->name);
+  relf_c();
+  relf_show_et_value(et_sh_type, "sh_type", e->shdr.sh_type);
+  relf_c();
+  relf_show_pure_value("sh_addr", e->shdr.sh_addr);
+  relf_c();
+  relf_show_pure_value("sh_size", e->shdr.sh_size);
+  relf_printf("}");
+}
+
+/* all symbols, which are located in a section with the given name */
+void relf_query_symbols_in_section(relf_handle_struct *h, const char *section_name)
+{
+  size_t i, lo, hi, mid;
+  int is_first = 1;
+  for( i = 0; i < h->section_cnt; i++ )
+  {
+    if ( strcmp(h->section_list[i].name, section_name) != 0 )
+      continue;
+    /* find the first symbol with st_shndx == section_index */
+    lo = 0;
+    hi = h->symbol_cnt;
+    while( lo < hi )
+    {
+      mid = (lo + hi) / 2;
+      if ( h->symbol_by_section[mid]->sym.st_shndx < h->section_list[i].section_index )
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    while( lo < h->symbol_cnt && h->symbol_by_section[lo]->sym.st_shndx == h->section_list[i].section_index )
+    {
+      if ( is_first )
+        is_first = 0;
+      else
+        relf_c();
+      relf_show_symbol_entry(h, h->symbol_by_section[lo]);
+      lo++;
+    }
+  }
+}
+
+void relf_query_symbol_by_name(relf_handle_struct *h, const char *name)
+{
+  size_t lo = 0, hi = h->symbol_cnt, mid;
+  int is_first = 1;
+  while( lo < hi )
+  {
+    mid = (lo + hi) / 2;
+    if ( strcmp(h->symbol_list[mid].name, name) < 0 )
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  while( lo < h->symbol_cnt && strcmp(h->symbol_list[lo].name, name) == 0 )
+  {
+    if ( is_first )
+      is_first = 0;
+    else
+      relf_c();
+    relf_show_symbol_entry(h, h->symbol_list + lo);
+    lo++;
+  }
+}
+
+void relf_query_section_by_address(relf_handle_struct *h, GElf_Addr addr)
+{
+  size_t lo = 0, hi = h->section_addr_cnt, mid;
+  relf_section_entry_struct *e;
+  int is_first = 1;
+  /* find the first section with sh_addr > addr */
+  while( lo < hi )
+  {
+    mid = (lo + hi) / 2;
+    if ( h->section_by_addr[mid]->shdr.sh_addr <= addr )
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  /* sections may overlap (for example .tbss), check all sections which might contain addr */
+  while( lo > 0 )
+  {
+    lo--;
+    e = h->section_by_addr[lo];
+    if ( addr - e->shdr.sh_addr >= h->section_size_max )
+      break;
+    if ( addr - e->shdr.sh_addr < e->shdr.sh_size )
+    {
+      if ( is_first )
+        is_first = 0;
+      else
+        relf_c();
+      relf_show_section_entry(e);
+    }
+  }
+}
+
+/* answer one request, the response is written to relf_out */
+void relf_server_request(const char *line)
+{
+  relf_request_struct *req;
+  relf_handle_struct *h;
+  const char *filename, *query, *arg;
+  size_t start = relf_out->len;      // start of this response in relf_out
+  
+  req = (relf_request_struct *)malloc(sizeof(relf_request_struct));
+  if ( req == NULL )
+  {
+    relf_printf("{\"error\": \"out of memory\"}\n");
+    return;
+  }
+  if ( relf_parse_request(line, req) == 0 )
+  {
+    relf_printf("{\"error\": \"invalid request\"}\n");
+    free(req);
+    return;
+  }
+  filename = relf_request_get(req, "file");
+  query = relf_request_get(req, "query");
+  if ( filename == NULL || query == NULL )
+  {
+    relf_printf("{\"error\": \"file or query missing\"}\n");
+    free(req);
+    return;
+  }
+  h = relf_handle_get(filename);
+  if ( h == NULL )
+  {
+    relf_printf("{\"error\": \"unable to read elf file\"}\n");
+    free(req);
+    return;
+  }
+
+  relf_printf("{");
+  relf_show_escaped_string_value("file", filename);
+  relf_c();
+  relf_show_escaped_string_value("query", query);
+  relf_c();
+  relf_member("result");
+  relf_printf("[");
+  if ( strcmp(query, "symbols_in_section") == 0 && (arg = relf_request_get(req, "section")) != NULL )
+    relf_query_symbols_in_section(h, arg);
+  else if ( strcmp(query, "symbol_by_name") == 0 && (arg = relf_request_get(req, "name")) != NULL )
+    relf_query_symbol_by_name(h, arg);
+  else if ( strcmp(query, "section_by_address") == 0 && (arg = relf_request_get(req, "address")) != NULL )
+    relf_query_section_by_address(h, (GElf_Addr)strtoull(arg, NULL, 0));
+  else
+  {
+    relf_out->len = start;  // discard the partial response, keep previous responses
+    relf_printf("{\"error\": \"unknown query or argument missing\"}\n");
+    free(req);
+    return;
+  }
+  relf_printf("]}\n");
+  free(req);
+}
+
+/* process all complete lines received from the client, returns 0 if the client should be closed */
+int relf_server_client(relf_client_struct *client)
+{
+  relf_buf_struct response;
+  char *line, *nl;
+  ssize_t cnt;
+  size_t done, pos;
+  
+  if ( relf_buf_reserve(&(client->in), 4096) == 0 )
+    return 0;
+  cnt = read(client->fd, client->in.ptr + client->in.len, client->in.max - client->in.len - 1);
+  if ( cnt <= 0 )
+    return 0;
+  client->in.len += cnt;
+  client->in.ptr[client->in.len] = '\0';
+  
+  relf_buf_init(&response);
+  relf_out = &response;
+  line = client->in.ptr;
+  while( (nl = strchr(line, '\n')) != NULL )
+  {
+    *nl = '\0';
+    if ( nl > line && nl[-1] == '\r' )
+      nl[-1] = '\0';
+    if ( *line != '\0' )
+      relf_server_request(line);
+    line = nl+1;
+  }
+  relf_out = NULL;
+  
+  /* keep the incomplete line */
+  done = line - client->in.ptr;
+  memmove(client->in.ptr, line, client->in.len - done + 1);
+  client->in.len -= done;
+  if ( client->in.len > 1024*1024 )
+  {
+    relf_buf_destroy(&response);
+    return 0;   // line too long
+  }
+  
+  for( pos = 0; pos < response.len; pos += cnt )
+  {
+    cnt = write(client->fd, response.ptr + pos, response.len - pos);
+    if ( cnt <= 0 )
+      break;
+  }
+  relf_buf_destroy(&response);
+  return pos >= response.len ? 1 : 0;
+}
+
+int relf_server(const char *socket_path)
+{
+  struct sockaddr_un addr;
+  struct pollfd pfd[RELF_SERVER_CLIENT_MAX+1];
+  relf_client_struct client[RELF_SERVER_CLIENT_MAX];
+  int client_cnt = 0;
+  int server_fd;
+  int fd;
+  int i;
+  
+  if ( strlen(socket_path) >= sizeof(addr.sun_path) )
+    return fprintf(stderr, "socket path too long: %s\n", socket_path), 0;
+  
+  server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if ( server_fd < 0 )
+    return perror("socket"), 0;
+  memset(&addr, 0, sizeof(struct sockaddr_un));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, socket_path);
+  unlink(socket_path);
+  if ( bind(server_fd, (struct sockaddr *)&addr, sizeof(struct sockaddr_un)) != 0 )
+    return perror(socket_path), close(server_fd), 0;
+  if ( listen(server_fd, 16) != 0 )
+    return perror("listen"), close(server_fd), unlink(socket_path), 0;
+  
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, relf_stop_signal);
+  signal(SIGTERM, relf_stop_signal);
+  
+  while( relf_is_stop == 0 )
+  {
+    pfd[0].fd = server_fd;
+    pfd[0].events = POLLIN;
+    for( i = 0; i < client_cnt; i++ )
+    {
+      pfd[i+1].fd = client[i].fd;
+      pfd[i+1].events = POLLIN;
+    }
+    if ( poll(pfd, client_cnt+1, -1) < 0 )
+    {
+      if ( errno == EINTR )
+        continue;
+      perror("poll");
+      break;
+    }
+    
+    /* check clients in reverse order, so that a closed client can be replaced by the last one */
+    for( i = client_cnt-1; i >= 0; i-- )
+    {
+      if ( (pfd[i+1].revents & (POLLIN|POLLHUP|POLLERR)) != 0 )
+      {
+        if ( relf_server_client(client+i) == 0 )
+        {
+          close(client[i].fd);
+          relf_buf_destroy(&(client[i].in));
+          client[i] = client[--client_cnt];
+        }
+      }
+    }
+    
+    if ( (pfd[0].revents & POLLIN) != 0 )
+    {
+      fd = accept(server_fd, NULL, NULL);
+      if ( fd >= 0 )
+      {
+        if ( client_cnt < RELF_SERVER_CLIENT_MAX )
+        {
+          client[client_cnt].fd = fd;
+          relf_buf_init(&(client[client_cnt].in));
+          client_cnt++;
+        }
+        else
+        {
+          close(fd);
+        }
+      }
+    }
+  }
+  
+  for( i = 0; i < client_cnt; i++ )
+  {
+    close(client[i].fd);
+    relf_buf_destroy(&(client[i].in));
+  }
+  for( i = 0; i < RELF_SERVER_HANDLE_MAX; i++ )
+  {
+    relf_handle_destroy(relf_handle_list[i]);
+    relf_handle_list[i] = NULL;
+  }
+  close(server_fd);
+  unlink(socket_path);
+  return 1;
+}
+
+#else
+
+int relf_server(const char *socket_path)
+{
+  fprintf(stderr, "Query server is not supported on this system\n");
+  return 0;
+}
+
+#endif
+
+
+/*==========================================*/
+/* Complete Output */
+
+/* hash over all strings of the dictionary, the fragments depend on the index of the strings */
+unsigned long long relf_strdict_get_hash(relf_strdict_struct *strdict)
+{
+  unsigned long long h = 0;
+  size_t i;
+  for( i = 0; i < strdict->cnt; i++ )
+    h = relf_hash64(h, strdict->list[i], strlen(strdict->list[i])+1);
+  return h;
+}
+
+/*
+  Write the JSON output for the elf file.
+  If next is not NULL, then the fragments of the section_list are stored in next
+  and fragments from prev are reused (see relf_show_section_list_fragments()).
+*/
+int relf_show(relf_struct *relf, int is_string_dictionary, relf_fragment_list_struct *prev, relf_fragment_list_struct *next)
+{
+  relf_strdict_struct strdict;
+  relf_pool_struct pool;
+  unsigned long long extra_hash = 0;
+  
+  relf_oo();
+  if ( is_string_dictionary )
+  {
+    if ( relf_strdict_init(&strdict) == 0 )
+      return 0;
+    if ( relf_add_names_to_strdict(relf, &strdict) == 0 )
+      return relf_strdict_destroy(&strdict), 0;
+    relf_show_string_list(&strdict);
+    relf_cn();
+    relf_string_dictionary = &strdict;
+    extra_hash = relf_strdict_get_hash(&strdict);
+  }
+  relf_show_elf_header(relf);
+  relf_cn();
+  
+  relf_show_program_header_list(relf);
+  relf_cn();
+  
+  relf_show_segment_section_map(relf);
+  relf_cn();
+  
+  if ( relf_thread_cnt > 1 && relf_prepare_parallel(relf) != 0 )
+  {
+    relf_pool_init(&pool, relf_thread_cnt-1);     // the main thread will also execute tasks
+    relf_pool = &pool;
+  }
+  if ( next != NULL )
+    relf_show_section_list_fragments(relf, extra_hash, prev, next);
+  else if ( relf_pool != NULL )
+    relf_show_section_list_parallel(relf, relf_pool);
+  else
+    relf_show_section_list(relf);
+  if ( relf_pool != NULL )
+  {
+    relf_pool = NULL;
+    relf_pool_destroy(&pool);
+  }
+  relf_cn();
+
+  relf_show_section_addr_list(relf);
+  if ( relf->is_scn_skipped_list != NULL )
+  {
+    relf_cn();
+    relf_show_skipped_section_list(relf);
+  }
+  relf_n();
+
+  relf_co();
+  relf_n();
+  
+  if ( relf_string_dictionary != NULL )
+  {
+    relf_string_dictionary = NULL;
+    relf_strdict_destroy(&strdict);
+  }
+  return 1;
+}
+
+
+/*==========================================*/
+/* Watch Mode */
+/*
+  elf2json -w [-o <output.json>] <input.elf>
+  
+  Write the JSON output and wait for changes of the input file (inotify).
+  After each change, the output is written again. Only sections with 
+  changed content are rendered again, all other entries of the 
+  section_list are reused from the previous output.
+  If there is no output file, the JSON output is written to stdout after each change.
+*/
+
+#if defined(__linux__)
+
+#include <sys/inotify.h>
+#include <libgen.h>
+
+/* write the buffer to the output file, the file is replaced atomically */
+int relf_write_output_file(const char *out_filename, relf_buf_struct *buf)
+{
+  char *tmp_filename;
+  FILE *fp;
+  size_t cnt;
+  
+  if ( out_filename == NULL )
+  {
+    cnt = fwrite(buf->ptr, 1, buf->len, stdout);
+    fflush(stdout);
+    return cnt == buf->len;
+  }
+  tmp_filename = (char *)malloc(strlen(out_filename)+5);
+  if ( tmp_filename == NULL )
+    return 0;
+  strcpy(tmp_filename, out_filename);
+  strcat(tmp_filename, ".tmp");
+  fp = fopen(tmp_filename, "wb");
+  if ( fp == NULL )
+    return perror(tmp_filename), free(tmp_filename), 0;
+  cnt = fwrite(buf->ptr, 1, buf->len, fp);
+  if ( fclose(fp) != 0 || cnt != buf->len || rename(tmp_filename, out_filename) != 0 )
+  {
+    perror(out_filename);
+    unlink(tmp_filename);
+    free(tmp_filename);
+    return 0;
+  }
+  free(tmp_filename);
+  return 1;
+}
+
+/* render the elf file, returns 0 if the elf file can not be read */
+int relf_watch_render(const char *elf_filename, const char *out_filename, int is_string_dictionary, relf_fragment_list_struct *prev, relf_fragment_list_struct *next)
+{
+  relf_struct relf;
+  relf_buf_struct out;
+  
+  relf_fragment_list_init(next);
+  if ( relf_init(&relf, elf_filename) == 0 )
+    return 0;
+  relf_buf_init(&out);
+  relf_out = &out;
+  relf_show(&relf, is_string_dictionary, prev, next);
+  relf_out = NULL;
+  relf_destroy(&relf);
+  relf_write_output_file(out_filename, &out);
+  relf_buf_destroy(&out);
+  fprintf(stderr, "%s: %zu of %zu sections rendered\n", elf_filename, next->cnt - next->reuse_cnt - next->cache_cnt, next->cnt);
+  return 1;
+}
+
+int relf_watch(const char *elf_filename, const char *out_filename, int is_string_dictionary)
+{
+  relf_fragment_list_struct fragments[2];
+  int current = 0;
+  char *dir_copy, *base_copy;
+  char *dir_name, *base_name;
+  char event_buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  const struct inotify_event *event;
+  struct pollfd pfd;
+  int is_changed;
+  ssize_t len;
+  char *p;
+  int fd;
+  
+  /* watch the directory, because the linker might replace the file */
+  dir_copy = strdup(elf_filename);
+  base_copy = strdup(elf_filename);
+  if ( dir_copy == NULL || base_copy == NULL )
+    return free(dir_copy), free(base_copy), 0;
+  dir_name = dirname(dir_copy);
+  base_name = basename(base_copy);
+  
+  fd = inotify_init();
+  if ( fd < 0 )
+    return perror("inotify_init"), free(dir_copy), free(base_copy), 0;
+  if ( inotify_add_watch(fd, dir_name, IN_CLOSE_WRITE | IN_MOVED_TO) < 0 )
+    return perror(dir_name), close(fd), free(dir_copy), free(base_copy), 0;
+  
+  signal(SIGINT, relf_stop_signal);
+  signal(SIGTERM, relf_stop_signal);
+  
+  relf_fragment_list_init(fragments+0);
+  relf_fragment_list_init(fragments+1);
+  relf_watch_render(elf_filename, out_filename, is_string_dictionary, NULL, fragments+current);
+  
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  while( relf_is_stop == 0 )
+  {
+    /* wait for a change of the elf file, then wait until there are no more events for 100ms */
+    is_changed = 0;
+    for(;;)
+    {
+      if ( poll(&pfd, 1, is_changed ? 100 : -1) <= 0 )
+        break;          // timeout or signal
+      len = read(fd, event_buf, sizeof(event_buf));
+      if ( len <= 0 )
+        break;
+      for( p = event_buf; p < event_buf + len; p += sizeof(struct inotify_event) + event->len )
+      {
+        event = (const struct inotify_event *)p;
+        if ( event->len > 0 && strcmp(event->name, base_name) == 0 )
+          is_changed = 1;
+      }
+    }
+    if ( is_changed && relf_is_stop == 0 )
+    {
+      if ( relf_watch_render(elf_filename, out_filename, is_string_dictionary, fragments+current, fragments+1-current) != 0 )
+      {
+        relf_fragment_list_destroy(fragments+current);
+        current = 1-current;
+      }
+    }
+  }
+  
+  relf_fragment_list_destroy(fragments+0);
+  relf_fragment_list_destroy(fragments+1);
+  close(fd);
+  free(dir_copy);
+  free(base_copy);
+  return 1;
+}
+
+#else
+
+int relf_watch(const char *elf_filename, const char *out_filename, int is_string_dictionary)
+{
+  fprintf(stderr, "Watch mode is not supported on this system\n");
+  return 0;
+}
+
+#endif
+
+/*==========================================*/
+/* Size Report */
+
+/*
+  Option "-s": Attribute the bytes of each SHF_ALLOC section to the symbols of the section.
+  
+  All symbols are sorted once by section index and address. For each section a sweep
+  over the sorted symbol intervals assigns each byte to the first symbol which covers it,
+  so aliases and overlapping symbols are not counted twice. Bytes which are not covered by 
+  any symbol are padding, if they follow a symbol and only fill up to the alignment of the 
+  following address (gap size is less than the lowest set bit of the end address), otherwise 
+  the bytes are reported in the unknown_list of the section.
+  
+  If ".debug_aranges" is available, the symbol sizes are also summed up by compile unit.
+  The name of the compile unit is DW_AT_name of the compile unit DIE, read with libdwarf (relfdwarf.c).
+  
+  All lists are sorted by name, so that the reports of two versions of a binary can be compared with diff.
+  The overall complexity is O(n log n) for n symbols.
+*/
+
+struct _relf_size_symbol_struct
+{
+  unsigned long long addr;              // start address, section offset for ET_REL
+  unsigned long long size;              // st_size
+  unsigned long long attributed_size;   // bytes, which are assigned to this symbol by the sweep
+  size_t section_index;
+  const char *name;
+  int bind_rank;                        // global symbols win over weak and local symbols at the same address
+};
+typedef struct _relf_size_symbol_struct relf_size_symbol_struct;
+
+struct _relf_size_gap_struct
+{
+  unsigned long long addr;
+  unsigned long long size;
+};
+typedef struct _relf_size_gap_struct relf_size_gap_struct;
+
+/* sum of the attributed symbol sizes for a compile unit */
+struct _relf_size_cu_struct
+{
+  const char *cu_name;
+  unsigned long long size;
+};
+typedef struct _relf_size_cu_struct relf_size_cu_struct;
+
+int relf_cmp_size_symbol_by_addr(const void *a, const void *b)
+{
+  const relf_size_symbol_struct *x = (const relf_size_symbol_struct *)a;
+  const relf_size_symbol_struct *y = (const relf_size_symbol_struct *)b;
+  if ( x->section_index != y->section_index )
+    return x->section_index < y->section_index ? -1 : 1;
+  if ( x->addr != y->addr )
+    return x->addr < y->addr ? -1 : 1;
+  if ( x->size != y->size )
+    return x->size > y->size ? -1 : 1;          // larger symbol first
+  if ( x->bind_rank != y->bind_rank )
+    return x->bind_rank - y->bind_rank;
+  return strcmp(x->name, y->name);
+}
+
+int relf_cmp_size_symbol_by_name(const void *a, const void *b)
+{
+  const relf_size_symbol_struct *x = (const relf_size_symbol_struct *)a;
+  const relf_size_symbol_struct *y = (const relf_size_symbol_struct *)b;
+  int c = strcmp(x->name, y->name);
+  if ( c != 0 )
+    return c;
+  if ( x->addr != y->addr )
+    return x->addr < y->addr ? -1 : 1;
+  return 0;
+}
+
+int relf_cmp_size_cu(const void *a, const void *b)
+{
+  return strcmp(((const relf_size_cu_struct *)a)->cu_name, ((const relf_size_cu_struct *)b)->cu_name);
+}
+
+/* 
+  get all symbols with a size, which belong to a section, from ".symtab" (or ".dynsym" if there is no ".symtab") 
+  returns a malloc'd list sorted by relf_cmp_size_symbol_by_addr() or NULL
+*/
+relf_size_symbol_struct *relf_get_size_symbol_list(relf_struct *relf, size_t *cnt)
+{
+  size_t section_index = relf->symtab_section_index != 0 ? relf->symtab_section_index : relf->dynsym_section_index;
+  size_t sym_size = gelf_fsize(relf->elf, ELF_T_SYM, 1, EV_CURRENT);
+  unsigned long long tls_addr = 0;
+  relf_size_symbol_struct *list;
+  Elf_Scn *scn;
+  Elf_Data *data;
+  GElf_Shdr shdr;
+  GElf_Phdr phdr;
+  GElf_Sym sym;
+  relf_records_struct records;
+  const char *name;
+  size_t i, total;
+  
+  *cnt = 0;
+  if ( section_index == 0 || sym_size == 0 )
+    return NULL;
+  scn = elf_getscn(relf->elf, section_index);
+  if ( scn == NULL || gelf_getshdr(scn, &shdr) != &shdr )
+    return NULL;
+  if ( relf_init_scn_records(relf, &records, scn, &shdr) )
+  {
+    total = records.cnt;
+  }
+  else
+  {
+    if ( relf_is_scn_data_allowed(relf, scn) == 0 || (data = elf_getdata(scn, NULL)) == NULL )
+      return NULL;
+    relf_init_records(relf, &records, scn, data);
+    total = data->d_size / sym_size;
+  }
+  
+  /* STT_TLS symbols of executables and shared objects are relative to the PT_TLS segment */
+  for( i = 0; i < relf->program_header_total; i++ )
+    if ( gelf_getphdr(relf->elf, i, &phdr) != NULL && phdr.p_type == PT_TLS )
+      tls_addr = phdr.p_vaddr;
+  
+  list = (relf_size_symbol_struct *)malloc((total > 0 ? total : 1) * sizeof(relf_size_symbol_struct));
+  if ( list == NULL )
+    return relf_destroy_records(&records), fprintf(stderr, "relf_get_size_symbol_list: out of memory\n"), NULL;
+  for( i = 0; i < total; i++ )
+  {
+    if ( relf_get_sym(&records, i, &sym) == NULL )
+      break;
+    if ( sym.st_size == 0 || sym.st_shndx == SHN_UNDEF || sym.st_shndx >= SHN_LORESERVE )
+      continue;
+    if ( GELF_ST_TYPE(sym.st_info) == STT_SECTION || GELF_ST_TYPE(sym.st_info) == STT_FILE )
+      continue;
+    name = elf_strptr(relf->elf, shdr.sh_link, sym.st_name);
+    list[*cnt].addr = sym.st_value;
+    if ( GELF_ST_TYPE(sym.st_info) == STT_TLS && relf->elf_file_header.e_type != ET_REL )
+      list[*cnt].addr += tls_addr;
+    list[*cnt].size = sym.st_size;
+    list[*cnt].attributed_size = 0;
+    list[*cnt].section_index = sym.st_shndx;
+    list[*cnt].name = name != NULL ? name : "";
+    list[*cnt].bind_rank = GELF_ST_BIND(sym.st_info) == STB_GLOBAL ? 0 : (GELF_ST_BIND(sym.st_info) == STB_WEAK ? 1 : 2);
+    (*cnt)++;
+  }
+  relf_destroy_records(&records);
+  qsort(list, *cnt, sizeof(relf_size_symbol_struct), relf_cmp_size_symbol_by_addr);
+  return list;
+}
+
+/* sections are written in the order of their names */
+int relf_cmp_size_section(const void *a, const void *b)
+{
+  const relf_size_symbol_struct *x = (const relf_size_symbol_struct *)a;
+  const relf_size_symbol_struct *y = (const relf_size_symbol_struct *)b;
+  int c = strcmp(x->name, y->name);
+  if ( c != 0 )
+    return c;
+  return x->section_index < y->section_index ? -1 : (x->section_index > y->section_index ? 1 : 0);
+}
+
+/* 
+  Sweep over the symbols [first, last) of one section, which are sorted by address.
+  The unknown gaps are stored in gap_list (which must have space for last-first+1 entries).
+*/
+void relf_size_sweep(relf_size_symbol_struct *list, size_t first, size_t last, unsigned long long start, unsigned long long end,
+  relf_size_gap_struct *gap_list, size_t *gap_cnt, unsigned long long *padding_size)
+{
+  unsigned long long pos = start;
+  unsigned long long sym_start, sym_end, gap_end;
+  size_t i;
+  
+  *gap_cnt = 0;
+  *padding_size = 0;
+  for( i = first; i <= last; i++ )
+  {
+    /* the section end is handled like a symbol at the end of the section */
+    gap_end = i < last ? list[i].addr : end;
+    if ( gap_end > end )
+      gap_end = end;
+    if ( gap_end > pos )
+    {
+      if ( pos != start && (gap_end - pos < (gap_end & (~gap_end + 1)) || gap_end == 0) )
+      {
+        *padding_size += gap_end - pos;
+      }
+      else
+      {
+        gap_list[*gap_cnt].addr = pos;
+        gap_list[*gap_cnt].size = gap_end - pos;
+        (*gap_cnt)++;
+      }
+      pos = gap_end;
+    }
+    if ( i == last )
+      break;
+    sym_start = list[i].addr > pos ? list[i].addr : pos;
+    sym_end = list[i].addr + list[i].size;
+    if ( sym_end > end )
+      sym_end = end;
+    if ( sym_end > sym_start )
+    {
+      list[i].attributed_size = sym_end - sym_start;
+      pos = sym_end;
+    }
+  }
+}
+
+int relf_show_size_report(relf_struct *relf)
+{
+  relf_size_symbol_struct *symbol_list;
+  relf_size_symbol_struct *section_list;        // only name and section_index are used
+  relf_size_gap_struct *gap_list;
+  relf_arange_struct *arange_list;
+  relf_size_cu_struct *cu_list;
+  size_t *first_list;           // index of the first symbol for each section
+  size_t symbol_cnt = 0, section_cnt = 0, arange_cnt = 0, cu_cnt = 0, gap_cnt;
+  size_t i, j, k, section_index;
+  unsigned long long start, symbol_size, padding_size, unknown_size;
+  Elf_Scn *scn = NULL;
+  GElf_Shdr shdr;
+  const char *name;
+  int is_first;
+  int indent = 1;
+  
+  symbol_list = relf_get_size_symbol_list(relf, &symbol_cnt);
+  section_list = (relf_size_symbol_struct *)malloc((relf->section_header_total+1) * sizeof(relf_size_symbol_struct));
+  first_list = (size_t *)malloc((relf->section_header_total+2) * sizeof(size_t));
+  gap_list = (relf_size_gap_struct *)malloc((symbol_cnt+1) * sizeof(relf_size_gap_struct));
+  cu_list = (relf_size_cu_struct *)malloc((symbol_cnt+1) * sizeof(relf_size_cu_struct));
+  if ( section_list == NULL || first_list == NULL || gap_list == NULL || cu_list == NULL )
+  {
+    free(symbol_list); free(section_list); free(first_list); free(gap_list); free(cu_list);
+    return fprintf(stderr, "relf_show_size_report: out of memory\n"), 0;
+  }
+  
+  /* symbols of section i are symbol_list[first_list[i]] ... symbol_list[first_list[i+1]-1] */
+  j = 0;
+  for( i = 0; i <= relf->section_header_total; i++ )
+  {
+    while( j < symbol_cnt && symbol_list[j].section_index < i )
+      j++;
+    first_list[i] = j;
+  }
+  first_list[relf->section_header_total+1] = symbol_cnt;
+  
+  /* allocated sections, sorted by name */
+  while( (scn = elf_nextscn(relf->elf, scn)) != NULL )
+  {
+    if ( gelf_getshdr(scn, &shdr) != &shdr )
+      break;
+    if ( (shdr.sh_flags & SHF_ALLOC) == 0 || shdr.sh_size == 0 )
+      continue;
+    name = elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name);
+    section_list[section_cnt].name = name != NULL ? name : "";
+    section_list[section_cnt].section_index = elf_ndxscn(scn);
+    section_cnt++;
+  }
+  qsort(section_list, section_cnt, sizeof(relf_size_symbol_struct), relf_cmp_size_section);
+  
+  relf_oo();
+  relf_indent(indent);
+  relf_member("section_size_list");
+  relf_n();
+  relf_indent(indent);
+  relf_oa();
+  for( i = 0; i < section_cnt; i++ )
+  {
+    section_index = section_list[i].section_index;
+    scn = elf_getscn(relf->elf, section_index);
+    if ( scn == NULL || gelf_getshdr(scn, &shdr) != &shdr )
+      continue;
+    start = relf->elf_file_header.e_type == ET_REL ? 0 : shdr.sh_addr;
+    relf_size_sweep(symbol_list, first_list[section_index], first_list[section_index+1], start, start + shdr.sh_size, gap_list, &gap_cnt, &padding_size);
+    symbol_size = 0;
+    for( j = first_list[section_index]; j < first_list[section_index+1]; j++ )
+      symbol_size += symbol_list[j].attributed_size;
+    unknown_size = shdr.sh_size - symbol_size - padding_size;
+    if ( first_list[section_index+1] > first_list[section_index] )
+      qsort(symbol_list + first_list[section_index], first_list[section_index+1] - first_list[section_index], sizeof(relf_size_symbol_struct), relf_cmp_size_symbol_by_name);
+    
+    if ( i > 0 )
+      relf_cn();
+    relf_indent(indent+1);
+    relf_oo();
+    relf_indent(indent+2);
+    relf_show_pure_value("section_index", section_index);
+    relf_cn();
+    relf_indent(indent+2);
+    relf_show_raw_string_value("sh_name", (const unsigned char *)section_list[i].name, strlen(section_list[i].name));
+    relf_cn();
+    relf_indent(indent+2);
+    relf_show_pure_value("sh_addr", shdr.sh_addr);
+    relf_cn();
+    relf_indent(indent+2);
+    relf_show_pure_value("sh_size", shdr.sh_size);
+    relf_cn();
+    relf_indent(indent+2);
+    relf_show_pure_value("symbol_size", symbol_size);
+    relf_cn();
+    relf_indent(indent+2);
+    relf_show_pure_value("padding_size", padding_size);
+    relf_cn();
+    relf_indent(indent+2);
+    relf_show_pure_value("unknown_size", unknown_size);
+    relf_cn();
+    
+    /* one line for each symbol and gap, so that reports can be compared with diff */
+    relf_indent(indent+2);
+    relf_member("symbol_list");
+    relf_n();
+    relf_indent(indent+2);
+    relf_oa();
+    is_first = 1;
+    for( j = first_list[section_index]; j < first_list[section_index+1]; j++ )
+    {
+      if ( symbol_list[j].attributed_size == 0 )
+        continue;
+      if ( is_first )
+        is_first = 0;
+      else
+        relf_cn();
+      relf_indent(indent+3);
+      relf_printf("{");
+      relf_show_raw_string_value("st_name", (const unsigned char *)symbol_list[j].name, strlen(symbol_list[j].name));
+      relf_printf(", ");
+      relf_show_pure_value("st_value", symbol_list[j].addr);
+      relf_printf(", ");
+      relf_show_pure_value("size", symbol_list[j].attributed_size);
+      relf_printf("}");
+    }
+    relf_n();
+    relf_indent(indent+2);
+    relf_ca();
+    relf_cn();
+    
+    relf_indent(indent+2);
+    relf_member("unknown_list");
+    relf_n();
+    relf_indent(indent+2);
+    relf_oa();
+    for( j = 0; j < gap_cnt; j++ )
+    {
+      if ( j > 0 )
+        relf_cn();
+      relf_indent(indent+3);
+      relf_printf("{");
+      relf_show_pure_value("addr", gap_list[j].addr);
+      relf_printf(", ");
+      relf_show_pure_value("size", gap_list[j].size);
+      relf_printf("}");
+    }
+    relf_n();
+    relf_indent(indent+2);
+    relf_ca();
+    relf_n();
+    relf_indent(indent+1);
+    relf_co();
+  }
+  relf_n();
+  relf_indent(indent);
+  relf_ca();
+  
+  /* compile units: addresses in relocatable files are not final, so there is no mapping to compile units */
+  if ( relf->elf_file_header.e_type != ET_REL )
+    arange_list = relf_get_arange_list(relf, &arange_cnt);
+  else
+    arange_list = NULL;
+  if ( arange_list != NULL )
+  {
+    for( i = 0; i < symbol_cnt; i++ )
+    {
+      if ( symbol_list[i].attributed_size == 0 )
+        continue;
+      cu_list[cu_cnt].cu_name = relf_find_cu_name(arange_list, arange_cnt, symbol_list[i].addr);
+      cu_list[cu_cnt].size = symbol_list[i].attributed_size;
+      cu_cnt++;
+    }
+    qsort(cu_list, cu_cnt, sizeof(relf_size_cu_struct), relf_cmp_size_cu);
+    /* merge entries with the same name */
+    for( i = 0, k = 0; i < cu_cnt; i++ )
+    {
+      if ( k > 0 && strcmp(cu_list[k-1].cu_name, cu_list[i].cu_name) == 0 )
+        cu_list[k-1].size += cu_list[i].size;
+      else
+        cu_list[k++] = cu_list[i];
+    }
+    cu_cnt = k;
+    
+    relf_cn();
+    relf_indent(indent);
+    relf_member("compile_unit_size_list");
+    relf_n();
+    relf_indent(indent);
+    relf_oa();
+    for( i = 0; i < cu_cnt; i++ )
+    {
+      if ( i > 0 )
+        relf_cn();
+      relf_indent(indent+1);
+      relf_printf("{");
+      relf_show_raw_string_value("cu_name", (const unsigned char *)cu_list[i].cu_name, strlen(cu_list[i].cu_name));
+      relf_printf(", ");
+      relf_show_pure_value("size", cu_list[i].size);
+      relf_printf("}");
+    }
+    relf_n();
+    relf_indent(indent);
+    relf_ca();
+  }
+  relf_n();
+  relf_co();
+  relf_n();
+  
+  free(arange_list);
+  free(symbol_list);
+  free(section_list);
+  free(first_list);
+  free(gap_list);
+  free(cu_list);
+  return 1;
+}
+
+/*==========================================*/
+/* Build-ID List */
+
+/*
+  Option "-b": Write one line with the build-id for each elf file. 
+  The build-id is read by relf_get_build_id(), which only reads the headers and the notes,
+  so this is much faster than the complete JSON output.
+  Each line is a JSON object: {"file": "<elf file>", "build_id": "<hex>"}
+  build_id is an empty string, if the elf file doesn't have a build-id.
+*/
+int relf_show_build_id_list(int cnt, char **filename_list)
+{
+  unsigned char build_id[RELF_BUILD_ID_MAX];
+  size_t len;
+  int fd;
+  int i;
+  int result = 1;
+  
+  for( i = 0; i < cnt; i++ )
+  {
+    fd = open( filename_list[i], O_RDONLY | O_BINARY , 0);
+    if ( fd < 0 )
+    {
+      perror(filename_list[i]);
+      result = 0;
+      continue;
+    }
+    len = relf_get_build_id(fd, build_id, RELF_BUILD_ID_MAX);
+    close(fd);
+    relf_printf("{");
+    relf_show_raw_string_value("file", (const unsigned char *)filename_list[i], strlen(filename_list[i]));
+    relf_printf(", ");
+    relf_show_hex_value("build_id", build_id, len);
+    relf_printf("}");
+    relf_n();
+  }
+  return result;
+}
+
+
+int default_return_value = 123;
+
+/* convert a size with optional suffix "K", "M" or "G" into bytes, for example "64M" */
+size_t relf_get_size_arg(const char *arg)
+{
+  char *end;
+  size_t size = (size_t)strtoull(arg, &end, 10);
+  switch(*end)
+  {
+    case 'g': case 'G': size *= 1024; /* fall through */
+    case 'm': case 'M': size *= 1024; /* fall through */
+    case 'k': case 'K': size *= 1024; break;
+  }
+  return size;
+}
+
+/*
+  elf2json [-d] [-j <n>] [-c <dir>] [-m <size>] [-o <output.json>] <input.elf>
+    -d    write names only once to "string_list" and use the index into "string_list" instead of the name
+    -j    use <n> threads to render the section_list
+    -c    use <dir> as cache for the entries of the section_list
+    -m    keep at most <size> bytes of section data in memory (for example "256M"), records are read in windows,
+          sections which can not be read in windows are listed in "skipped_section_list"
+          "--max-memory <size>" is the same as "-m <size>"
+    -o    write the JSON output to a file instead of stdout
+  elf2json -w [-d] [-j <n>] [-c <dir>] [-m <size>] [-o <output.json>] <input.elf>
+    -w    watch mode, write the output again after each change of the input file (see relf_watch())
+          "--watch" is the same as "-w", only one input file can be watched
+  elf2json -s [-m <size>] [-o <output.json>] <input.elf>
+    -s    write the size report instead of the elf content (see relf_show_size_report())
+  elf2json -S <socket>
+    -S    start the query server on the unix socket (see relf_server())
+  elf2json -b <input.elf> ...
+    -b    write the build-id of all following elf files (see relf_show_build_id_list())
+*/
+int main( int argc , char ** argv )
+{
+  relf_struct relf;
+  const char *elf_filename = NULL;
+  const char *out_filename = NULL;
+  int is_string_dictionary = 0;
+  int is_watch = 0;
+  int is_size_report = 0;
+  int elf_file_cnt = 0;
+  int i;
+  
+  for( i = 1; i < argc; i++ )
+  {
+    if ( strcmp(argv[i], "-d") == 0 )
+      is_string_dictionary = 1;
+    else if ( strcmp(argv[i], "-j") == 0 && i+1 < argc )
+      relf_thread_cnt = atoi(argv[++i]);
+    else if ( strcmp(argv[i], "-o") == 0 && i+1 < argc )
+      out_filename = argv[++i];
+    else if ( strcmp(argv[i], "-c") == 0 && i+1 < argc )
+      relf_cache_dir = argv[++i];
+    else if ( (strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "--max-memory") == 0) && i+1 < argc )
+      relf_max_memory = relf_get_size_arg(argv[++i]);
+    else if ( strcmp(argv[i], "-w") == 0 || strcmp(argv[i], "--watch") == 0 )
+      is_watch = 1;
+    else if ( strcmp(argv[i], "-s") == 0 )
+      is_size_report = 1;
+    else if ( strcmp(argv[i], "-S") == 0 && i+1 < argc )
+      return relf_server(argv[++i]) ? 0 : 1;
+    else if ( strcmp(argv[i], "-b") == 0 )
+      return relf_show_build_id_list(argc-i-1, argv+i+1) ? 0 : 1;
+    else if ( argv[i][0] == '-' && argv[i][1] != '\0' )
+      return fprintf(stderr, "elf2json: unknown option '%s'\n", argv[i]), 1;
+    else
+    {
+      elf_filename = argv[i];
+      elf_file_cnt++;
+    }
+  }
+  
+  if ( elf_filename == NULL )
+    return 0;
+  
+  if ( is_watch )
+  {
+    if ( elf_file_cnt > 1 )
+      return fprintf(stderr, "elf2json: watch mode accepts only one input file\n"), 1;
+    return relf_watch(elf_filename, out_filename, is_string_dictionary) ? 0 : 1;
+  }
+  
+  if ( out_filename != NULL && freopen(out_filename, "w", stdout) == NULL )
+    return perror(out_filename), 0;
+  
+  if ( relf_init(&relf, elf_filename) == 0 )
+    return 0;
+  if ( is_size_report )
+  {
+    if ( relf_show_size_report(&relf) == 0 )
+      return relf_destroy(&relf), 0;
+  }
+  else if ( relf_cache_dir != NULL )
+  {
+    /* use the fragments for the cache */
+    relf_fragment_list_struct fragments;
+    if ( relf_show(&relf, is_string_dictionary, NULL, &fragments) == 0 )
+      return relf_destroy(&relf), 0;
+    relf_fragment_list_destroy(&fragments);
+  }
+  else
+  {
+    if ( relf_show(&relf, is_string_dictionary, NULL, NULL) == 0 )
+      return relf_destroy(&relf), 0;
+  }
   relf_destroy(&relf);
   
   return default_return_value;
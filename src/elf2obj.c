@@ -18,17 +18,20 @@
   You should have received a copy of the GNU General Public License
   along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
-  List objects from the symbol table
+  List objects from the symbol table, sorted by address
   
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <libelf.h>
 #include <gelf.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#include "relf.h"
 
 /*
         {
@@ -87,172 +90,602 @@ void __attribute__ ((noreturn)) __stack_chk_fail (void)
 
 
 /*==========================================*/
+/* Configuration */
 
+#define ELF2OBJ_FORMAT_TEXT 0
+#define ELF2OBJ_FORMAT_JSON 1
+#define ELF2OBJ_FORMAT_CSV 2
+
+int elf2obj_format = ELF2OBJ_FORMAT_TEXT;      // option "-f"
+int elf2obj_is_icf = 0;                         // 1: list groups of identical functions instead of all objects (option "-i")
+int elf2obj_thread_cnt = 4;                     // number of threads, which calculate the hash values (option "-j")
+
+/*==========================================*/
+/* Section Table */
 
 /* 
-  returns a pointer to a memory location of y symbol 
-  if NULL is returned, then there is either an error or the destination memory doesn't exist (BSS area).  
+  sections, resolved once, so that the objects don't need elf_getscn() 
+  the section data is loaded by elf2obj_get_object_ptr() when it is required for the first time, 
+  so that libelf does not read debug information or string tables
 */
-void *get_symbol_mem_ptr(Elf *elf, GElf_Sym *symbol)
+struct _elf2obj_section_struct
 {
-  GElf_Shdr shdr;
   Elf_Scn *scn;
-  Elf_Data *data = NULL;
-  size_t block_addr = 0;
-  
-  size_t section_index = symbol->st_shndx;
-  size_t addr = symbol->st_value;
-  
-  if ( section_index == 0 || section_index > 0x0fff0 )
-    return NULL;
+  GElf_Shdr shdr;
+  const char *name;
+  Elf_Data *data;               // first data block, NULL if there is no content (for example SHT_NOBITS) or if not yet loaded
+  int is_data_loaded;           // 1 if data has been requested from libelf
+};
+typedef struct _elf2obj_section_struct elf2obj_section_struct;
+
+/* returns a malloc'd table, indexed by the section index, or NULL */
+elf2obj_section_struct *elf2obj_get_section_table(Elf *elf, size_t *cnt)
+{
+  elf2obj_section_struct *table;
+  elf2obj_section_struct *sec;
+  Elf_Scn *scn = NULL;
+  size_t shstrndx, index;
   
-  scn = elf_getscn(elf,  section_index);  
-  if ( scn == NULL )
-    return fprintf(stderr, "libelf: %s, section_index=%llu \n", elf_errmsg(-1), (long long unsigned)section_index), NULL;
-  if ( gelf_getshdr( scn, &shdr ) != &shdr )
+  if ( elf_getshdrnum(elf, cnt) != 0 )
     return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
+  if ( elf_getshdrstrndx(elf, &shstrndx) != 0 )
+    return fprintf(stderr, "Sectionheader string table not found libelf: %s\n", elf_errmsg(-1)), NULL;
+  table = (elf2obj_section_struct *)calloc(*cnt + 1, sizeof(elf2obj_section_struct));
+  if ( table == NULL )
+    return fprintf(stderr, "elf2obj: out of memory\n"), NULL;
+  while (( scn = elf_nextscn(elf, scn)) != NULL ) 
+  {
+    index = elf_ndxscn(scn);
+    if ( index >= *cnt )
+      continue;
+    sec = table + index;
+    if ( gelf_getshdr( scn, &(sec->shdr) ) != &(sec->shdr) )
+      return free(table), fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
+    sec->scn = scn;
+    sec->name = elf_strptr(elf, shstrndx, sec->shdr.sh_name);
+    if ( sec->name == NULL )
+      sec->name = "";
+  }
+  return table;
+}
 
-  /*
-    shdr.sh_addr                contains the base address for the target memory
-    shdr.sh_size                 contains the size of the section
-  */
+/* 
+  returns a pointer to the content of an object inside a section
+  if NULL is returned, then the content doesn't exist (BSS area)
+  not thread safe: the section data is loaded with the first call for a section
+*/
+const unsigned char *elf2obj_get_object_ptr(elf2obj_section_struct *sec, unsigned long long addr, unsigned long long size)
+{
+  Elf_Data *data;
+  unsigned long long block_addr;
   
-  if ( shdr.sh_size == 0 )
+  if ( sec->is_data_loaded == 0 )
+  {
+    sec->is_data_loaded = 1;
+    if ( sec->shdr.sh_type != SHT_NOBITS && sec->shdr.sh_size > 0 )
+    {
+      sec->data = elf_getdata(sec->scn, NULL);
+      if ( sec->data != NULL && sec->data->d_buf == NULL )
+        sec->data = NULL;
+    }
+  }
+  data = sec->data;
+  while( data != NULL && data->d_buf != NULL )
   {
-    // fprintf(stderr, "get_symbol_mem_ptr: shdr.sh_size == 0\n");
-    return NULL;
+    block_addr = sec->shdr.sh_addr + data->d_off;
+    if ( addr >= block_addr && addr + size <= block_addr + data->d_size )
+      return (const unsigned char *)data->d_buf + (addr - block_addr);
+    data = elf_getdata(sec->scn, data);       // a section has usually only one data block
   }
+  return NULL;
+}
+
+/*==========================================*/
+/* Object List */
+
+struct _elf2obj_object_struct
+{
+  const char *name;
+  const char *section_name;
+  unsigned long long addr;
+  unsigned long long size;
+  unsigned long long offset;    // file offset of the content, only valid if is_content is not 0
+  unsigned long long hash;      // relf_hash64() of the content, only valid if is_content is not 0
+  const unsigned char *ptr;     // content, owned by libelf, NULL if there is no content (BSS area)
+  size_t section_index;         // st_shndx of the symbol
+  int type;                     // STT_FUNC or STT_OBJECT
+  int is_content;
+};
+typedef struct _elf2obj_object_struct elf2obj_object_struct;
+
+int elf2obj_cmp_object(const void *a, const void *b)
+{
+  const elf2obj_object_struct *x = (const elf2obj_object_struct *)a;
+  const elf2obj_object_struct *y = (const elf2obj_object_struct *)b;
+  if ( x->addr != y->addr )
+    return x->addr < y->addr ? -1 : 1;
+  return strcmp(x->name, y->name);
+}
+
+/*
+  Collect all global functions and objects with address and size from the symbol tables,
+  sorted by address. With elf2obj_is_icf, weak and local functions are also collected and 
+  functions of relocatable files may start at address 0 of their section.
+  Returns a malloc'd list or NULL, *cnt is the number of objects.
+*/
+elf2obj_object_struct *elf2obj_get_object_list(Elf *elf, elf2obj_section_struct *section_table, size_t section_cnt, size_t *cnt)
+{
+  elf2obj_object_struct *list = NULL;
+  elf2obj_object_struct *new_list;
+  elf2obj_object_struct *obj;
+  elf2obj_section_struct *sec;
+  const unsigned char *ptr;
+  Elf_Data *data;
+  GElf_Sym symbol;
+  size_t i, j, sym_cnt, max = 0;
+  unsigned symbol_type, symbol_bind;
   
-  for(;;)
+  *cnt = 0;
+  for( i = 0; i < section_cnt; i++ )
   {
-    data = elf_getdata(scn , data);     // if data==NULL return first data, otherwise return next data
-    if ( data == NULL )
-      break;
-    if ( data->d_buf == NULL )
+    if ( section_table[i].scn == NULL || section_table[i].shdr.sh_type != SHT_SYMTAB || section_table[i].shdr.sh_entsize == 0 )
+      continue;
+    data = elf_getdata(section_table[i].scn, NULL);
+    if ( data == NULL || data->d_type != ELF_T_SYM )
+      continue;
+    sym_cnt = section_table[i].shdr.sh_size / section_table[i].shdr.sh_entsize;
+    for( j = 0; j < sym_cnt; j++ )
     {
-      //fprintf(stderr, "get_symbol_mem_ptr: no buffer\n");
-      break;    // probably this is a BSS area
+      if ( gelf_getsym(data, j, &symbol) != &symbol )
+        break;
+      symbol_type = GELF_ST_TYPE(symbol.st_info);
+      symbol_bind = GELF_ST_BIND(symbol.st_info);
+      if ( symbol_type != STT_OBJECT && symbol_type != STT_FUNC )
+        continue;
+      /* identical code folding also merges weak and local (static) functions */
+      if ( symbol_bind != STB_GLOBAL && (elf2obj_is_icf == 0 || symbol_type != STT_FUNC || (symbol_bind != STB_WEAK && symbol_bind != STB_LOCAL)) )
+        continue;
+      if ( symbol.st_size == 0 ) // the symbol should have a size other than zero
+        continue;
+      if ( symbol.st_value == 0 && (elf2obj_is_icf == 0 || symbol.st_shndx == SHN_UNDEF || symbol.st_shndx >= SHN_LORESERVE) ) // the symbol should exist
+        continue;
+      if ( *cnt >= max )
+      {
+        new_list = (elf2obj_object_struct *)realloc(list, (max*2 + 64)*sizeof(elf2obj_object_struct));
+        if ( new_list == NULL )
+          return free(list), fprintf(stderr, "elf2obj: out of memory\n"), NULL;
+        list = new_list;
+        max = max*2 + 64;
+      }
+      obj = list + *cnt;
+      (*cnt)++;
+      obj->name = elf_strptr(elf, section_table[i].shdr.sh_link, symbol.st_name);
+      if ( obj->name == NULL )
+        obj->name = "";
+      obj->addr = symbol.st_value;
+      obj->size = symbol.st_size;
+      obj->type = symbol_type;
+      obj->section_name = "";
+      obj->is_content = 0;
+      obj->offset = 0;
+      obj->hash = 0;
+      obj->ptr = NULL;
+      obj->section_index = symbol.st_shndx;
+      if ( symbol.st_shndx == SHN_UNDEF || symbol.st_shndx >= section_cnt )
+        continue;
+      sec = section_table + symbol.st_shndx;
+      obj->section_name = sec->name;
+      ptr = elf2obj_get_object_ptr(sec, obj->addr, obj->size);
+      if ( ptr != NULL )
+      {
+        obj->is_content = 1;
+        obj->offset = sec->shdr.sh_offset + (obj->addr - sec->shdr.sh_addr);
+        obj->ptr = ptr;       // hash is calculated by elf2obj_hash_object_list()
+      }
     }
-    block_addr = shdr.sh_addr + data->d_off;    // calculate the address of this data in the target system, not 100% sure whether this is correct
-    //printf("block_addr=%08lx addr=%08lx d_buf=%p\n", block_addr, addr, data->d_buf);
-    if ( addr >= block_addr && addr < block_addr+data->d_size )  // check if the requested addr is inside the current block
+  }
+  if ( *cnt > 0 )
+    qsort(list, *cnt, sizeof(elf2obj_object_struct), elf2obj_cmp_object);
+  if ( list == NULL )
+    list = (elf2obj_object_struct *)malloc(sizeof(elf2obj_object_struct));
+  return list;
+}
+
+/* shared state of the threads, which calculate the hash values */
+struct _elf2obj_hash_struct
+{
+  pthread_mutex_t mutex;
+  elf2obj_object_struct *list;
+  size_t cnt;
+  size_t next;
+};
+typedef struct _elf2obj_hash_struct elf2obj_hash_struct;
+
+#define ELF2OBJ_HASH_CHUNK 256          // number of objects, which are taken by a thread at once
+
+void *elf2obj_hash_thread(void *arg)
+{
+  elf2obj_hash_struct *h = (elf2obj_hash_struct *)arg;
+  size_t i, first, last;
+  for(;;)
+  {
+    pthread_mutex_lock(&(h->mutex));
+    first = h->next;
+    last = first + ELF2OBJ_HASH_CHUNK < h->cnt ? first + ELF2OBJ_HASH_CHUNK : h->cnt;
+    h->next = last;
+    pthread_mutex_unlock(&(h->mutex));
+    if ( first >= last )
+      break;
+    for( i = first; i < last; i++ )
+      if ( h->list[i].ptr != NULL )
+        h->list[i].hash = relf_hash64(0, h->list[i].ptr, h->list[i].size);
+  }
+  return NULL;
+}
+
+/* calculate the hash of the content of all objects with up to elf2obj_thread_cnt threads */
+void elf2obj_hash_object_list(elf2obj_object_struct *list, size_t cnt)
+{
+  elf2obj_hash_struct h;
+  pthread_t *threads;
+  size_t i, n;
+  
+  h.list = list;
+  h.cnt = cnt;
+  h.next = 0;
+  pthread_mutex_init(&(h.mutex), NULL);
+  n = elf2obj_thread_cnt > 1 ? (size_t)elf2obj_thread_cnt : 1;
+  if ( n > (cnt + ELF2OBJ_HASH_CHUNK - 1) / ELF2OBJ_HASH_CHUNK )
+    n = (cnt + ELF2OBJ_HASH_CHUNK - 1) / ELF2OBJ_HASH_CHUNK;
+  threads = n > 1 ? (pthread_t *)malloc(n*sizeof(pthread_t)) : NULL;
+  i = 0;
+  if ( threads != NULL )
+    for( i = 0; i < n; i++ )
+      if ( pthread_create(threads+i, NULL, elf2obj_hash_thread, &h) != 0 )
+        break;
+  elf2obj_hash_thread(&h);
+  while( i > 0 )
+    pthread_join(threads[--i], NULL);
+  free(threads);
+  pthread_mutex_destroy(&(h.mutex));
+}
+
+/*==========================================*/
+/* Identical Code Folding */
+
+/*
+  Groups of functions with identical content, which could be merged by the linker (--icf) 
+  or by merging duplicate templates. The functions are entered into a hash table (key is the 
+  content hash) and a function joins a group only if size and content are identical.
+  Note: For a relocatable object file (.o) the content does not include the relocations.
+*/
+struct _elf2obj_group_struct
+{
+  size_t first;                 // index of the first function in the object list, see also next_list
+  size_t last;                  // index of the last function
+  size_t cnt;                   // number of functions
+  size_t chain;                 // next group with the same hash table slot, (size_t)-1 for the end of the chain
+  unsigned long long size;      // size of each function
+};
+typedef struct _elf2obj_group_struct elf2obj_group_struct;
+
+/* sort by the number of bytes, which would be reclaimed, then by address */
+int elf2obj_cmp_group(const void *a, const void *b)
+{
+  const elf2obj_group_struct *x = (const elf2obj_group_struct *)a;
+  const elf2obj_group_struct *y = (const elf2obj_group_struct *)b;
+  unsigned long long rx = x->size * (x->cnt - 1);
+  unsigned long long ry = y->size * (y->cnt - 1);
+  if ( rx != ry )
+    return rx > ry ? -1 : 1;
+  if ( x->first != y->first )
+    return x->first < y->first ? -1 : 1;
+  return 0;
+}
+
+/* 
+  returns 1 if list[i] is a function with content, which is not an alias of a previous function 
+  (same section and address, the list is sorted by address) 
+*/
+int elf2obj_is_icf_function(elf2obj_object_struct *list, size_t i)
+{
+  size_t k;
+  if ( list[i].type != STT_FUNC || list[i].ptr == NULL )
+    return 0;
+  for( k = i; k > 0 && list[k-1].addr == list[i].addr; k-- )
+    if ( list[k-1].type == STT_FUNC && list[k-1].ptr != NULL && list[k-1].section_index == list[i].section_index )
+      return 0;
+  return 1;
+}
+
+/*
+  Returns a malloc'd list of the groups with at least two functions or NULL, *group_cnt is the number of groups.
+  The functions of a group are linked by next_list (malloc'd, (size_t)-1 for the last function).
+  Symbols with the same section and address as a previous function (aliases) are ignored.
+*/
+elf2obj_group_struct *elf2obj_get_group_list(elf2obj_object_struct *list, size_t cnt, size_t **next_list, size_t *group_cnt)
+{
+  elf2obj_group_struct *group;
+  size_t *slot_list;
+  size_t *next;
+  size_t size = 16;
+  size_t i, g, slot, n = 0;
+  
+  while( size < cnt*2 )
+    size *= 2;
+  group = (elf2obj_group_struct *)malloc((cnt + 1)*sizeof(elf2obj_group_struct));
+  next = (size_t *)malloc((cnt + 1)*sizeof(size_t));
+  slot_list = (size_t *)malloc(size*sizeof(size_t));
+  if ( group == NULL || next == NULL || slot_list == NULL )
+    return free(group), free(next), free(slot_list), fprintf(stderr, "elf2obj: out of memory\n"), NULL;
+  memset(slot_list, 0xff, size*sizeof(size_t));       // (size_t)-1: empty slot
+  
+  for( i = 0; i < cnt; i++ )
+  {
+    next[i] = (size_t)-1;
+    if ( elf2obj_is_icf_function(list, i) == 0 )
+      continue;
+    
+    slot = (size_t)(list[i].hash & (size - 1));
+    for( g = slot_list[slot]; g != (size_t)-1; g = group[g].chain )
     {
-      return data->d_buf + addr - block_addr;   // found
+      if ( list[group[g].first].hash == list[i].hash && group[g].size == list[i].size 
+        && memcmp(list[group[g].first].ptr, list[i].ptr, list[i].size) == 0 )
+        break;
     }
-    else
+    if ( g != (size_t)-1 )
     {
-      // fprintf(stderr, "get_symbol_mem_ptr: block_addr=%lu - %lu addr=%lu\n", block_addr, block_addr+data->d_size, addr);      
+      next[group[g].last] = i;
+      group[g].last = i;
+      group[g].cnt++;
+      continue;
     }
-  }  
-  return NULL;
+    group[n].first = i;
+    group[n].last = i;
+    group[n].cnt = 1;
+    group[n].size = list[i].size;
+    group[n].chain = slot_list[slot];
+    slot_list[slot] = n;
+    n++;
+  }
+  free(slot_list);
+  
+  /* keep the groups with identical functions */
+  *group_cnt = 0;
+  for( g = 0; g < n; g++ )
+    if ( group[g].cnt >= 2 )
+      group[(*group_cnt)++] = group[g];
+  if ( *group_cnt > 0 )
+    qsort(group, *group_cnt, sizeof(elf2obj_group_struct), elf2obj_cmp_group);
+  *next_list = next;
+  return group;
 }
 
 
+/* write a string with JSON escape sequences */
+void elf2obj_show_json_string(const char *s)
+{
+  putchar('"');
+  for( ; *s != '\0'; s++ )
+  {
+    if ( *s == '"' || *s == '\\' )
+      printf("\\%c", *s);
+    else if ( (unsigned char)*s < 32 )
+      printf("\\u%04x", (unsigned)(unsigned char)*s);
+    else
+      putchar(*s);
+  }
+  putchar('"');
+}
 
-int elf2obj(Elf *elf)
+/* write a string as CSV field, a quote is written twice */
+void elf2obj_show_csv_string(const char *s)
 {
-  Elf_Scn  *scn  = NULL;
-  GElf_Shdr shdr;
-  size_t section_header_string_table_index = 0;
-  char *section_name = NULL;
-  char *symbol_name = NULL;
-  unsigned symbol_bind = 0;
-  unsigned symbol_type = 0;
+  putchar('"');
+  for( ; *s != '\0'; s++ )
+  {
+    if ( *s == '"' )
+      putchar('"');
+    putchar(*s);
+  }
+  putchar('"');
+}
+
+void elf2obj_show_object_list(elf2obj_object_struct *list, size_t cnt)
+{
+  size_t i;
   
+  if ( elf2obj_format == ELF2OBJ_FORMAT_JSON )
+    printf("[\n");
+  else if ( elf2obj_format == ELF2OBJ_FORMAT_CSV )
+    printf("address,size,type,section,offset,hash,name\n");
+  else
+    printf("address           size     type section              offset            hash              name\n");
   
-  if ( elf_kind( elf ) != ELF_K_ELF )
+  for( i = 0; i < cnt; i++ )
   {
-    fprintf(stderr, "Not an elf file (found kind %d)\n", elf_kind( elf ));
-    return 0;
+    if ( elf2obj_format == ELF2OBJ_FORMAT_JSON )
+    {
+      printf("{\"name\":");
+      elf2obj_show_json_string(list[i].name);
+      printf(", \"type\":\"%s\"", list[i].type == STT_FUNC ? "STT_FUNC" : "STT_OBJECT");
+      printf(", \"address\":[%llu, \"0x%08llx\"], \"size\":%llu", list[i].addr, list[i].addr, list[i].size);
+      printf(", \"section\":");
+      elf2obj_show_json_string(list[i].section_name);
+      if ( list[i].is_content )
+        printf(", \"offset\":[%llu, \"0x%08llx\"], \"hash\":\"0x%016llx\"}", list[i].offset, list[i].offset, list[i].hash);
+      else
+        printf(", \"offset\":null, \"hash\":null}");
+      printf("%s\n", i+1 < cnt ? "," : "");
+    }
+    else if ( elf2obj_format == ELF2OBJ_FORMAT_CSV )
+    {
+      printf("0x%08llx,%llu,%c,", list[i].addr, list[i].size, list[i].type == STT_FUNC ? 'F' : 'O');
+      elf2obj_show_csv_string(list[i].section_name);
+      if ( list[i].is_content )
+        printf(",0x%08llx,0x%016llx,", list[i].offset, list[i].hash);
+      else
+        printf(",,,");
+      elf2obj_show_csv_string(list[i].name);
+      printf("\n");
+    }
+    else
+    {
+      printf("%016llx  %8llu %c    %-20s ", list[i].addr, list[i].size, list[i].type == STT_FUNC ? 'F' : 'O', list[i].section_name);
+      if ( list[i].is_content )
+        printf("%016llx  %016llx  ", list[i].offset, list[i].hash);
+      else
+        printf("%-16s  %-16s  ", "-", "-");
+      printf("%s\n", list[i].name);
+    }
   }
+  if ( elf2obj_format == ELF2OBJ_FORMAT_JSON )
+    printf("]\n");
+}
 
-  if ( elf_getshdrstrndx(elf, &(section_header_string_table_index) ) < 0 )
+void elf2obj_show_group_list(elf2obj_object_struct *list, size_t cnt, elf2obj_group_struct *group, size_t group_cnt, size_t *next)
+{
+  unsigned long long reclaim = 0, function_size = 0;
+  size_t function_cnt = 0, icf_function_cnt = 0;
+  size_t g, i;
+  
+  /* functions with content, without aliases, same as elf2obj_get_group_list() */
+  for( i = 0; i < cnt; i++ )
   {
-    fprintf(stderr, "Sectionheader string table not found libelf: %s\n", elf_errmsg(-1));
-    return 0;
+    if ( elf2obj_is_icf_function(list, i) == 0 )
+      continue;
+    function_cnt++;
+    function_size += list[i].size;
   }
   
+  if ( elf2obj_format == ELF2OBJ_FORMAT_JSON )
+    printf("{\n\"icf_group_list\":\n[\n");
+  else if ( elf2obj_format == ELF2OBJ_FORMAT_CSV )
+    printf("group,address,size,hash,name\n");
+  else
+    printf("group  functions  size      reclaim   hash\n");
   
-  /* loop over all sections */
-  while (( scn = elf_nextscn(elf, scn)) != NULL ) 
+  for( g = 0; g < group_cnt; g++ )
   {
-    if ( gelf_getshdr( scn, &shdr ) != &shdr )
-      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
-
-    if ( shdr.sh_type == SHT_SYMTAB )  
+    reclaim += group[g].size * (group[g].cnt - 1);
+    icf_function_cnt += group[g].cnt;
+    if ( elf2obj_format == ELF2OBJ_FORMAT_JSON )
+      printf("{\"size\":%llu, \"reclaim\":%llu, \"hash\":\"0x%016llx\", \"function_list\":[", 
+        group[g].size, group[g].size * (group[g].cnt - 1), list[group[g].first].hash);
+    else if ( elf2obj_format == ELF2OBJ_FORMAT_TEXT )
+      printf("%-6lu %9lu  %-9llu %-9llu 0x%016llx\n", (unsigned long)g+1, (unsigned long)group[g].cnt, 
+        group[g].size, group[g].size * (group[g].cnt - 1), list[group[g].first].hash);
+    for( i = group[g].first; i != (size_t)-1; i = next[i] )
     {
-      /* shdr.sh_link contains the section number of the corresponding string table */
-      
-      section_name = elf_strptr(elf, section_header_string_table_index, shdr.sh_name );
-      
-      /* loop over the data blocks of the section */
-      Elf_Data *data = NULL;
-      for(;;)
+      if ( elf2obj_format == ELF2OBJ_FORMAT_JSON )
       {
-        data = elf_getdata(scn , data);     // if data==NULL return first data, otherwise return next data
-        if ( data == NULL )
-          break;
-        if ( data->d_buf == NULL )
-          break;
-        
-        if ( data->d_type == ELF_T_SYM )
-        {
-          int i = 0;
-          GElf_Sym symbol;
-          
-          while( gelf_getsym(data, i, &symbol) == &symbol )
-          {
-            symbol_name = elf_strptr(elf, shdr.sh_link, symbol.st_name);
-            symbol_bind = GELF_ST_BIND(symbol.st_info);
-            symbol_type = GELF_ST_TYPE(symbol.st_info);
-            if ( symbol_bind == STB_GLOBAL )
-            {
-              if ( symbol_type == STT_OBJECT || symbol_type == STT_FUNC )
-              {
-                if ( symbol.st_value > 0 && symbol.st_size > 0 ) // the symbol should exist and should have a size other than zero
-                {
-                  // symbol.st_shndx            section where the symbol content is located
-                  // symbol.st_value            address of the symbol on the host
-                  void *sym_ptr = get_symbol_mem_ptr(elf, &symbol);   // return value could be NULL
-                  printf("section %s, data blk size %llu, type %c, val %8llu, size %8llu, ptr %8p, scn %3d, symbol %s\n", 
-						section_name, 
-						(long long unsigned)data->d_size, 
-						symbol_type == STT_FUNC ? 'F' : 'O', 
-						(long long unsigned)symbol.st_value, 
-						(long long unsigned)symbol.st_size, 
-						sym_ptr, symbol.st_shndx, symbol_name);
-                } // existing & none-empty symbols
-              } // symbol is function or object
-            } // symbol with bind == STB_GLOBAL
-            i++;
-          } // loop over all symbols          
-        } // data block type is ELF_T_SYM
-      } // loop over data blocks of a section      
-    } // section type is SHT_SYMTAB
-  } // loop over all sections
+        printf("{\"name\":");
+        elf2obj_show_json_string(list[i].name);
+        printf(", \"address\":[%llu, \"0x%08llx\"]}%s", list[i].addr, list[i].addr, next[i] != (size_t)-1 ? ", " : "");
+      }
+      else if ( elf2obj_format == ELF2OBJ_FORMAT_CSV )
+      {
+        printf("%lu,0x%08llx,%llu,0x%016llx,", (unsigned long)g+1, list[i].addr, list[i].size, list[i].hash);
+        elf2obj_show_csv_string(list[i].name);
+        printf("\n");
+      }
+      else
+        printf("    %016llx  %s\n", list[i].addr, list[i].name);
+    }
+    if ( elf2obj_format == ELF2OBJ_FORMAT_JSON )
+      printf("]}%s\n", g+1 < group_cnt ? "," : "");
+  }
   
-  return 1;
+  if ( elf2obj_format == ELF2OBJ_FORMAT_JSON )
+    printf("],\n\"icf_group_cnt\":%lu, \"icf_function_cnt\":%lu, \"icf_reclaim\":%llu, \"function_cnt\":%lu, \"function_size\":%llu\n}\n",
+      (unsigned long)group_cnt, (unsigned long)icf_function_cnt, reclaim, (unsigned long)function_cnt, function_size);
+  else if ( elf2obj_format == ELF2OBJ_FORMAT_TEXT )
+    printf("%lu groups with %lu identical functions, %llu bytes reclaimable (%lu functions with %llu bytes)\n",
+      (unsigned long)group_cnt, (unsigned long)icf_function_cnt, reclaim, (unsigned long)function_cnt, function_size);
 }
 
+/*==========================================*/
 
+int elf2obj(Elf *elf)
+{
+  elf2obj_section_struct *section_table;
+  elf2obj_object_struct *list;
+  elf2obj_group_struct *group;
+  size_t *next;
+  size_t section_cnt, cnt, group_cnt;
+  
+  if ( elf_kind( elf ) != ELF_K_ELF )
+  {
+    fprintf(stderr, "Not an elf file (found kind %d)\n", elf_kind( elf ));
+    return 0;
+  }
+  
+  section_table = elf2obj_get_section_table(elf, &section_cnt);
+  if ( section_table == NULL )
+    return 0;
+  list = elf2obj_get_object_list(elf, section_table, section_cnt, &cnt);
+  if ( list == NULL )
+    return free(section_table), 0;
+  elf2obj_hash_object_list(list, cnt);
+  if ( elf2obj_is_icf )
+  {
+    group = elf2obj_get_group_list(list, cnt, &next, &group_cnt);
+    if ( group == NULL )
+      return free(list), free(section_table), 0;
+    elf2obj_show_group_list(list, cnt, group, group_cnt, next);
+    free(group);
+    free(next);
+  }
+  else
+    elf2obj_show_object_list(list, cnt);
+  free(list);
+  free(section_table);
+  return 1;
+}
 
-
-
+/*
+  elf2obj [-f text|json|csv] [-i] [-j <threads>] <input.elf>
+    -f    output format (default: text)
+    -i    list groups of identical functions (candidates for identical code folding)
+    -j    number of threads, which calculate the hash values (default: 4)
+*/
 int main(int argc, char **argv)
 {
   int fd = -1;
   Elf *elf = NULL;
   char *elf_filename = NULL;
-  if ( argc < 2 )
+  int i;
+  
+  for( i = 1; i < argc; i++ )
+  {
+    if ( strcmp(argv[i], "-f") == 0 && i+1 < argc )
+    {
+      i++;
+      if ( strcmp(argv[i], "text") == 0 )
+        elf2obj_format = ELF2OBJ_FORMAT_TEXT;
+      else if ( strcmp(argv[i], "json") == 0 )
+        elf2obj_format = ELF2OBJ_FORMAT_JSON;
+      else if ( strcmp(argv[i], "csv") == 0 )
+        elf2obj_format = ELF2OBJ_FORMAT_CSV;
+      else
+        return fprintf(stderr, "Unknown output format '%s'\n", argv[i]), 1;
+    }
+    else if ( strcmp(argv[i], "-i") == 0 )
+      elf2obj_is_icf = 1;
+    else if ( strcmp(argv[i], "-j") == 0 && i+1 < argc )
+      elf2obj_thread_cnt = atoi(argv[++i]);
+    else
+      elf_filename = argv[i];
+  }
+  if ( elf_filename == NULL )
   {
-    printf("%s <input.elf>\n", argv[0]);
+    printf("%s [-f text|json|csv] [-i] [-j <threads>] <input.elf>\n", argv[0]);
     return 1;
   }
 
   if ( elf_version( EV_CURRENT ) == EV_NONE )
     return fprintf(stderr, "Incorrect libelf version: %s\n", elf_errmsg(-1) ), 0;
   
-  elf_filename = argv[1];
   fd = open( elf_filename, O_RDONLY  | O_BINARY , 0);
   if ( fd >= 0 )
   {
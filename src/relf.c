@@ -0,0 +1,1619 @@
+/*
+
+  relf.c
+
+
+  Copyright (C) 2024  olikraus@gmail.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  libelf2json: Read-only ELF wrapper for the gelf/elf library, see relf.h
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+#include <assert.h>
+#include "relf.h"
+
+#if defined(__MINGW32__) || defined(__MINGW64__)
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*==========================================*/
+/* CRC32 from https://datatracker.ietf.org/doc/html/rfc1952#section-8 */
+/* updated names and data-types */
+
+/* Table of CRCs of all 8-bit messages. */
+unsigned long crc_table[256];
+
+/* Flag: has the table been computed? Initially false. */
+int is_crc_table_computed = 0;
+
+/* Make the table for a fast CRC. */
+void compute_crc_table(void)
+{
+  unsigned long c;
+  int n, k;
+  for (n = 0; n < 256; n++) 
+  {
+    c = (unsigned long) n;
+    for (k = 0; k < 8; k++) 
+    {
+      if (c & 1) 
+      {
+        c = 0xedb88320L ^ (c >> 1);
+      } 
+      else 
+      {
+        c = c >> 1;
+      }
+    }
+    crc_table[n] = c;
+  }
+  is_crc_table_computed = 1;
+}
+
+/*
+ Update a running crc with the bytes buf[0..len-1] and return
+ the updated crc. The crc should be initialized to zero. Pre- and
+ post-conditioning (one's complement) is performed within this
+ function so it shouldn't be done by the caller. Usage example:
+
+   unsigned long crc = 0L;
+
+   while (read_buffer(buffer, length) != EOF) {
+     crc = update_crc(crc, buffer, length);
+   }
+   if (crc != original_crc) error();
+*/
+unsigned long update_crc(unsigned long crc, unsigned char *buf, size_t len)
+{
+  unsigned long c = crc ^ 0xffffffffL;
+  size_t n;
+
+  if (!is_crc_table_computed)
+    compute_crc_table();
+  for (n = 0; n < len; n++) 
+  {
+    c = crc_table[(c ^ buf[n]) & 0xff] ^ (c >> 8);
+  }
+  return c ^ 0xffffffffL;
+}
+
+/* Return the CRC of the bytes buf[0..len-1]. */
+unsigned long get_crc(unsigned char *buf, size_t len)
+{
+  return update_crc(0L, buf, len);
+}
+
+/*==========================================*/
+/* 64 bit hash */
+
+/* 
+  update the 64 bit hash h with the bytes ptr[0..len-1], 
+  the hash is used to detect changes, it is not a cryptographic hash
+*/
+unsigned long long relf_hash64(unsigned long long h, const void *ptr, size_t len)
+{
+  const unsigned char *p = (const unsigned char *)ptr;
+  unsigned long long k;
+  
+  h ^= (unsigned long long)len * 0x9e3779b97f4a7c15ULL;
+  while( len >= 8 )
+  {
+    memcpy(&k, p, 8);
+    k *= 0x87c37b91114253d5ULL;
+    k ^= k >> 31;
+    k *= 0x4cf5ad432745937fULL;
+    h ^= k;
+    h = ((h << 27) | (h >> 37)) * 5 + 0x52dce729;
+    p += 8;
+    len -= 8;
+  }
+  while( len > 0 )
+  {
+    h ^= *p++;
+    h *= 0x100000001b3ULL;
+    len--;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+      
+
+/*==========================================*/
+
+/* return an SHF_ALLOC section which is most close to the given addess */
+/* addr will be updated */
+Elf_Scn  *get_section_by_address(Elf * e, Elf64_Addr *addr)
+{
+  Elf64_Addr min_delta = (Elf64_Addr)-1;
+  Elf_Scn  *min_scn  = NULL;
+  Elf64_Addr new_addr;
+  
+  GElf_Shdr shdr;
+  Elf_Scn  *scn  = NULL;
+  /* loop over all sections */
+  scn = NULL;
+  while (( scn = elf_nextscn(e, scn)) != NULL ) 
+  {
+    if ( gelf_getshdr( scn, &shdr ) != &shdr )
+      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
+    if ( (shdr.sh_flags & SHF_ALLOC) != 0 && shdr.sh_size > 0 )
+    {
+      if ( shdr.sh_addr >= *addr )
+      {
+        if ( min_delta > shdr.sh_addr -  *addr )
+        {
+          min_delta = shdr.sh_addr -  *addr;
+          min_scn = scn;
+          new_addr = shdr.sh_addr + shdr.sh_size;
+        }
+      }
+    }
+  }
+  if ( min_scn != NULL )
+  {
+    /*
+    if ( gelf_getshdr( min_scn, &shdr ) != &shdr )
+      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
+    fprintf(stderr, "%09lx: %09lx %09lx\n", *addr, shdr.sh_addr, shdr.sh_size);
+    */
+    *addr = new_addr;
+  }
+  return min_scn;
+}
+
+/* return symbel with index sym_idx from section with the number scn_idx, the symbol is copied to *symbol */
+const GElf_Sym *get_symbol(Elf *elf, size_t scn_idx, int sym_idx, GElf_Sym *symbol)
+{
+
+  Elf_Scn *scn = elf_getscn(elf, scn_idx);
+  if ( scn != NULL )
+  {
+    // Elf_Data *elf_getdata (Elf_Scn *__scn, Elf_Data *__data);
+    Elf_Data *data = NULL;
+    size_t symbols_per_data;
+    GElf_Shdr shdr;
+    if ( gelf_getshdr( scn, &shdr ) != &shdr )
+      return NULL;
+    
+    for(;;)
+    {
+      data = elf_getdata(scn , data);     // if data==NULL return first data, otherwise return next data
+      if ( data == NULL )
+        return NULL;
+      symbols_per_data = data->d_size / shdr.sh_entsize;
+      assert(shdr.sh_entsize*symbols_per_data == data->d_size);
+      if ( sym_idx < symbols_per_data )
+        break;
+      sym_idx -= data->d_size / shdr.sh_entsize;
+    }
+    return gelf_getsym(data, sym_idx, symbol);
+  }
+  return NULL;
+}
+
+const char *get_symbol_name(Elf *elf, size_t scn_idx, int sym_idx)
+{
+  GElf_Sym symbol;
+  const GElf_Sym *sym = get_symbol(elf, scn_idx, sym_idx, &symbol);
+  if ( sym != NULL )
+  {
+    Elf_Scn *scn = elf_getscn(elf, scn_idx);
+    GElf_Shdr shdr;
+    if ( gelf_getshdr( scn, &shdr ) != &shdr )
+      return NULL;
+
+    return elf_strptr(elf, shdr.sh_link, sym->st_name );
+  }
+  return NULL;
+}
+
+
+/*==========================================*/
+/* Read-Onle ELF wrapper for the gelf/elf library */
+
+
+// returns NULL if not found
+Elf_Scn *relf_find_scn_by_name(relf_struct *relf, const char *name)
+{
+  Elf_Scn  *scn;        // section descriptor
+  GElf_Shdr shdr;
+  const char *section_name;
+  /* loop over all sections */
+  scn = elf_nextscn(relf->elf, NULL);
+  while ( scn != NULL ) 
+  {
+    if ( gelf_getshdr( scn, &shdr ) != &shdr )
+        return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
+    section_name = elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name );
+    if ( section_name == NULL )
+      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
+    if ( strcmp(section_name, name) == 0 )
+      return scn;
+    scn = elf_nextscn(relf->elf, scn);
+  }
+  return NULL; /* section not found */
+}
+
+// returns 0 if not found
+size_t relf_find_section_index_by_name(relf_struct *relf, const char *name)
+{
+  Elf_Scn *scn = relf_find_scn_by_name(relf, name);
+  if ( scn == NULL )
+    return 0;
+  return elf_ndxscn( scn ); // returns SHN_UNDEF in case of error, SHN_UNDEF is zero  (elf.h)
+}
+
+/* 
+  read the elf header and the section/program header numbers after relf->elf has been created
+  calls elf_end() in case of an error
+*/
+int relf_init_elf(relf_struct *relf)
+{
+  if ( elf_kind( relf->elf ) == ELF_K_ELF )
+  {
+    if ( gelf_getehdr(relf->elf, &(relf->elf_file_header) ) != NULL )
+    {
+      if ( elf_getshdrnum(relf->elf, &(relf->section_header_total) ) == 0 )
+      {
+        if ( elf_getshdrstrndx(relf->elf, &(relf->section_header_string_table_index) ) == 0 )
+        {
+          if ( elf_getphdrnum(relf->elf, &(relf->program_header_total) ) == 0 )
+          {
+            /* section index is 0 if not found */
+            relf->symtab_section_index = relf_find_section_index_by_name(relf, ".symtab"); 
+            relf->strtab_section_index = relf_find_section_index_by_name(relf, ".strtab"); 
+            relf->dynsym_section_index = relf_find_section_index_by_name(relf, ".dynsym"); 
+            relf->dynstr_section_index = relf_find_section_index_by_name(relf, ".dynstr"); 
+            
+            relf->native = relf->map != NULL ? relf_get_native(relf->map) : NULL;
+            
+            if ( relf_init_memory_budget(relf) == 0 )
+            {
+              fprintf(stderr, "relf_init_memory_budget: out of memory\n");
+            }
+            else
+            {
+              if ( relf_init_symbol_versions(relf) != 0 )
+                return 1;
+              fprintf(stderr, "relf_init_symbol_versions: out of memory\n");
+              free(relf->is_scn_skipped_list);
+            }
+          }
+          else
+          {
+            fprintf(stderr, "elf_getphdrnum failed: %s\n", elf_errmsg(-1));
+          }
+        }
+        else
+        {
+          fprintf(stderr, "elf_getshdrstrndx failed: %s\n", elf_errmsg(-1));
+        }
+      }
+      else
+      {
+        fprintf(stderr, "elf_getshdrnum failed: %s\n", elf_errmsg(-1));
+      }
+    }
+    else
+    {
+      fprintf(stderr, "Unable to get elf file header: %s\n", elf_errmsg(-1));
+    }
+  }
+  else
+  {
+    fprintf(stderr, "Not an elf file (found kind %d)\n", elf_kind( relf->elf ));
+  }
+  elf_end(relf->elf);
+  return 0;
+}
+
+/* 
+  read the complete content of a file descriptor (for example a pipe) into memory 
+  returns a malloc'd buffer or NULL in case of an error
+*/
+char *relf_read_fd(int fd, size_t *size)
+{
+  struct stat st;
+  size_t max = 1024*1024;
+  size_t len = 0;
+  char *buf, *new_buf;
+  ssize_t cnt;
+  
+  if ( fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 )
+    max = (size_t)st.st_size + 1;         // +1: avoid realloc to detect the end of the file
+  buf = (char *)malloc(max);
+  if ( buf == NULL )
+    return fprintf(stderr, "relf_read_fd: out of memory\n"), NULL;
+  for(;;)
+  {
+    if ( len == max )
+    {
+      new_buf = (char *)realloc(buf, max*2);
+      if ( new_buf == NULL )
+        return free(buf), fprintf(stderr, "relf_read_fd: out of memory\n"), NULL;
+      buf = new_buf;
+      max *= 2;
+    }
+    cnt = read(fd, buf+len, max-len);
+    if ( cnt < 0 )
+      return free(buf), perror("relf_read_fd"), NULL;
+    if ( cnt == 0 )
+      break;
+    len += cnt;
+  }
+  *size = len;
+  return buf;
+}
+
+/*
+  Open the elf file with name elf_filename.
+  If elf_filename is "-", then the elf file is read from stdin.
+*/
+int relf_init(relf_struct *relf, const char *elf_filename)
+{
+  char *image;
+  size_t image_size;
+  struct stat st;
+  
+  memset(relf, 0, sizeof(relf_struct));
+    
+  if ( elf_version( EV_CURRENT ) == EV_NONE )
+    return fprintf(stderr, "Incorrect libelf version: %s\n", elf_errmsg(-1) ), 0;
+
+  if ( strcmp(elf_filename, "-") == 0 )
+  {
+#if defined(__MINGW32__) || defined(__MINGW64__)
+    setmode(0, O_BINARY);
+#endif
+    image = relf_read_fd(0, &image_size);
+    if ( image == NULL )
+      return 0;
+    if ( relf_init_memory(relf, image, image_size) == 0 )
+      return free(image), 0;
+    relf->is_image_owned = 1;
+    return 1;
+  }
+  
+  relf->fd = open( elf_filename , O_RDONLY | O_BINARY , 0);
+  if ( relf->fd >= 0 )
+  {
+    if ( fstat(relf->fd, &st) == 0 && st.st_size > 0 )
+      relf->file_size = (size_t)st.st_size;
+#if !defined(__MINGW32__) && !defined(__MINGW64__)
+    /* the map is used by the native reader, libelf still reads the file with read() */
+    if ( relf->file_size > 0 && S_ISREG(st.st_mode) )
+    {
+      void *map = mmap(NULL, relf->file_size, PROT_READ, MAP_PRIVATE, relf->fd, 0);
+      if ( map != MAP_FAILED )
+      {
+        relf->map = (const unsigned char *)map;
+        relf->map_size = relf->file_size;
+        relf->is_map_owned = 1;
+      }
+    }
+#endif
+    if (( relf->elf = elf_begin( relf->fd , ELF_C_READ, NULL )) != NULL )
+    {
+      if ( relf_init_elf(relf) != 0 )
+        return 1;
+    }
+    else
+    {
+      fprintf(stderr, "elf_begin failed: %s\n", elf_errmsg(-1));
+    }
+#if !defined(__MINGW32__) && !defined(__MINGW64__)
+    if ( relf->is_map_owned )
+      munmap((void *)relf->map, relf->map_size);
+#endif
+    close(relf->fd);
+  }
+  else
+  {
+    perror(elf_filename);
+  }
+  
+  memset(relf, 0, sizeof(relf_struct));
+  return 0;
+}
+
+/*
+  Use an elf file, which is already in memory.
+  The memory is owned by the caller and must not be changed or freed before relf_destroy() is called.
+*/
+int relf_init_memory(relf_struct *relf, char *image, size_t image_size)
+{
+  memset(relf, 0, sizeof(relf_struct));
+  relf->fd = -1;
+    
+  if ( elf_version( EV_CURRENT ) == EV_NONE )
+    return fprintf(stderr, "Incorrect libelf version: %s\n", elf_errmsg(-1) ), 0;
+  
+  relf->image = image;
+  relf->image_size = image_size;
+  relf->file_size = image_size;
+  relf->map = (const unsigned char *)image;
+  relf->map_size = image_size;
+  if (( relf->elf = elf_memory( image, image_size )) != NULL )
+  {
+    if ( relf_init_elf(relf) != 0 )
+      return 1;
+  }
+  else
+  {
+    fprintf(stderr, "elf_memory failed: %s\n", elf_errmsg(-1));
+  }
+  memset(relf, 0, sizeof(relf_struct));
+  return 0;
+}
+
+void relf_destroy(relf_struct *relf)
+{
+  free(relf->symbol_version_list);
+  free(relf->symbol_version_name_list);
+  free(relf->is_scn_skipped_list);
+  elf_end(relf->elf);  
+#if !defined(__MINGW32__) && !defined(__MINGW64__)
+  if ( relf->is_map_owned )
+    munmap((void *)relf->map, relf->map_size);
+#endif
+  if ( relf->fd >= 0 )
+    close(relf->fd);  
+  if ( relf->is_image_owned )
+    free(relf->image);
+}
+
+/* returns a pointer to a memory location within a section */
+void *relf_get_mem_ptr(relf_struct *relf, size_t section_index, size_t addr)
+{
+  GElf_Shdr shdr;
+  Elf_Scn *scn;
+  Elf_Data *data = NULL;
+  size_t block_addr = 0;
+  
+  if ( section_index == 0 || section_index > 0x0fff0 )
+    return NULL;
+  
+  scn = elf_getscn (relf->elf,  section_index);  
+  if ( scn == NULL )
+    return fprintf(stderr, "libelf: %s, section_index=%lld \n", elf_errmsg(-1), (long long int)section_index), NULL;
+  if ( gelf_getshdr( scn, &shdr ) != &shdr )
+    return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), NULL;
+
+  /*
+    shdr.sh_addr                contains the base address for the target memory
+    shdr.sh_size                 contains the size of the section
+  */
+  
+  if ( shdr.sh_size == 0 )
+    return NULL;
+  if ( relf_is_scn_data_allowed(relf, scn) == 0 )
+    return NULL;                // use relf_get_file_offset() instead
+  
+  for(;;)
+  {
+    data = elf_getdata(scn , data);     // if data==NULL return first data, otherwise return next data
+    if ( data == NULL )
+      break;
+    if ( data->d_buf == NULL )
+      break;
+    block_addr = shdr.sh_addr + data->d_off;    // calculate the address of this data in the target system, not 100% sure whether this is correct
+    //printf("block_addr=%08lx addr=%08lx d_buf=%p\n", block_addr, addr, data->d_buf);
+    if ( addr >= block_addr && addr < block_addr+data->d_size )  // check if the requested addr is inside the current block
+    {
+      return data->d_buf + addr - block_addr;   // found
+    }
+  }  
+  return NULL;
+}
+
+
+/*
+  Returns the offset of addr within the elf file. addr is an address within the section with index section_index.
+  This allows to read the content of a section, which is not loaded by libelf (see relf_get_mem_ptr()) with relf_read().
+  Returns 0 if the section doesn't have any content in the elf file or if the content is compressed.
+*/
+size_t relf_get_file_offset(relf_struct *relf, size_t section_index, size_t addr)
+{
+  GElf_Shdr shdr;
+  Elf_Scn *scn;
+  
+  if ( section_index == 0 || section_index > 0x0fff0 )
+    return 0;
+  scn = elf_getscn (relf->elf,  section_index);  
+  if ( scn == NULL || gelf_getshdr( scn, &shdr ) != &shdr )
+    return 0;
+  if ( shdr.sh_type == SHT_NOBITS || (shdr.sh_flags & SHF_COMPRESSED) != 0 )
+    return 0;
+  if ( addr < shdr.sh_addr || addr - shdr.sh_addr >= shdr.sh_size )
+    return 0;
+  return shdr.sh_offset + addr - shdr.sh_addr;
+}
+
+
+/*==========================================*/
+/* Memory Budget */
+
+/*
+  relf_max_memory limits the number of bytes of section data, which are in memory at the same time (0: no limit).
+  
+  With a limit (bounded mode), section data is not requested from libelf (elf_getdata()), except for the 
+  string and version tables, which libelf needs for all names (elf_strptr()). Instead:
+    - symbols, relocations and dynamic entries are read with relf_read() in windows of at most 
+      RELF_READ_CHUNK_SIZE and relf_max_memory bytes, each window replaces the previous one (see relf_init_scn_records())
+    - obj_crc and obj_data of a symbol are read in chunks from the file (see relf_get_file_crc())
+    - notes are read as a whole, if they fit into the limit
+    - the data_list of all other sections describes the raw section content without reading it
+  relf_init_memory_budget() decides once which sections are skipped: A section is skipped if it exceeds the 
+  elf file (corrupted sh_size or sh_offset), if a single record does not fit into the limit, if the records are 
+  compressed or if a note section is larger than the limit. A warning is written for each skipped section.
+  If the string and version tables together are larger than the limit, a warning is written, but they are 
+  still loaded by libelf.
+*/
+size_t relf_max_memory = 0;
+
+/* reasons for a skipped section, stored in is_scn_skipped_list */
+#define RELF_SKIP_OUTSIDE_FILE 1
+#define RELF_SKIP_RECORD_SIZE 2
+#define RELF_SKIP_COMPRESSED 3
+#define RELF_SKIP_NOTE_SIZE 4
+
+/* returns the record type of a SHT_SYMTAB, SHT_DYNSYM, SHT_RELA, SHT_REL or SHT_DYNAMIC section, ELF_T_BYTE otherwise */
+static Elf_Type relf_get_scn_record_type(const GElf_Shdr *shdr)
+{
+  switch(shdr->sh_type)
+  {
+    case SHT_SYMTAB: case SHT_DYNSYM: return ELF_T_SYM;
+    case SHT_RELA: return ELF_T_RELA;
+    case SHT_REL: return ELF_T_REL;
+    case SHT_DYNAMIC: return ELF_T_DYN;
+  }
+  return ELF_T_BYTE;
+}
+
+/* returns 1 for sections, which are required by libelf for names and symbol versions */
+static int relf_is_resident_scn(const GElf_Shdr *shdr)
+{
+  return shdr->sh_type == SHT_STRTAB || shdr->sh_type == SHT_GNU_versym 
+    || shdr->sh_type == SHT_GNU_verdef || shdr->sh_type == SHT_GNU_verneed;
+}
+
+/* returns the reason for a skipped section or NULL if the section is not skipped */
+const char *relf_get_scn_skip_reason(relf_struct *relf, size_t index)
+{
+  if ( relf->is_scn_skipped_list == NULL || index >= relf->section_header_total )
+    return NULL;
+  switch(relf->is_scn_skipped_list[index])
+  {
+    case RELF_SKIP_OUTSIDE_FILE: return "section exceeds the elf file";
+    case RELF_SKIP_RECORD_SIZE: return "record is larger than the memory limit";
+    case RELF_SKIP_COMPRESSED: return "compressed records can not be read in windows";
+    case RELF_SKIP_NOTE_SIZE: return "note section is larger than the memory limit";
+  }
+  return NULL;
+}
+
+/* fill is_scn_skipped_list, returns 0 if there is not enough memory */
+int relf_init_memory_budget(relf_struct *relf)
+{
+  size_t resident_size = 0;
+  size_t i;
+  Elf_Scn *scn;
+  GElf_Shdr shdr;
+  Elf_Type type;
+  const char *name;
+  
+  relf->is_scn_skipped_list = NULL;
+  relf->skipped_scn_cnt = 0;
+  if ( relf_max_memory == 0 )
+    return 1;
+  
+  relf->is_scn_skipped_list = (unsigned char *)calloc(relf->section_header_total+1, 1);
+  if ( relf->is_scn_skipped_list == NULL )
+    return 0;
+  
+  for( i = 1; i < relf->section_header_total; i++ )
+  {
+    scn = elf_getscn(relf->elf, i);
+    if ( scn == NULL || gelf_getshdr( scn, &shdr ) != &shdr )
+      continue;
+    if ( shdr.sh_type == SHT_NOBITS || shdr.sh_size == 0 )
+      continue;
+    type = relf_get_scn_record_type(&shdr);
+    if ( relf->file_size > 0 && (shdr.sh_offset > relf->file_size || shdr.sh_size > relf->file_size - shdr.sh_offset) )
+      relf->is_scn_skipped_list[i] = RELF_SKIP_OUTSIDE_FILE;
+    else if ( relf_is_resident_scn(&shdr) )
+      resident_size += shdr.sh_size;
+    else if ( type != ELF_T_BYTE && (shdr.sh_flags & SHF_COMPRESSED) != 0 )
+      relf->is_scn_skipped_list[i] = RELF_SKIP_COMPRESSED;
+    else if ( type != ELF_T_BYTE && gelf_fsize(relf->elf, type, 1, EV_CURRENT) > relf_max_memory )
+      relf->is_scn_skipped_list[i] = RELF_SKIP_RECORD_SIZE;
+    else if ( shdr.sh_type == SHT_NOTE && shdr.sh_size > relf_max_memory )
+      relf->is_scn_skipped_list[i] = RELF_SKIP_NOTE_SIZE;
+    
+    if ( relf->is_scn_skipped_list[i] != 0 )
+    {
+      relf->skipped_scn_cnt++;
+      name = elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name);
+      fprintf(stderr, "relf: section %zu '%s' skipped: %s\n", i, name != NULL ? name : "", relf_get_scn_skip_reason(relf, i));
+    }
+  }
+  if ( resident_size > relf_max_memory )
+    fprintf(stderr, "relf: string and version tables need %zu bytes, more than the memory limit of %zu bytes\n", resident_size, relf_max_memory);
+  return 1;
+}
+
+/* 
+  returns 0 if the section data must not be read with elf_getdata(), 
+  with a memory limit only the string and version tables are read with elf_getdata()
+*/
+int relf_is_scn_data_allowed(relf_struct *relf, Elf_Scn *scn)
+{
+  size_t i;
+  GElf_Shdr shdr;
+  if ( relf->is_scn_skipped_list == NULL || scn == NULL )
+    return 1;
+  i = elf_ndxscn(scn);
+  if ( i >= relf->section_header_total )
+    return 1;
+  if ( relf->is_scn_skipped_list[i] != 0 )
+    return 0;
+  return gelf_getshdr( scn, &shdr ) == &shdr && relf_is_resident_scn(&shdr);
+}
+
+
+/*==========================================*/
+/* Symbol Versions */
+
+/*
+  Walk through the version definitions (SHT_GNU_verdef) or the version requirements (SHT_GNU_verneed)
+  of the section scn and store the version name for each version index in name_list.
+  If name_list is NULL, then only the max version index is calculated.
+  Returns the max version index.
+*/
+size_t relf_walk_version_section(relf_struct *relf, Elf_Scn *scn, const char **name_list)
+{
+  GElf_Shdr shdr;
+  Elf_Data *data;
+  GElf_Verdef verdef;
+  GElf_Verdaux verdaux;
+  GElf_Verneed verneed;
+  GElf_Vernaux vernaux;
+  size_t offset = 0;
+  size_t aux_offset;
+  size_t idx;
+  size_t max = 0;
+  size_t i, j;
+  
+  if ( scn == NULL || gelf_getshdr(scn, &shdr) != &shdr )
+    return 0;
+  if ( relf_is_scn_data_allowed(relf, scn) == 0 )
+    return 0;
+  data = elf_getdata(scn, NULL);
+  if ( data == NULL )
+    return 0;
+  /* sh_info contains the number of entries, sh_link the string table */
+  for( i = 0; i < shdr.sh_info; i++ )
+  {
+    if ( shdr.sh_type == SHT_GNU_verdef )
+    {
+      if ( gelf_getverdef(data, offset, &verdef) == NULL )
+        break;
+      idx = verdef.vd_ndx & 0x7fff;
+      if ( idx > max )
+        max = idx;
+      if ( name_list != NULL && gelf_getverdaux(data, offset + verdef.vd_aux, &verdaux) != NULL )
+        name_list[idx] = elf_strptr(relf->elf, shdr.sh_link, verdaux.vda_name);
+      if ( verdef.vd_next == 0 )
+        break;
+      offset += verdef.vd_next;
+    }
+    else
+    {
+      if ( gelf_getverneed(data, offset, &verneed) == NULL )
+        break;
+      aux_offset = offset + verneed.vn_aux;
+      for( j = 0; j < verneed.vn_cnt; j++ )
+      {
+        if ( gelf_getvernaux(data, aux_offset, &vernaux) == NULL )
+          break;
+        idx = vernaux.vna_other & 0x7fff;
+        if ( idx > max )
+          max = idx;
+        if ( name_list != NULL )
+          name_list[idx] = elf_strptr(relf->elf, shdr.sh_link, vernaux.vna_name);
+        if ( vernaux.vna_next == 0 )
+          break;
+        aux_offset += vernaux.vna_next;
+      }
+      if ( verneed.vn_next == 0 )
+        break;
+      offset += verneed.vn_next;
+    }
+  }
+  return max;
+}
+
+/*
+  Decode ".gnu.version", ".gnu.version_d" and ".gnu.version_r" into the arrays 
+  symbol_version_list and symbol_version_name_list, which have one entry for each
+  symbol of the dynamic symbol table.
+  Returns 0 for out of memory. If there are no symbol versions, symbol_version_cnt is 0.
+*/
+int relf_init_symbol_versions(relf_struct *relf)
+{
+  Elf_Scn *scn = NULL;
+  Elf_Scn *versym_scn = NULL;
+  Elf_Scn *verdef_scn = NULL;
+  Elf_Scn *verneed_scn = NULL;
+  GElf_Shdr shdr;
+  Elf_Data *data;
+  const char **name_list;
+  size_t name_cnt;
+  size_t cnt, i, idx;
+  
+  while( (scn = elf_nextscn(relf->elf, scn)) != NULL )
+  {
+    if ( gelf_getshdr(scn, &shdr) != &shdr )
+      return 1;
+    if ( shdr.sh_type == SHT_GNU_versym )
+      versym_scn = scn;
+    else if ( shdr.sh_type == SHT_GNU_verdef )
+      verdef_scn = scn;
+    else if ( shdr.sh_type == SHT_GNU_verneed )
+      verneed_scn = scn;
+  }
+  if ( versym_scn == NULL || relf_is_scn_data_allowed(relf, versym_scn) == 0 || (data = elf_getdata(versym_scn, NULL)) == NULL )
+    return 1;
+  cnt = data->d_size / sizeof(GElf_Versym);    // ELF_T_HALF has the same size in the file and in memory
+  if ( cnt == 0 )
+    return 1;
+  
+  /* version names by version index */
+  name_cnt = relf_walk_version_section(relf, verdef_scn, NULL);
+  i = relf_walk_version_section(relf, verneed_scn, NULL);
+  if ( i > name_cnt )
+    name_cnt = i;
+  name_cnt++;
+  name_list = (const char **)calloc(name_cnt, sizeof(const char *));
+  if ( name_list == NULL )
+    return 0;
+  relf_walk_version_section(relf, verdef_scn, name_list);
+  relf_walk_version_section(relf, verneed_scn, name_list);
+  
+  /* version index and name by symbol index */
+  relf->symbol_version_list = (GElf_Versym *)malloc(cnt * sizeof(GElf_Versym));
+  relf->symbol_version_name_list = (const char **)calloc(cnt, sizeof(const char *));
+  if ( relf->symbol_version_list == NULL || relf->symbol_version_name_list == NULL )
+  {
+    free(name_list);
+    free(relf->symbol_version_list);
+    free(relf->symbol_version_name_list);
+    relf->symbol_version_list = NULL;
+    relf->symbol_version_name_list = NULL;
+    return 0;
+  }
+  for( i = 0; i < cnt; i++ )
+  {
+    if ( gelf_getversym(data, i, relf->symbol_version_list+i) == NULL )
+      relf->symbol_version_list[i] = 0;
+    idx = relf->symbol_version_list[i] & 0x7fff;      // bit 15 is the "hidden" flag
+    if ( idx > 1 && idx < name_cnt )                            // 0 and 1 are local and global symbols
+      relf->symbol_version_name_list[i] = name_list[idx];
+  }
+  relf->symbol_version_cnt = cnt;
+  free(name_list);
+  return 1;
+}
+
+/*==========================================*/
+/* Native Reader */
+
+/*
+  The gelf_get*() procedures check the elf class for each record and copy the record 
+  from the translated data of libelf. The native reader decodes the records directly from 
+  the mapped elf file. The decode procedures are generated for each combination 
+  of elf class (32/64 bit) and byte order (lsb/msb), so the offsets, sizes and the 
+  byte order of all members are known at compile time.
+*/
+
+#define RELF_LSB16(p) ((Elf32_Half)((Elf32_Half)(p)[0] | ((Elf32_Half)(p)[1] << 8)))
+#define RELF_LSB32(p) ((Elf32_Word)(p)[0] | ((Elf32_Word)(p)[1] << 8) | ((Elf32_Word)(p)[2] << 16) | ((Elf32_Word)(p)[3] << 24))
+#define RELF_LSB64(p) ((Elf64_Xword)RELF_LSB32(p) | ((Elf64_Xword)RELF_LSB32((p)+4) << 32))
+#define RELF_MSB16(p) ((Elf32_Half)((Elf32_Half)(p)[1] | ((Elf32_Half)(p)[0] << 8)))
+#define RELF_MSB32(p) ((Elf32_Word)(p)[3] | ((Elf32_Word)(p)[2] << 8) | ((Elf32_Word)(p)[1] << 16) | ((Elf32_Word)(p)[0] << 24))
+#define RELF_MSB64(p) ((Elf64_Xword)RELF_MSB32((p)+4) | ((Elf64_Xword)RELF_MSB32(p) << 32))
+
+/* Elf32_Sym, Elf32_Rela, Elf32_Rel and Elf32_Dyn, R16 and R32 read a value with the byte order of the elf file */
+#define RELF_NATIVE_32(suffix, R16, R32) \
+static void relf_get_sym_##suffix(const unsigned char *ptr, GElf_Sym *sym) \
+{ \
+  sym->st_name = R32(ptr); \
+  sym->st_value = R32(ptr+4); \
+  sym->st_size = R32(ptr+8); \
+  sym->st_info = ptr[12]; \
+  sym->st_other = ptr[13]; \
+  sym->st_shndx = R16(ptr+14); \
+} \
+static void relf_get_rela_##suffix(const unsigned char *ptr, GElf_Rela *rela) \
+{ \
+  Elf32_Word info = R32(ptr+4); \
+  rela->r_offset = R32(ptr); \
+  rela->r_info = GELF_R_INFO(ELF32_R_SYM(info), ELF32_R_TYPE(info)); \
+  rela->r_addend = (Elf32_Sword)R32(ptr+8); \
+} \
+static void relf_get_rel_##suffix(const unsigned char *ptr, GElf_Rela *rela) \
+{ \
+  Elf32_Word info = R32(ptr+4); \
+  rela->r_offset = R32(ptr); \
+  rela->r_info = GELF_R_INFO(ELF32_R_SYM(info), ELF32_R_TYPE(info)); \
+  rela->r_addend = 0; \
+} \
+static void relf_get_dyn_##suffix(const unsigned char *ptr, GElf_Dyn *dyn) \
+{ \
+  dyn->d_tag = (Elf32_Sword)R32(ptr); \
+  dyn->d_un.d_val = R32(ptr+4); \
+} \
+static const relf_native_struct relf_native_##suffix = \
+{ \
+  sizeof(Elf32_Sym), sizeof(Elf32_Rela), sizeof(Elf32_Rel), sizeof(Elf32_Dyn), \
+  relf_get_sym_##suffix, relf_get_rela_##suffix, relf_get_rel_##suffix, relf_get_dyn_##suffix \
+};
+
+/* Elf64_Sym, Elf64_Rela, Elf64_Rel and Elf64_Dyn */
+#define RELF_NATIVE_64(suffix, R16, R32, R64) \
+static void relf_get_sym_##suffix(const unsigned char *ptr, GElf_Sym *sym) \
+{ \
+  sym->st_name = R32(ptr); \
+  sym->st_info = ptr[4]; \
+  sym->st_other = ptr[5]; \
+  sym->st_shndx = R16(ptr+6); \
+  sym->st_value = R64(ptr+8); \
+  sym->st_size = R64(ptr+16); \
+} \
+static void relf_get_rela_##suffix(const unsigned char *ptr, GElf_Rela *rela) \
+{ \
+  rela->r_offset = R64(ptr); \
+  rela->r_info = R64(ptr+8); \
+  rela->r_addend = (Elf64_Sxword)R64(ptr+16); \
+} \
+static void relf_get_rel_##suffix(const unsigned char *ptr, GElf_Rela *rela) \
+{ \
+  rela->r_offset = R64(ptr); \
+  rela->r_info = R64(ptr+8); \
+  rela->r_addend = 0; \
+} \
+static void relf_get_dyn_##suffix(const unsigned char *ptr, GElf_Dyn *dyn) \
+{ \
+  dyn->d_tag = (Elf64_Sxword)R64(ptr); \
+  dyn->d_un.d_val = R64(ptr+8); \
+} \
+static const relf_native_struct relf_native_##suffix = \
+{ \
+  sizeof(Elf64_Sym), sizeof(Elf64_Rela), sizeof(Elf64_Rel), sizeof(Elf64_Dyn), \
+  relf_get_sym_##suffix, relf_get_rela_##suffix, relf_get_rel_##suffix, relf_get_dyn_##suffix \
+};
+
+RELF_NATIVE_32(32lsb, RELF_LSB16, RELF_LSB32)
+RELF_NATIVE_32(32msb, RELF_MSB16, RELF_MSB32)
+RELF_NATIVE_64(64lsb, RELF_LSB16, RELF_LSB32, RELF_LSB64)
+RELF_NATIVE_64(64msb, RELF_MSB16, RELF_MSB32, RELF_MSB64)
+
+/* returns the record decoder for the elf class and byte order of e_ident or NULL */
+const relf_native_struct *relf_get_native(const unsigned char *ident)
+{
+  if ( ident[EI_CLASS] == ELFCLASS32 && ident[EI_DATA] == ELFDATA2LSB )
+    return &relf_native_32lsb;
+  if ( ident[EI_CLASS] == ELFCLASS32 && ident[EI_DATA] == ELFDATA2MSB )
+    return &relf_native_32msb;
+  if ( ident[EI_CLASS] == ELFCLASS64 && ident[EI_DATA] == ELFDATA2LSB )
+    return &relf_native_64lsb;
+  if ( ident[EI_CLASS] == ELFCLASS64 && ident[EI_DATA] == ELFDATA2MSB )
+    return &relf_native_64msb;
+  return NULL;
+}
+
+/* 
+  Use the native reader for size bytes at offset within the section, if the records can be found in the mapped elf file.
+  records->type must be set. Returns 0 if the native reader can not be used.
+*/
+static int relf_set_native_records(relf_struct *relf, relf_records_struct *records, const GElf_Shdr *shdr, size_t offset, size_t size)
+{
+  const relf_native_struct *native = relf->native;
+  size_t record_size = 0;
+  
+  if ( native == NULL )
+    return 0;
+  switch(records->type)
+  {
+    case ELF_T_SYM: record_size = native->sym_size; break;
+    case ELF_T_RELA: record_size = native->rela_size; break;
+    case ELF_T_REL: record_size = native->rel_size; break;
+    case ELF_T_DYN: record_size = native->dyn_size; break;
+    default: return 0;
+  }
+  /* the file content must not be compressed and the record size must be the same in memory and in the file */
+  if ( shdr->sh_type == SHT_NOBITS || (shdr->sh_flags & SHF_COMPRESSED) != 0 )
+    return 0;
+  if ( offset > shdr->sh_size || size > shdr->sh_size - offset )
+    return 0;
+  if ( shdr->sh_offset > relf->map_size || shdr->sh_size > relf->map_size - shdr->sh_offset )
+    return 0;
+  if ( size % record_size != 0 )
+    return 0;
+  records->native = native;
+  records->ptr = relf->map + shdr->sh_offset + offset;
+  records->size = record_size;
+  records->cnt = size / record_size;
+  return 1;
+}
+
+/*
+  Prepare the access to the records of the data block "data" of section scn.
+  The native reader is used if the data block can be found in the mapped elf file,
+  otherwise the relf_get_*() procedures will use libelf.
+*/
+void relf_init_records(relf_struct *relf, relf_records_struct *records, Elf_Scn *scn, Elf_Data *data)
+{
+  GElf_Shdr shdr;
+  
+  memset(records, 0, sizeof(relf_records_struct));
+  records->data = data;
+  records->type = data->d_type;
+  if ( relf->native == NULL || gelf_getshdr( scn, &shdr ) != &shdr || data->d_off < 0 )
+    return;
+  relf_set_native_records(relf, records, &shdr, (size_t)data->d_off, data->d_size);
+}
+
+/*
+  Prepare the access to all records of a SHT_SYMTAB, SHT_DYNSYM, SHT_RELA, SHT_REL or SHT_DYNAMIC section
+  without elf_getdata(), so that libelf does not load the section data.
+  Without memory limit, the records are decoded directly from the mapped elf file.
+  With relf_max_memory, the records are read with relf_read() into a window of at most 
+  RELF_READ_CHUNK_SIZE and relf_max_memory bytes. The window is replaced if a record outside of the 
+  window is requested, so sequential access reads each record once.
+  Returns 0 if this is not possible (or the section is skipped), the caller must then use elf_getdata() and 
+  relf_init_records(), if relf_is_scn_data_allowed() is true.
+  relf_destroy_records() must be called for successfully initialized records.
+*/
+int relf_init_scn_records(relf_struct *relf, relf_records_struct *records, Elf_Scn *scn, const GElf_Shdr *shdr)
+{
+  size_t i = elf_ndxscn(scn);
+  size_t max;
+  
+  memset(records, 0, sizeof(relf_records_struct));
+  records->type = relf_get_scn_record_type(shdr);
+  if ( records->type == ELF_T_BYTE )
+    return 0;
+  if ( relf->is_scn_skipped_list == NULL )
+    return relf_set_native_records(relf, records, shdr, 0, shdr->sh_size);
+  
+  /* bounded mode: read the records in windows */
+  if ( i >= relf->section_header_total || relf->is_scn_skipped_list[i] != 0 )
+    return 0;
+  if ( shdr->sh_type == SHT_NOBITS || (shdr->sh_flags & SHF_COMPRESSED) != 0 )
+    return 0;
+  records->native = relf_get_native((const unsigned char *)elf_getident(relf->elf, NULL));
+  if ( records->native == NULL )
+    return 0;
+  switch(records->type)
+  {
+    case ELF_T_SYM: records->size = records->native->sym_size; break;
+    case ELF_T_RELA: records->size = records->native->rela_size; break;
+    case ELF_T_REL: records->size = records->native->rel_size; break;
+    default: records->size = records->native->dyn_size; break;
+  }
+  if ( shdr->sh_size % records->size != 0 )
+    return 0;
+  max = relf_max_memory < RELF_READ_CHUNK_SIZE ? relf_max_memory : RELF_READ_CHUNK_SIZE;
+  records->relf = relf;
+  records->file_offset = shdr->sh_offset;
+  records->cnt = shdr->sh_size / records->size;
+  records->window_cnt = max / records->size;
+  if ( records->window_cnt > records->cnt )
+    records->window_cnt = records->cnt;
+  if ( records->window_cnt == 0 )
+    return records->cnt == 0;
+  records->window = (unsigned char *)malloc(records->window_cnt * records->size);
+  if ( records->window == NULL )
+    return 0;
+  return 1;
+}
+
+/* free the window of the records */
+void relf_destroy_records(relf_records_struct *records)
+{
+  free(records->window);
+  records->window = NULL;
+  records->window_first = 0;
+  records->window_loaded_cnt = 0;
+}
+
+/* 
+  copy the records, so that another thread can use them, a window is not shared but allocated again, 
+  returns 0 if there is not enough memory. relf_destroy_records() must be called for the copy.
+*/
+int relf_copy_records(relf_records_struct *dest, const relf_records_struct *src)
+{
+  *dest = *src;
+  if ( src->window == NULL )
+    return 1;
+  dest->window_first = 0;
+  dest->window_loaded_cnt = 0;
+  dest->window = (unsigned char *)malloc(src->window_cnt * src->size);
+  return dest->window != NULL;
+}
+
+/* 
+  returns a pointer to record "index" of native records, with a window, the window is loaded if required.
+  returns NULL if the record is not available.
+*/
+static const unsigned char *relf_get_record_ptr(relf_records_struct *records, size_t index)
+{
+  if ( index >= records->cnt )
+    return NULL;
+  if ( records->window == NULL )
+    return records->ptr + index*records->size;
+  if ( index < records->window_first || index >= records->window_first + records->window_loaded_cnt )
+  {
+    records->window_first = index - index % records->window_cnt;
+    records->window_loaded_cnt = records->cnt - records->window_first;
+    if ( records->window_loaded_cnt > records->window_cnt )
+      records->window_loaded_cnt = records->window_cnt;
+    if ( relf_read(records->relf, records->window, records->window_loaded_cnt*records->size, 
+          records->file_offset + records->window_first*records->size) == 0 )
+    {
+      records->window_loaded_cnt = 0;
+      return NULL;
+    }
+  }
+  return records->window + (index - records->window_first)*records->size;
+}
+
+/* 
+  returns the name of symbol sym_idx of the symbol table with section index scn_idx or NULL,
+  same as get_symbol_name(), but the symbol is decoded from the elf file if possible
+*/
+const char *relf_get_symbol_name(relf_struct *relf, size_t scn_idx, size_t sym_idx)
+{
+  Elf_Scn *scn = elf_getscn(relf->elf, scn_idx);
+  GElf_Shdr shdr;
+  GElf_Sym symbol;
+  relf_records_struct records;
+  const unsigned char *ptr;
+  unsigned char buf[sizeof(Elf64_Sym)];
+  
+  if ( scn == NULL || gelf_getshdr( scn, &shdr ) != &shdr )
+    return NULL;
+  if ( relf->is_scn_skipped_list == NULL )
+  {
+    if ( relf_init_scn_records(relf, &records, scn, &shdr) == 0 || records.type != ELF_T_SYM )
+      return get_symbol_name(relf->elf, scn_idx, (int)sym_idx);
+    if ( relf_get_sym(&records, sym_idx, &symbol) == NULL )
+      return NULL;
+    return elf_strptr(relf->elf, shdr.sh_link, symbol.st_name);
+  }
+  
+  /* bounded mode: read only the requested symbol, don't allocate a window for each name */
+  if ( shdr.sh_type != SHT_SYMTAB && shdr.sh_type != SHT_DYNSYM )
+    return NULL;
+  if ( scn_idx >= relf->section_header_total || relf->is_scn_skipped_list[scn_idx] != 0 )
+    return NULL;
+  if ( (shdr.sh_flags & SHF_COMPRESSED) != 0 )
+    return NULL;
+  records.native = relf_get_native((const unsigned char *)elf_getident(relf->elf, NULL));
+  if ( records.native == NULL || sym_idx >= shdr.sh_size / records.native->sym_size )
+    return NULL;
+  ptr = buf;
+  if ( relf_read(relf, buf, records.native->sym_size, shdr.sh_offset + sym_idx*records.native->sym_size) == 0 )
+    return NULL;
+  records.native->get_sym(ptr, &symbol);
+  return elf_strptr(relf->elf, shdr.sh_link, symbol.st_name);
+}
+
+const GElf_Sym *relf_get_sym(relf_records_struct *records, size_t index, GElf_Sym *sym)
+{
+  const unsigned char *ptr;
+  if ( records->native == NULL )
+    return gelf_getsym(records->data, (int)index, sym);
+  if ( (ptr = relf_get_record_ptr(records, index)) == NULL )
+    return NULL;
+  records->native->get_sym(ptr, sym);
+  return sym;
+}
+
+const GElf_Rela *relf_get_rela(relf_records_struct *records, size_t index, GElf_Rela *rela)
+{
+  GElf_Rel rel;
+  const unsigned char *ptr;
+  if ( records->native == NULL )
+  {
+    if ( records->type == ELF_T_RELA )
+      return gelf_getrela(records->data, (int)index, rela);
+    if ( gelf_getrel(records->data, (int)index, &rel) == NULL )
+      return NULL;
+    rela->r_offset = rel.r_offset;
+    rela->r_info = rel.r_info;
+    rela->r_addend = 0;
+    return rela;
+  }
+  if ( (ptr = relf_get_record_ptr(records, index)) == NULL )
+    return NULL;
+  if ( records->type == ELF_T_RELA )
+    records->native->get_rela(ptr, rela);
+  else
+    records->native->get_rel(ptr, rela);
+  return rela;
+}
+
+const GElf_Dyn *relf_get_dyn(relf_records_struct *records, size_t index, GElf_Dyn *dyn)
+{
+  const unsigned char *ptr;
+  if ( records->native == NULL )
+    return gelf_getdyn(records->data, (int)index, dyn);
+  if ( (ptr = relf_get_record_ptr(records, index)) == NULL )
+    return NULL;
+  records->native->get_dyn(ptr, dyn);
+  return dyn;
+}
+
+/*==========================================*/
+/* Raw File Access */
+
+/* read size bytes at the given offset of a file, returns 0 if the bytes are not available */
+int relf_pread(int fd, void *buf, size_t size, size_t offset)
+{
+  ssize_t cnt;
+  
+  while( size > 0 )
+  {
+#if defined(__MINGW32__) || defined(__MINGW64__)
+    if ( lseek(fd, (off_t)offset, SEEK_SET) < 0 )
+      return 0;
+    cnt = read(fd, buf, size);
+#else
+    cnt = pread(fd, buf, size, (off_t)offset);
+#endif
+    if ( cnt <= 0 )
+      return 0;
+    buf = (char *)buf + cnt;
+    size -= cnt;
+    offset += cnt;
+  }
+  return 1;
+}
+
+/* 
+  read size bytes at the given file offset of the elf file (without libelf), 
+  returns 0 if the bytes are not available 
+*/
+int relf_read(relf_struct *relf, void *buf, size_t size, size_t offset)
+{
+  if ( relf->fd < 0 )
+  {
+    if ( offset > relf->image_size || size > relf->image_size - offset )
+      return 0;
+    memcpy(buf, relf->image + offset, size);
+    return 1;
+  }
+  return relf_pread(relf->fd, buf, size, offset);
+}
+
+/* same as relf_read(), but returns a malloc'd buffer or NULL */
+unsigned char *relf_read_alloc(relf_struct *relf, size_t size, size_t offset)
+{
+  unsigned char *buf = (unsigned char *)malloc(size > 0 ? size : 1);
+  if ( buf == NULL )
+    return NULL;
+  if ( relf_read(relf, buf, size, offset) == 0 )
+    return free(buf), NULL;
+  return buf;
+}
+
+/*
+  Calculate the crc32 of size bytes at the given file offset.
+  The bytes are read in chunks of RELF_READ_CHUNK_SIZE. All reads except the first 
+  one start at a multiple of RELF_READ_CHUNK_SIZE, so that huge files (core dumps) 
+  can be processed without loading them into memory.
+  Returns 0 if the bytes are not available.
+*/
+int relf_get_file_crc(relf_struct *relf, size_t size, size_t offset, unsigned long *crc)
+{
+  unsigned char *buf;
+  size_t len;
+  
+  *crc = 0;
+  if ( relf->fd < 0 )
+  {
+    if ( offset > relf->image_size || size > relf->image_size - offset )
+      return 0;
+    *crc = update_crc(0, (unsigned char *)relf->image + offset, size);
+    return 1;
+  }
+  
+  /* a chunk is never larger than size */
+  buf = (unsigned char *)malloc(size < RELF_READ_CHUNK_SIZE ? (size > 0 ? size : 1) : RELF_READ_CHUNK_SIZE);
+  if ( buf == NULL )
+    return fprintf(stderr, "relf_get_file_crc: out of memory\n"), 0;
+#if defined(POSIX_FADV_SEQUENTIAL)
+  posix_fadvise(relf->fd, (off_t)offset, (off_t)size, POSIX_FADV_SEQUENTIAL);
+#endif
+  while( size > 0 )
+  {
+    len = RELF_READ_CHUNK_SIZE - offset % RELF_READ_CHUNK_SIZE;
+    if ( len > size )
+      len = size;
+    if ( relf_read(relf, buf, len, offset) == 0 )
+      return free(buf), 0;
+    *crc = update_crc(*crc, buf, len);
+    size -= len;
+    offset += len;
+  }
+  free(buf);
+  return 1;
+}
+
+/*==========================================*/
+/* Notes */
+
+/* read an unsigned value with size bytes (1, 2, 4 or 8) */
+unsigned long long relf_get_word(const unsigned char *ptr, size_t size, int is_msb)
+{
+  unsigned long long v = 0;
+  size_t i;
+  for( i = 0; i < size; i++ )
+  {
+    if ( is_msb )
+      v = (v << 8) | ptr[i];
+    else
+      v |= (unsigned long long)ptr[i] << (8*i);
+  }
+  return v;
+}
+
+/*
+  Decode the note at position offset within a SHT_NOTE section or PT_NOTE segment.
+  align is 4 or 8 (sh_addralign/p_align), is_msb is 1 for ELFDATA2MSB.
+  Returns the offset of the next note or 0 if there is no (valid) note at offset.
+*/
+size_t relf_get_note(const unsigned char *ptr, size_t size, size_t offset, size_t align, int is_msb, relf_note_struct *note)
+{
+  size_t pos;
+  
+  if ( align != 8 )
+    align = 4;
+  if ( offset > size || size - offset < 12 )
+    return 0;
+  note->namesz = relf_get_word(ptr+offset, 4, is_msb);
+  note->descsz = relf_get_word(ptr+offset+4, 4, is_msb);
+  note->n_type = relf_get_word(ptr+offset+8, 4, is_msb);
+  pos = offset + 12;
+  if ( note->namesz > size - pos )
+    return 0;
+  note->name = (const char *)ptr + pos;
+  pos += (note->namesz + 3) & ~(size_t)3;       // the name is always aligned to 4 bytes
+  pos = (pos + align - 1) & ~(align - 1);
+  if ( pos > size || note->descsz > size - pos )
+    return 0;
+  note->desc = ptr + pos;
+  pos += note->descsz;
+  pos = (pos + align - 1) & ~(align - 1);
+  if ( pos > size )
+    pos = size;
+  return pos;
+}
+
+/* returns 1 if the owner of the note is name, for example "CORE" or "GNU" */
+int relf_is_note_name(const relf_note_struct *note, const char *name)
+{
+  size_t len = strlen(name);
+  if ( note->namesz != len+1 && note->namesz != len )
+    return 0;
+  return memcmp(note->name, name, len) == 0;
+}
+
+/*==========================================*/
+/* Build-ID */
+
+/*
+  Search for the NT_GNU_BUILD_ID note in the notes of a SHT_NOTE section or PT_NOTE segment.
+  Returns the size of the build-id or 0 if not found.
+*/
+size_t relf_find_build_id(const unsigned char *ptr, size_t size, size_t align, int is_msb, unsigned char *build_id, size_t max)
+{
+  relf_note_struct note;
+  size_t offset = 0;
+  
+  while( (offset = relf_get_note(ptr, size, offset, align, is_msb, &note)) != 0 )
+  {
+    if ( note.n_type == NT_GNU_BUILD_ID && relf_is_note_name(&note, "GNU") && note.descsz > 0 )
+    {
+      if ( note.descsz > max )
+        return 0;
+      memcpy(build_id, note.desc, note.descsz);
+      return note.descsz;
+    }
+  }
+  return 0;
+}
+
+/* read the notes at the given file offset and search for the build-id */
+size_t relf_read_build_id(int fd, size_t size, size_t offset, size_t align, int is_msb, unsigned char *build_id, size_t max)
+{
+  unsigned char *buf;
+  size_t len = 0;
+  
+  if ( size == 0 || size > RELF_READ_CHUNK_SIZE )
+    return 0;
+  buf = (unsigned char *)malloc(size);
+  if ( buf == NULL )
+    return 0;
+  if ( relf_pread(fd, buf, size, offset) != 0 )
+    len = relf_find_build_id(buf, size, align, is_msb, build_id, max);
+  free(buf);
+  return len;
+}
+
+/*
+  Fast path to get the build-id of an elf file without libelf.
+  Only the elf header, the program headers and the PT_NOTE segments are read. 
+  If there is no build-id in the PT_NOTE segments (for example relocatable files without 
+  program headers), then the section headers and the SHT_NOTE sections are read.
+  build_id must have space for max (RELF_BUILD_ID_MAX) bytes.
+  Returns the size of the build-id or 0 if the elf file doesn't have a build-id.
+*/
+size_t relf_get_build_id(int fd, unsigned char *build_id, size_t max)
+{
+  unsigned char ehdr[64];       // Elf64_Ehdr
+  unsigned char shdr0[64];      // Elf64_Shdr
+  unsigned char *tab;
+  const unsigned char *h;
+  int is_64, is_msb;
+  size_t phoff, phentsize, phnum;
+  size_t shoff, shentsize, shnum;
+  size_t i;
+  size_t len = 0;
+  
+  if ( relf_pread(fd, ehdr, 52, 0) == 0 )       // 52 = sizeof(Elf32_Ehdr)
+    return 0;
+  if ( memcmp(ehdr, ELFMAG, SELFMAG) != 0 )
+    return 0;
+  if ( ehdr[EI_CLASS] != ELFCLASS32 && ehdr[EI_CLASS] != ELFCLASS64 )
+    return 0;
+  is_64 = ehdr[EI_CLASS] == ELFCLASS64;
+  is_msb = ehdr[EI_DATA] == ELFDATA2MSB;
+  if ( is_64 && relf_pread(fd, ehdr, 64, 0) == 0 )
+    return 0;
+  
+  phoff = relf_get_word(ehdr + (is_64 ? 32 : 28), is_64 ? 8 : 4, is_msb);
+  shoff = relf_get_word(ehdr + (is_64 ? 40 : 32), is_64 ? 8 : 4, is_msb);
+  phentsize = relf_get_word(ehdr + (is_64 ? 54 : 42), 2, is_msb);
+  phnum = relf_get_word(ehdr + (is_64 ? 56 : 44), 2, is_msb);
+  shentsize = relf_get_word(ehdr + (is_64 ? 58 : 46), 2, is_msb);
+  shnum = relf_get_word(ehdr + (is_64 ? 60 : 48), 2, is_msb);
+  
+  /* extended numbering: the real values are stored in the first section header */
+  if ( (phnum == PN_XNUM || shnum == 0) && shoff != 0 && shentsize >= (is_64 ? 64 : 40) )
+  {
+    if ( relf_pread(fd, shdr0, is_64 ? 64 : 40, shoff) == 0 )
+      return 0;
+    if ( phnum == PN_XNUM )
+      phnum = relf_get_word(shdr0 + (is_64 ? 44 : 28), 4, is_msb);
+    if ( shnum == 0 )
+      shnum = relf_get_word(shdr0 + (is_64 ? 32 : 20), is_64 ? 8 : 4, is_msb);
+  }
+  
+  /* program headers: Elf64_Phdr or Elf32_Phdr */
+  if ( phoff != 0 && phnum > 0 && phentsize >= (is_64 ? 56 : 32) && phnum*phentsize <= RELF_READ_CHUNK_SIZE )
+  {
+    tab = (unsigned char *)malloc(phnum*phentsize);
+    if ( tab == NULL )
+      return 0;
+    if ( relf_pread(fd, tab, phnum*phentsize, phoff) != 0 )
+    {
+      for( i = 0; i < phnum && len == 0; i++ )
+      {
+        h = tab + i*phentsize;
+        if ( relf_get_word(h, 4, is_msb) != PT_NOTE )
+          continue;
+        if ( is_64 )
+          len = relf_read_build_id(fd, relf_get_word(h+32, 8, is_msb), relf_get_word(h+8, 8, is_msb), relf_get_word(h+48, 8, is_msb), is_msb, build_id, max);
+        else
+          len = relf_read_build_id(fd, relf_get_word(h+16, 4, is_msb), relf_get_word(h+4, 4, is_msb), relf_get_word(h+28, 4, is_msb), is_msb, build_id, max);
+      }
+    }
+    free(tab);
+    if ( len > 0 )
+      return len;
+  }
+  
+  /* section headers: Elf64_Shdr or Elf32_Shdr, only used if there is no build-id in the PT_NOTE segments */
+  if ( shoff != 0 && shnum > 0 && shentsize >= (is_64 ? 64 : 40) && shnum*shentsize <= RELF_READ_CHUNK_SIZE )
+  {
+    tab = (unsigned char *)malloc(shnum*shentsize);
+    if ( tab == NULL )
+      return 0;
+    if ( relf_pread(fd, tab, shnum*shentsize, shoff) != 0 )
+    {
+      for( i = 1; i < shnum && len == 0; i++ )
+      {
+        h = tab + i*shentsize;
+        if ( relf_get_word(h+4, 4, is_msb) != SHT_NOTE )
+          continue;
+        if ( is_64 )
+          len = relf_read_build_id(fd, relf_get_word(h+32, 8, is_msb), relf_get_word(h+24, 8, is_msb), relf_get_word(h+48, 8, is_msb), is_msb, build_id, max);
+        else
+          len = relf_read_build_id(fd, relf_get_word(h+20, 4, is_msb), relf_get_word(h+16, 4, is_msb), relf_get_word(h+32, 4, is_msb), is_msb, build_id, max);
+      }
+    }
+    free(tab);
+  }
+  return len;
+}
+
+/*==========================================*/
+/* Visitor */
+
+int relf_visit_records(relf_struct *relf, relf_visitor_struct *visitor, void *user, Elf_Scn *scn, GElf_Shdr *shdr, relf_records_struct *records)
+{
+  int i = 0;
+  GElf_Sym symbol;
+  GElf_Dyn dynamic;
+  GElf_Rela rela;
+  const char *name;
+  
+  switch(records->type)
+  {
+    case ELF_T_SYM:             // used by SHT_SYMTAB, SHT_DYNSYM
+      if ( visitor->symbol == NULL )
+        break;
+      while( relf_get_sym(records, i, &symbol) != NULL )
+      {
+        name = elf_strptr(relf->elf, shdr->sh_link, symbol.st_name );
+        if ( name == NULL )
+          return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
+        if ( visitor->symbol(user, relf, scn, i, &symbol, name) == 0 )
+          return 0;
+        i++;
+      }
+      break;
+    case ELF_T_DYN:             // used by SHT_DYNAMIC
+      if ( visitor->dynamic == NULL )
+        break;
+      while( relf_get_dyn(records, i, &dynamic) != NULL )
+      {
+        name = NULL;
+        if ( dynamic.d_tag == DT_NEEDED )
+          name = elf_strptr(relf->elf, relf->dynstr_section_index, dynamic.d_un.d_val );
+        if ( visitor->dynamic(user, relf, scn, i, &dynamic, name) == 0 )
+          return 0;
+        i++;
+      }
+      break;
+    case ELF_T_RELA:
+    case ELF_T_REL:             // r_addend is 0
+      if ( visitor->relocation == NULL )
+        break;
+      while( relf_get_rela(records, i, &rela) != NULL )
+      {
+        name = NULL;
+        if ( shdr->sh_link > 0 )
+          name = relf_get_symbol_name(relf, shdr->sh_link, GELF_R_SYM(rela.r_info));
+        if ( visitor->relocation(user, relf, scn, i, &rela, name) == 0 )
+          return 0;
+        i++;
+      }
+      break;
+    default:
+      break;
+  }
+  return 1;
+}
+
+/* 
+  Call the procedures of the visitor for the elf header, all program headers, 
+  all sections and the records of symbol, dynamic and relocation sections.
+  Returns 0 if a callback returns 0 or if there is an error.
+*/
+int relf_visit(relf_struct *relf, relf_visitor_struct *visitor, void *user)
+{
+  size_t i;
+  GElf_Phdr phdr;
+  Elf_Scn  *scn;
+  GElf_Shdr shdr;
+  Elf_Data *data;
+  long long unsigned data_cnt;
+  const char *section_name;
+  relf_records_struct records;
+  int is_ok;
+  
+  if ( visitor->elf_header != NULL )
+    if ( visitor->elf_header(user, relf, &(relf->elf_file_header)) == 0 )
+      return 0;
+  
+  if ( visitor->program_header != NULL )
+  {
+    for( i = 0; i < relf->program_header_total; i++ )
+    {
+      if ( gelf_getphdr(relf->elf, i, &phdr) == NULL )
+        return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
+      if ( visitor->program_header(user, relf, i, &phdr) == 0 )
+        return 0;
+    }
+  }
+
+  if ( visitor->section == NULL && visitor->symbol == NULL && visitor->dynamic == NULL && visitor->relocation == NULL )
+    return 1;
+  
+  scn = elf_nextscn(relf->elf, NULL);
+  while ( scn != NULL ) 
+  {
+    if ( gelf_getshdr( scn, &shdr ) != &shdr )
+      return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
+    if ( visitor->section != NULL )
+    {
+      section_name = elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name );
+      if ( section_name == NULL )
+        return fprintf(stderr, "libelf: %s\n", elf_errmsg(-1)), 0;
+      if ( visitor->section(user, relf, scn, &shdr, section_name) == 0 )
+        return 0;
+    }
+    
+    if ( shdr.sh_type == SHT_SYMTAB || shdr.sh_type == SHT_DYNSYM || shdr.sh_type == SHT_DYNAMIC || shdr.sh_type == SHT_RELA || shdr.sh_type == SHT_REL )
+    {
+      if ( relf_init_scn_records(relf, &records, scn, &shdr) )
+      {
+        is_ok = relf_visit_records(relf, visitor, user, scn, &shdr, &records);
+        relf_destroy_records(&records);
+        if ( is_ok == 0 )
+          return 0;
+      }
+      else if ( relf_is_scn_data_allowed(relf, scn) )
+      {
+        /* the records are not available in the mapped file, use the data blocks from libelf */
+        data_cnt = 0;
+        data = NULL;
+        for(;;)
+        {
+          if ( data_cnt >= shdr.sh_size )
+            break;
+          data = elf_getdata(scn , data);
+          if ( data == NULL )
+            break;
+          relf_init_records(relf, &records, scn, data);
+          if ( relf_visit_records(relf, visitor, user, scn, &shdr, &records) == 0 )
+            return 0;
+          data_cnt += data->d_size;
+        }
+      }
+    }
+    scn = elf_nextscn(relf->elf, scn);
+  }
+  return 1;
+}
@@ -0,0 +1,229 @@
+/*
+
+  relf.h
+
+
+  Copyright (C) 2024  olikraus@gmail.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  libelf2json: Read-only ELF wrapper for the gelf/elf library
+
+  All procedures return 0 in case of an error (or NULL for pointers).
+  An error message is written to stderr.
+  
+  Visitor API:
+    relf_visit() walks through the elf file and calls the procedures of a
+    relf_visitor_struct for each decoded record. Members of relf_visitor_struct 
+    may be NULL. Each callback gets the "user" pointer, which was passed to relf_visit().
+    If a callback returns 0, then relf_visit() stops and returns 0.
+    Pointers passed to the callbacks are only valid during the call, 
+    except for strings, which are valid until relf_destroy() is called.
+
+  Example:
+    int my_symbol(void *user, relf_struct *relf, Elf_Scn *scn, size_t index, const GElf_Sym *sym, const char *name)
+    {
+      printf("%s\n", name);
+      return 1;
+    }
+    ...
+    relf_struct relf;
+    relf_visitor_struct visitor = { 0 };
+    visitor.symbol = my_symbol;
+    if ( relf_init(&relf, "a.out") )
+    {
+      relf_visit(&relf, &visitor, NULL);
+      relf_destroy(&relf);
+    }
+
+*/
+
+#ifndef _RELF_H
+#define _RELF_H
+
+#include <stddef.h>
+#include <libelf.h>
+#include <gelf.h>
+
+/*
+  Record decoder for one elf class and byte order, see relf_init_records().
+  The procedures convert one record of the elf file into the corresponding GElf struct.
+*/
+typedef struct _relf_native_struct relf_native_struct;
+struct _relf_native_struct
+{
+  size_t sym_size;              // size of one record in the elf file
+  size_t rela_size;
+  size_t rel_size;
+  size_t dyn_size;
+  void (*get_sym)(const unsigned char *ptr, GElf_Sym *sym);
+  void (*get_rela)(const unsigned char *ptr, GElf_Rela *rela);
+  void (*get_rel)(const unsigned char *ptr, GElf_Rela *rela);   // r_addend is 0
+  void (*get_dyn)(const unsigned char *ptr, GElf_Dyn *dyn);
+};
+
+/* read only elf */
+struct _relf_struct
+{
+  int fd;                                       // -1 if the elf file is in memory
+  Elf *elf;                                     // elf object, returned from elf_begin or elf_memory
+  char *image;                                  // memory of the elf file for relf_init_memory(), NULL otherwise
+  size_t image_size;
+  int is_image_owned;                           // image will be freed by relf_destroy() (used for stdin)
+  size_t file_size;                             // size of the elf file in bytes
+  const unsigned char *map;             // content of the elf file (mmap or image), NULL if not available
+  size_t map_size;
+  int is_map_owned;                     // map will be removed by relf_destroy()
+  const relf_native_struct *native;     // record decoder for the class and byte order of the elf file, NULL if map is not available
+  
+  size_t section_header_total;               // shdrnum, total number of section headers (each section has a section header, so this is the same as the total number of sectios)
+  size_t section_header_string_table_index;  // shdrstrndx, the index of the section where we find the strings for the the section header names;
+  size_t program_header_total;               // phdrnum, total number of program headers
+  
+  GElf_Ehdr elf_file_header;                    // ehdr elf file header
+  GElf_Shdr section_header;                     // shdr section header
+  
+  size_t symtab_section_index;             // section header index of the ".symtab" section, 0 if not found
+  size_t strtab_section_index;               // section header index of the ".strtab" section, this contains the strings for the symbols from .symtab, 0 if not found
+  size_t dynsym_section_index;          // section header index of the ".dynsym" section, 0 if not found
+  size_t dynstr_section_index;          // section header index of the ".dynstr" section, 0 if not found
+  
+  size_t symbol_version_cnt;            // number of entries in the symbol version lists, 0 if there is no ".gnu.version" section
+  GElf_Versym *symbol_version_list;     // version index for each symbol of ".dynsym" (from ".gnu.version"), bit 15 is the hidden flag
+  const char **symbol_version_name_list;        // version name for each symbol of ".dynsym", NULL for local and global symbols
+  
+  unsigned char *is_scn_skipped_list;   // with relf_max_memory: reason (not 0) for each section index, which is not read, see relf_init_memory_budget()
+  size_t skipped_scn_cnt;               // number of sections with is_scn_skipped_list[i] != 0
+  
+  
+};
+typedef struct _relf_struct relf_struct;
+
+
+/* one note of a SHT_NOTE section or PT_NOTE segment, see relf_get_note() */
+typedef struct _relf_note_struct relf_note_struct;
+struct _relf_note_struct
+{
+  size_t n_type;
+  const char *name;             // owner of the note, namesz bytes, usually '\0' terminated
+  size_t namesz;
+  const unsigned char *desc;    // descsz bytes of the note, the content depends on name and n_type
+  size_t descsz;
+};
+
+/* max size of the build-id, which is accepted by relf_get_build_id() */
+#define RELF_BUILD_ID_MAX 64
+
+/* chunk size for reading large parts of the elf file, see relf_get_file_crc() */
+#define RELF_READ_CHUNK_SIZE (1024*1024)
+
+/*
+  Records (symbols, relocations or dynamic entries) of one data block, see relf_init_records(),
+  or of a complete section, see relf_init_scn_records().
+  The records are decoded directly from the mapped elf file or, with relf_max_memory, from a window,
+  which is read from the elf file. If this is not possible, then the gelf_get*() procedures are used.
+*/
+typedef struct _relf_records_struct relf_records_struct;
+struct _relf_records_struct
+{
+  const relf_native_struct *native;     // NULL: use gelf_get*() with data
+  Elf_Data *data;
+  Elf_Type type;
+  const unsigned char *ptr;             // first record within the mapped elf file
+  size_t size;                          // size of one record
+  size_t cnt;                           // number of records
+  relf_struct *relf;                    // elf file for the window, NULL without window
+  size_t file_offset;                   // file offset of the first record
+  unsigned char *window;                // records window_first ... window_first+window_loaded_cnt-1, NULL: use ptr
+  size_t window_cnt;                    // max number of records in the window
+  size_t window_first;
+  size_t window_loaded_cnt;
+};
+
+typedef struct _relf_visitor_struct relf_visitor_struct;
+struct _relf_visitor_struct
+{
+  int (*elf_header)(void *user, relf_struct *relf, const GElf_Ehdr *ehdr);
+  int (*program_header)(void *user, relf_struct *relf, size_t index, const GElf_Phdr *phdr);
+  int (*section)(void *user, relf_struct *relf, Elf_Scn *scn, const GElf_Shdr *shdr, const char *name);
+  /* symbols of SHT_SYMTAB and SHT_DYNSYM sections, index is the symbol index within the section */
+  int (*symbol)(void *user, relf_struct *relf, Elf_Scn *scn, size_t index, const GElf_Sym *sym, const char *name);
+  /* entries of the SHT_DYNAMIC section, lib_name is not NULL for DT_NEEDED */
+  int (*dynamic)(void *user, relf_struct *relf, Elf_Scn *scn, size_t index, const GElf_Dyn *dyn, const char *lib_name);
+  /* entries of SHT_RELA and SHT_REL sections, r_addend is 0 for SHT_REL, symbol_name might be NULL */
+  int (*relocation)(void *user, relf_struct *relf, Elf_Scn *scn, size_t index, const GElf_Rela *rela, const char *symbol_name);
+};
+
+
+/* crc32 */
+extern int is_crc_table_computed;
+void compute_crc_table(void);
+unsigned long update_crc(unsigned long crc, unsigned char *buf, size_t len);
+unsigned long get_crc(unsigned char *buf, size_t len);
+
+/* 64 bit hash for change detection */
+unsigned long long relf_hash64(unsigned long long h, const void *ptr, size_t len);
+
+/* elf helper procedures */
+Elf_Scn  *get_section_by_address(Elf * e, Elf64_Addr *addr);
+const GElf_Sym *get_symbol(Elf *elf, size_t scn_idx, int sym_idx, GElf_Sym *symbol);
+const char *get_symbol_name(Elf *elf, size_t scn_idx, int sym_idx);
+
+/* read only elf */
+int relf_init(relf_struct *relf, const char *elf_filename);    // elf_filename "-" reads the elf file from stdin
+int relf_init_memory(relf_struct *relf, char *image, size_t image_size);
+char *relf_read_fd(int fd, size_t *size);
+void relf_destroy(relf_struct *relf);
+int relf_init_symbol_versions(relf_struct *relf);     // called by relf_init(), fills the symbol version lists
+Elf_Scn *relf_find_scn_by_name(relf_struct *relf, const char *name);
+size_t relf_find_section_index_by_name(relf_struct *relf, const char *name);
+void *relf_get_mem_ptr(relf_struct *relf, size_t section_index, size_t addr);
+size_t relf_get_file_offset(relf_struct *relf, size_t section_index, size_t addr);      // 0 if not available
+
+/* memory budget */
+extern size_t relf_max_memory;          // max number of bytes for the section data of one elf file, 0: no limit
+int relf_init_memory_budget(relf_struct *relf);        // called by relf_init(), fills is_scn_skipped_list
+int relf_is_scn_data_allowed(relf_struct *relf, Elf_Scn *scn);
+const char *relf_get_scn_skip_reason(relf_struct *relf, size_t index);     // NULL if the section is not skipped
+
+/* native reader */
+const relf_native_struct *relf_get_native(const unsigned char *ident);      // ident: e_ident of the elf file
+void relf_init_records(relf_struct *relf, relf_records_struct *records, Elf_Scn *scn, Elf_Data *data);
+int relf_init_scn_records(relf_struct *relf, relf_records_struct *records, Elf_Scn *scn, const GElf_Shdr *shdr);   // without elf_getdata()
+void relf_destroy_records(relf_records_struct *records);
+int relf_copy_records(relf_records_struct *dest, const relf_records_struct *src);     // for other threads
+const GElf_Sym *relf_get_sym(relf_records_struct *records, size_t index, GElf_Sym *sym);
+const GElf_Rela *relf_get_rela(relf_records_struct *records, size_t index, GElf_Rela *rela);      // ELF_T_RELA and ELF_T_REL
+const GElf_Dyn *relf_get_dyn(relf_records_struct *records, size_t index, GElf_Dyn *dyn);
+const char *relf_get_symbol_name(relf_struct *relf, size_t scn_idx, size_t sym_idx);     // like get_symbol_name()
+
+/* raw file access */
+int relf_pread(int fd, void *buf, size_t size, size_t offset);
+int relf_read(relf_struct *relf, void *buf, size_t size, size_t offset);
+unsigned char *relf_read_alloc(relf_struct *relf, size_t size, size_t offset);
+int relf_get_file_crc(relf_struct *relf, size_t size, size_t offset, unsigned long *crc);
+
+/* notes */
+unsigned long long relf_get_word(const unsigned char *ptr, size_t size, int is_msb);
+size_t relf_get_note(const unsigned char *ptr, size_t size, size_t offset, size_t align, int is_msb, relf_note_struct *note);
+int relf_is_note_name(const relf_note_struct *note, const char *name);
+
+/* build-id */
+size_t relf_find_build_id(const unsigned char *ptr, size_t size, size_t align, int is_msb, unsigned char *build_id, size_t max);
+size_t relf_get_build_id(int fd, unsigned char *build_id, size_t max);    // fast path, doesn't require libelf
+
+/* visitor */
+int relf_visit(relf_struct *relf, relf_visitor_struct *visitor, void *user);
+
+#endif /* _RELF_H */
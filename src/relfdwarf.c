@@ -0,0 +1,283 @@
+/*
+
+  relfdwarf.c
+
+
+  Copyright (C) 2024  olikraus@gmail.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  Compile unit names for addresses, see relfdwarf.h
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libdwarf/dwarf.h>
+#include <libdwarf/libdwarf.h>
+#include "relfdwarf.h"
+
+int relf_cmp_arange(const void *a, const void *b)
+{
+  const relf_arange_struct *x = (const relf_arange_struct *)a;
+  const relf_arange_struct *y = (const relf_arange_struct *)b;
+  if ( x->addr != y->addr )
+    return x->addr < y->addr ? -1 : 1;
+  return 0;
+}
+
+/*==========================================*/
+/* libdwarf object access: the sections are read with libelf from relf_struct */
+
+/* section header of section_index, compressed debug sections are uncompressed, so that libdwarf gets the final size */
+int relf_dwarf_get_section_info(void *obj, Dwarf_Unsigned section_index, Dwarf_Obj_Access_Section_a *section, int *error)
+{
+  relf_struct *relf = (relf_struct *)obj;
+  Elf_Scn *scn = elf_getscn(relf->elf, (size_t)section_index);
+  GElf_Shdr shdr;
+  const char *name;
+  
+  memset(section, 0, sizeof(Dwarf_Obj_Access_Section_a));
+  if ( scn == NULL || gelf_getshdr(scn, &shdr) != &shdr )
+    return *error = DW_DLE_SECTION_INDEX_BAD, DW_DLV_ERROR;
+  name = elf_strptr(relf->elf, relf->section_header_string_table_index, shdr.sh_name);
+  section->as_name = name != NULL ? name : "";
+  if ( strncmp(section->as_name, ".debug_", 7) == 0 )
+  {
+    if ( relf_is_scn_data_allowed(relf, scn) == 0 )
+      return DW_DLV_OK;         // not read because of the memory budget, size 0 hides the section from libdwarf
+    if ( (shdr.sh_flags & SHF_COMPRESSED) != 0 && elf_compress(scn, 0, 0) >= 0 && gelf_getshdr(scn, &shdr) != &shdr )
+      return *error = DW_DLE_ELF_SECT_ERR, DW_DLV_ERROR;
+  }
+  section->as_type = shdr.sh_type;
+  section->as_flags = shdr.sh_flags;
+  section->as_addr = shdr.sh_addr;
+  section->as_offset = shdr.sh_offset;
+  section->as_size = shdr.sh_type == SHT_NOBITS ? 0 : shdr.sh_size;
+  section->as_link = shdr.sh_link;
+  section->as_info = shdr.sh_info;
+  section->as_addralign = shdr.sh_addralign;
+  section->as_entrysize = shdr.sh_entsize;
+  return DW_DLV_OK;
+}
+
+Dwarf_Small relf_dwarf_get_byte_order(void *obj)
+{
+  relf_struct *relf = (relf_struct *)obj;
+  return relf->elf_file_header.e_ident[EI_DATA] == ELFDATA2MSB ? DW_END_big : DW_END_little;
+}
+
+Dwarf_Small relf_dwarf_get_pointer_size(void *obj)
+{
+  relf_struct *relf = (relf_struct *)obj;
+  return relf->elf_file_header.e_ident[EI_CLASS] == ELFCLASS64 ? 8 : 4;
+}
+
+Dwarf_Unsigned relf_dwarf_get_filesize(void *obj)
+{
+  return ((relf_struct *)obj)->file_size;
+}
+
+Dwarf_Unsigned relf_dwarf_get_section_count(void *obj)
+{
+  return ((relf_struct *)obj)->section_header_total;
+}
+
+/* the data stays owned by libelf, it is released with relf_destroy() */
+int relf_dwarf_load_section(void *obj, Dwarf_Unsigned section_index, Dwarf_Small **data_ptr, int *error)
+{
+  relf_struct *relf = (relf_struct *)obj;
+  Elf_Scn *scn = elf_getscn(relf->elf, (size_t)section_index);
+  Elf_Data *data;
+  
+  if ( scn == NULL || relf_is_scn_data_allowed(relf, scn) == 0 )
+    return DW_DLV_NO_ENTRY;
+  data = elf_getdata(scn, NULL);
+  if ( data == NULL || data->d_buf == NULL )
+    return *error = DW_DLE_ELF_SECT_ERR, DW_DLV_ERROR;
+  *data_ptr = (Dwarf_Small *)data->d_buf;
+  return DW_DLV_OK;
+}
+
+const Dwarf_Obj_Access_Methods_a relf_dwarf_methods = 
+{
+  relf_dwarf_get_section_info,
+  relf_dwarf_get_byte_order,
+  relf_dwarf_get_pointer_size,          // length size: 4 or 8 like the class of the elf file
+  relf_dwarf_get_pointer_size,
+  relf_dwarf_get_filesize,
+  relf_dwarf_get_section_count,
+  relf_dwarf_load_section,
+  NULL                                  // no relocation, relocatable files are not mapped to compile units
+};
+
+/*==========================================*/
+/* address ranges */
+
+/* append the name of the compile unit at cu_die_offset to names, returns the position of the name or -1 */
+long relf_dwarf_add_cu_name(Dwarf_Debug dbg, Dwarf_Off cu_die_offset, char **names, size_t *names_len, size_t *names_max)
+{
+  Dwarf_Die die;
+  Dwarf_Error err = NULL;
+  char *name = NULL;
+  char *new_names;
+  size_t len;
+  long pos = -1;
+  int res;
+  
+  res = dwarf_offdie_b(dbg, cu_die_offset, /* is_info= */ 1, &die, &err);
+  if ( res == DW_DLV_ERROR )
+    dwarf_dealloc_error(dbg, err);
+  if ( res != DW_DLV_OK )
+    return -1;
+  res = dwarf_diename(die, &name, &err);
+  if ( res == DW_DLV_ERROR )
+    dwarf_dealloc_error(dbg, err);
+  if ( res == DW_DLV_OK && name != NULL )
+  {
+    len = strlen(name) + 1;
+    if ( *names_len + len > *names_max )
+    {
+      new_names = (char *)realloc(*names, *names_max*2 + len + 256);
+      if ( new_names != NULL )
+      {
+        *names = new_names;
+        *names_max = *names_max*2 + len + 256;
+      }
+    }
+    if ( *names_len + len <= *names_max )
+    {
+      memcpy(*names + *names_len, name, len);
+      pos = (long)*names_len;
+      *names_len += len;
+    }
+  }
+  dwarf_dealloc_die(die);
+  return pos;
+}
+
+/* 
+  read ".debug_aranges" with libdwarf, returns a malloc'd list of address ranges sorted by address or NULL
+  The names of the compile units are stored in the same memory block after the list, so free() of the list releases both.
+*/
+relf_arange_struct *relf_get_arange_list(relf_struct *relf, size_t *cnt)
+{
+  Dwarf_Obj_Access_Interface_a access;
+  Dwarf_Debug dbg = NULL;
+  Dwarf_Error err = NULL;
+  Dwarf_Arange *aranges = NULL;
+  Dwarf_Signed arange_cnt = 0, i;
+  Dwarf_Unsigned segment, segment_entry_size, len;
+  Dwarf_Addr addr;
+  Dwarf_Off cu_die_offset, last_offset = 0;
+  relf_arange_struct *list = NULL;
+  relf_arange_struct *new_list;
+  long *name_pos = NULL;
+  long last_pos = -1;
+  char *names = NULL;
+  size_t names_len = 0, names_max = 0;
+  int res;
+  
+  *cnt = 0;
+  access.ai_object = relf;
+  access.ai_methods = &relf_dwarf_methods;
+  res = dwarf_object_init_b(&access, NULL, NULL, DW_GROUPNUMBER_ANY, &dbg, &err);
+  if ( res == DW_DLV_ERROR )
+    dwarf_dealloc_error(NULL, err);
+  if ( res != DW_DLV_OK )
+    return NULL;
+  
+  res = dwarf_get_aranges(dbg, &aranges, &arange_cnt, &err);
+  if ( res == DW_DLV_ERROR )
+    dwarf_dealloc_error(dbg, err);
+  if ( res == DW_DLV_OK && arange_cnt > 0 )
+  {
+    list = (relf_arange_struct *)malloc((size_t)arange_cnt * sizeof(relf_arange_struct));
+    name_pos = (long *)malloc((size_t)arange_cnt * sizeof(long));
+    if ( list == NULL || name_pos == NULL )
+      fprintf(stderr, "relf_get_arange_list: out of memory\n");
+    for( i = 0; list != NULL && name_pos != NULL && i < arange_cnt; i++ )
+    {
+      res = dwarf_get_arange_info_b(aranges[i], &segment, &segment_entry_size, &addr, &len, &cu_die_offset, &err);
+      if ( res == DW_DLV_ERROR )
+        dwarf_dealloc_error(dbg, err);
+      if ( res != DW_DLV_OK || len == 0 || segment_entry_size != 0 )   // segment selectors are not supported
+        continue;
+      /* the ranges of a compile unit follow each other, so the name is read once per compile unit */
+      if ( *cnt == 0 || cu_die_offset != last_offset )
+        last_pos = relf_dwarf_add_cu_name(dbg, cu_die_offset, &names, &names_len, &names_max);
+      last_offset = cu_die_offset;
+      list[*cnt].addr = addr;
+      list[*cnt].end = addr + len;
+      list[*cnt].cu_name = NULL;
+      name_pos[*cnt] = last_pos;
+      (*cnt)++;
+    }
+    for( i = 0; i < arange_cnt; i++ )
+      dwarf_dealloc(dbg, aranges[i], DW_DLA_ARANGE);
+    dwarf_dealloc(dbg, aranges, DW_DLA_LIST);
+  }
+  dwarf_object_finish(dbg);
+  
+  /* move the list and the names into one memory block */
+  if ( list != NULL && name_pos != NULL && *cnt > 0 )
+  {
+    new_list = (relf_arange_struct *)realloc(list, *cnt * sizeof(relf_arange_struct) + names_len);
+    if ( new_list == NULL )
+    {
+      free(list);
+      list = NULL;
+      fprintf(stderr, "relf_get_arange_list: out of memory\n");
+    }
+    else
+    {
+      list = new_list;
+      if ( names_len > 0 )
+        memcpy((char *)(list + *cnt), names, names_len);
+      for( i = 0; (size_t)i < *cnt; i++ )
+        list[i].cu_name = name_pos[i] >= 0 ? (const char *)(list + *cnt) + name_pos[i] : RELF_CU_NAME_UNKNOWN;
+      qsort(list, *cnt, sizeof(relf_arange_struct), relf_cmp_arange);
+    }
+  }
+  else
+  {
+    free(list);
+    list = NULL;
+  }
+  if ( list == NULL )
+    *cnt = 0;
+  free(name_pos);
+  free(names);
+  return list;
+}
+
+/* returns the name of the compile unit, which contains addr */
+const char *relf_find_cu_name(relf_arange_struct *list, size_t cnt, unsigned long long addr)
+{
+  size_t lo = 0, hi = cnt, mid;
+  /* find the last range with list[].addr <= addr */
+  while( lo < hi )
+  {
+    mid = (lo + hi) / 2;
+    if ( list[mid].addr <= addr )
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if ( lo > 0 && addr < list[lo-1].end )
+    return list[lo-1].cu_name;
+  return RELF_CU_NAME_UNKNOWN;
+}
+
@@ -0,0 +1,51 @@
+/*
+
+  relfdwarf.h
+
+
+  Copyright (C) 2024  olikraus@gmail.com
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+  Compile unit names for addresses, based on ".debug_aranges" and DW_AT_name of 
+  the compile unit DIE. DWARF is decoded by libdwarf (see also elfdwarf.c). libdwarf 
+  reads the sections through the libelf object of relf_struct (dwarf_object_init_b()), 
+  so this also works for elf files, which are read from memory or stdin.
+
+*/
+
+#ifndef _RELFDWARF_H
+#define _RELFDWARF_H
+
+#include "relf.h"
+
+#define RELF_CU_NAME_UNKNOWN "<unknown>"
+
+/* address range of a compile unit from ".debug_aranges" */
+struct _relf_arange_struct
+{
+  unsigned long long addr;
+  unsigned long long end;
+  const char *cu_name;
+};
+typedef struct _relf_arange_struct relf_arange_struct;
+
+
+/* returns a malloc'd list of address ranges sorted by address or NULL, free() also releases the names */
+relf_arange_struct *relf_get_arange_list(relf_struct *relf, size_t *cnt);
+
+/* returns the name of the compile unit, which contains addr, or RELF_CU_NAME_UNKNOWN */
+const char *relf_find_cu_name(relf_arange_struct *list, size_t cnt, unsigned long long addr);
+
+#endif /* _RELFDWARF_H */
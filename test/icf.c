@@ -0,0 +1,7 @@
+static int s1(int a) { return a*7+3; }
+static int s2(int a) { return a*7+3; }
+__attribute__((weak)) int w1(int a) { return a*7+3; }
+int g1(int a) { return a*7+3; }
+int g1_alias(int a) __attribute__((alias("g1")));
+int (*tab[])(int) = { s1, s2 };
+int main(void) { return tab[0](1)+tab[1](2); }
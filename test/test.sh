@@ -0,0 +1,164 @@
+#!/bin/sh
+#
+#  test.sh
+#  regression tests for elf2json, elf2bin and elf2obj
+#  usage: sh test.sh [<bin dir>]    (default: ../src, called by "make test" in ../src)
+#
+#  The expected outputs (golden files) are stored next to the input files:
+#    file.json, file_d.json          elf2json file.elf, elf2json -d file.elf
+#    file_m.json                     elf2json -m 2K file.elf
+#    file_size.json                  elf2json -s file.elf
+#    test_elf32_mingw.json           elf2json test_elf32_mingw.o
+#    file.bin, file.hex, file.s37    objcopy -O binary|ihex|srec --srec-forceS3 file.elf file.<ext>
+#    file_obj.txt|json|csv           elf2obj [-f json|csv] file.elf
+#    icf_i.txt, icf_i.json           elf2obj -i [-f json] icf.o (icf.o: gcc -O1 -c icf.c)
+#  After an intended change of the output, the golden files are created again with these commands.
+#
+
+if [ -n "$1" ]; then BIN=$(cd "$1" && pwd) || exit 1; fi
+cd "$(dirname "$0")" || exit 1
+DIR=$(pwd)
+BIN=${BIN:-$(cd ../src && pwd)}
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+FAILED=0
+
+# check <name> <command...>: the command must succeed
+check()
+{
+  name=$1
+  shift
+  if "$@" > "$TMP/log" 2>&1; then
+    echo "ok   $name"
+  else
+    echo "FAIL $name"
+    cat "$TMP/log"
+    FAILED=$((FAILED+1))
+  fi
+}
+
+# fails <name> <command...>: the command must fail
+fails()
+{
+  name=$1
+  shift
+  if "$@" > "$TMP/log" 2>&1; then
+    echo "FAIL $name (no error)"
+    FAILED=$((FAILED+1))
+  else
+    echo "ok   $name"
+  fi
+}
+
+# golden <name> <golden file> <command...>: stdout of the command must be equal to the golden file
+# The names of "d_type" depend on the ELF_T_* constants of libelf.h, so these lines are not compared.
+# The exit code is not checked, because elf2json always returns default_return_value.
+golden()
+{
+  name=$1
+  file=$2
+  shift 2
+  "$@" 2> "$TMP/log" | grep -v '"d_type"' > "$TMP/out"
+  if grep -v '"d_type"' "$file" | cmp -s - "$TMP/out"; then
+    echo "ok   $name"
+  else
+    echo "FAIL $name (differs from $file)"
+    grep -v '"d_type"' "$file" | diff - "$TMP/out" | head -20
+    cat "$TMP/log"
+    FAILED=$((FAILED+1))
+  fi
+}
+
+# bin <name> <golden file> <elf2bin options...>: the output of elf2bin (written to the 
+# temporary directory with the name of the golden file, see S0 record) must be equal to the golden file
+bin()
+{
+  name=$1
+  file=$2
+  shift 2
+  if (cd "$TMP" && rm -f "$file" && "$BIN/elf2bin" "$@" "$DIR/file.elf" "$file") > "$TMP/log" 2>&1 && cmp "$TMP/$file" "$file" >> "$TMP/log" 2>&1; then
+    echo "ok   $name"
+  else
+    echo "FAIL $name (differs from $file)"
+    cat "$TMP/log"
+    FAILED=$((FAILED+1))
+  fi
+}
+
+#==========================================
+# elf2json
+
+golden "elf2json" file.json "$BIN/elf2json" file.elf
+golden "elf2json -d" file_d.json "$BIN/elf2json" -d file.elf
+golden "elf2json elf32" test_elf32_mingw.json "$BIN/elf2json" test_elf32_mingw.o
+for j in 2 4 7; do
+  golden "elf2json -j $j" file.json "$BIN/elf2json" -j $j file.elf
+  golden "elf2json -d -j $j" file_d.json "$BIN/elf2json" -d -j $j file.elf
+done
+
+# -m: the data is read in windows and written as raw bytes, -j must not change the result
+golden "elf2json -m 2K" file_m.json "$BIN/elf2json" -m 2K file.elf
+golden "elf2json -m 2K -j 4" file_m.json "$BIN/elf2json" -m 2K -j 4 file.elf
+"$BIN/elf2json" -m 1K file.elf > /dev/null 2> "$TMP/m.err"
+check "elf2json -m 1K limit" grep -q "more than the memory limit" "$TMP/m.err"
+
+golden "elf2json -s" file_size.json "$BIN/elf2json" -s file.elf
+
+#==========================================
+# elf2bin binary, ihex and S-records (the golden files are created by objcopy)
+
+bin "elf2bin binary" file.bin
+bin "elf2bin binary -j 1" file.bin -j 1
+bin "elf2bin binary -m" file.bin -m
+bin "elf2bin ihex" file.hex
+bin "elf2bin s37" file.s37 -O s37
+fails "elf2bin ihex -s" "$BIN/elf2bin" -s file.elf "$TMP/file_s.hex"
+
+#==========================================
+# elf2bin e2bz
+
+for j in 1 3; do
+  check "elf2bin e2bz -j $j" "$BIN/elf2bin" -j $j -O e2bz file.elf "$TMP/file$j.e2bz"
+done
+check "elf2bin e2bz -j 1 vs -j 3" cmp "$TMP/file1.e2bz" "$TMP/file3.e2bz"
+check "elf2bin -x" "$BIN/elf2bin" -x "$TMP/file3.e2bz" "$TMP/extract.bin"
+check "elf2bin e2bz round-trip" cmp "$TMP/extract.bin" file.bin
+cp "$TMP/file3.e2bz" "$TMP/bad.e2bz"
+printf 'XXXX' | dd of="$TMP/bad.e2bz" bs=1 seek=100 conv=notrunc 2> /dev/null
+fails "elf2bin -x corrupted" "$BIN/elf2bin" -x "$TMP/bad.e2bz" "$TMP/bad.bin"
+
+#==========================================
+# elf2bin delta
+
+# previous binary file: the new one with a few changed bytes and a shorter length
+"$BIN/elf2bin" file.elf "$TMP/new.bin" > /dev/null
+head -c 12000 "$TMP/new.bin" > "$TMP/old.bin"
+printf 'XXXXXXXX' | dd of="$TMP/old.bin" bs=1 seek=100 conv=notrunc 2> /dev/null
+
+for z in "" "-z"; do
+  check "elf2bin -d $z" "$BIN/elf2bin" -d "$TMP/old.bin" $z file.elf "$TMP/new.bin"
+  check "elf2bin -a $z" "$BIN/elf2bin" -a "$TMP/old.bin" "$TMP/new.bin.delta" "$TMP/applied.bin"
+  check "elf2bin -d $z round-trip" cmp "$TMP/new.bin" "$TMP/applied.bin"
+done
+check "elf2bin -d -c" "$BIN/elf2bin" -c main -d "$TMP/old.bin" file.elf "$TMP/new.bin"
+check "elf2bin -a -c" "$BIN/elf2bin" -a "$TMP/old.bin" "$TMP/new.bin.delta" "$TMP/applied.bin"
+check "elf2bin -d -c round-trip" cmp "$TMP/new.bin" "$TMP/applied.bin"
+fails "elf2bin -a wrong previous" "$BIN/elf2bin" -a "$TMP/new.bin" "$TMP/new.bin.delta" "$TMP/wrong.bin"
+
+#==========================================
+# elf2obj
+
+golden "elf2obj" file_obj.txt "$BIN/elf2obj" file.elf
+golden "elf2obj -f json" file_obj.json "$BIN/elf2obj" -f json file.elf
+golden "elf2obj -f csv" file_obj.csv "$BIN/elf2obj" -f csv file.elf
+golden "elf2obj -f csv -j 3" file_obj.csv "$BIN/elf2obj" -f csv -j 3 file.elf
+golden "elf2obj -i" icf_i.txt "$BIN/elf2obj" -i icf.o
+golden "elf2obj -i -f json" icf_i.json "$BIN/elf2obj" -i -f json icf.o
+
+#==========================================
+
+if [ $FAILED -ne 0 ]; then
+  echo "$FAILED test(s) failed"
+  exit 1
+fi
+echo "all tests passed"